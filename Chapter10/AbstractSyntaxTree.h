@@ -154,12 +154,16 @@ struct ForExpression : Tagged {
   Expression hi;
   Expression body;
   bool escapes;
+  // cleared by a precise EscapeAnalyser for variables never assigned
+  bool assigned = true;
 };
 
 struct Field {
   Identifier name;
   Identifier type;
   bool escapes;
+  // cleared by a precise EscapeAnalyser for parameters never assigned
+  bool assigned = true;
 };
 
 using Fields = std::vector<Field>;
@@ -169,6 +173,8 @@ struct FunctionDeclaration {
   Fields params;
   boost::optional<Identifier> result;
   Expression body;
+  // cleared by StaticLinkAnalyser for functions not using enclosing frames
+  bool staticLink = true;
 };
 
 using FunctionDeclarations = std::vector<FunctionDeclaration>;
@@ -178,6 +184,8 @@ struct VarDeclaration {
   boost::optional<Identifier> type;
   Expression init;
   bool escapes;
+  // cleared by a precise EscapeAnalyser for variables never assigned
+  bool assigned = true;
 };
 
 struct NameType {
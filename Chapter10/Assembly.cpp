@@ -14,24 +14,30 @@ MSC_DIAG_OFF(4459)
 MSC_DIAG_ON()
 #include <gsl/span>
 #include <range/v3/algorithm/for_each.hpp>
-MSC_DIAG_OFF(4702)
-#include <range/v3/view/concat.hpp>
-MSC_DIAG_ON()
-#include <range/v3/view/single.hpp>
 #include <range/v3/view/transform.hpp>
 
 namespace tiger {
 
 namespace assembly {
 
-static auto parse = [](const std::string &syntax, auto &&onLabel,
-                       auto &&onDestination, auto &&onSource,
-                       auto &&onImmediate, auto &&onOther) {
+Syntax::Syntax(const std::string &syntax) {
   namespace x3 = boost::spirit::x3;
 
-  auto const callOnOperand = [](auto &&onOperand) {
-    return [&](auto &ctx) { onOperand(_attr(ctx)); };
+  Segments segments;
+  auto const onOperand = [&segments](SegmentType type) {
+    return [&segments, type](auto &ctx) {
+      segments.push_back(Segment{type, {}, _attr(ctx)});
+    };
+  };
+  auto const appendText = [&segments](char c) {
+    if (segments.empty() || segments.back().m_type != SegmentType::TEXT) {
+      segments.push_back(Segment{SegmentType::TEXT, {}, 0});
+    }
+    segments.back().m_text.push_back(c);
   };
+  auto const onBacktick = [&appendText](auto & /* ctx */) { appendText('`'); };
+  auto const onText     = [&appendText](auto &ctx) { appendText(_attr(ctx)); };
+
   auto it = std::begin(syntax);
 #ifndef NDEBUG
   auto succeeded =
@@ -41,78 +47,130 @@ static auto parse = [](const std::string &syntax, auto &&onLabel,
       //  Begin grammar
       // clang-format off
       *(
-          (x3::lit("`s") > x3::uint_[callOnOperand(std::forward<decltype(onSource)>(onSource))])
-        | (x3::lit("`d") > x3::uint_[callOnOperand(std::forward<decltype(onDestination)>(onDestination))])
-        | (x3::lit("`l") > x3::uint_[callOnOperand(std::forward<decltype(onLabel)>(onLabel))])
-        | (x3::lit("`i") > x3::uint_[callOnOperand(std::forward<decltype(onImmediate)>(onImmediate))])
-        | ((x3::lit("``") > x3::attr('`')) | (x3::char_ - '`'))[callOnOperand(std::forward<decltype(onOther)>(onOther))]
+          (x3::lit("`s") > x3::uint_[onOperand(SegmentType::SOURCE)])
+        | (x3::lit("`d") > x3::uint_[onOperand(SegmentType::DESTINATION)])
+        | (x3::lit("`l") > x3::uint_[onOperand(SegmentType::LABEL)])
+        | (x3::lit("`i") > x3::uint_[onOperand(SegmentType::IMMEDIATE)])
+        | x3::lit("``")[onBacktick]
+        | (x3::char_ - '`')[onText]
       )
       // clang-format on
       //  End grammar
     );
 
   assert((succeeded & it == std::end(syntax)) && "Failed to parse instruction");
-};
 
-void Instruction::print(std::ostream &out, const temp::Map &tempMap) const {
-  auto const writeRegister = [&out,
-                              &tempMap](const temp::Registers &registers) {
-    return [&](size_t index) { out << *tempMap.lookup(registers[index]); };
-  };
-
-  auto const writeLabel = [&out](auto &&labels) {
-    return [&](size_t index) { out << labels[index]; };
-  };
-
-  auto const writeImmediate = [&out](const Immediates &immediates) {
-    return [&](size_t index) { out << immediates[index]; };
-  };
+  m_segments = std::make_shared<const Segments>(std::move(segments));
+}
 
-  auto const writeOther = [&](auto other) { out << other; };
+Syntax::Syntax(const char *syntax) : Syntax(std::string{syntax}) {}
 
-  auto const noop = [](size_t) { assert(false && "should not get here"); };
+const Syntax::Segments &Syntax::segments() const {
+  static const Segments empty;
+  return m_segments ? *m_segments : empty;
+}
 
-  namespace rv = ranges::view;
+std::string Syntax::str() const {
+  std::string res;
+  for (const auto &segment : segments()) {
+    switch (segment.m_type) {
+      case SegmentType::TEXT:
+        for (auto c : segment.m_text) {
+          res += c == '`' ? "``" : std::string(1, c);
+        }
+        break;
+      case SegmentType::SOURCE:
+        res += "`s" + std::to_string(segment.m_index);
+        break;
+      case SegmentType::DESTINATION:
+        res += "`d" + std::to_string(segment.m_index);
+        break;
+      case SegmentType::LABEL:
+        res += "`l" + std::to_string(segment.m_index);
+        break;
+      case SegmentType::IMMEDIATE:
+        res += "`i" + std::to_string(segment.m_index);
+        break;
+    }
+  }
+  return res;
+}
 
+void Instruction::print(std::ostream &out, const temp::Map &tempMap) const {
   helpers::match (*this)(
     [&](const Label &label) {
-      parse(label.m_syntax, writeLabel(rv::single(label.m_label)), noop, noop,
-            noop, writeOther);
+      for (const auto &segment : label.m_syntax.segments()) {
+        if (segment.m_type == Syntax::SegmentType::TEXT) {
+          out << segment.m_text;
+        } else {
+          assert(segment.m_type == Syntax::SegmentType::LABEL
+                 && segment.m_index == 0 && "Labels have a single operand");
+          out << label.m_label;
+        }
+      }
     },
     [&](const auto &inst) {
-      parse(inst.m_syntax, writeLabel(inst.m_labels),
-            writeRegister(inst.m_destinations), writeRegister(inst.m_sources),
-            writeImmediate(inst.m_immediates), writeOther);
+      for (const auto &segment : inst.m_syntax.segments()) {
+        switch (segment.m_type) {
+          case Syntax::SegmentType::TEXT:
+            out << segment.m_text;
+            break;
+          case Syntax::SegmentType::SOURCE:
+            out << *tempMap.lookup(inst.m_sources[segment.m_index]);
+            break;
+          case Syntax::SegmentType::DESTINATION:
+            out << *tempMap.lookup(inst.m_destinations[segment.m_index]);
+            break;
+          case Syntax::SegmentType::LABEL:
+            out << inst.m_labels[segment.m_index];
+            break;
+          case Syntax::SegmentType::IMMEDIATE:
+            out << inst.m_immediates[segment.m_index];
+            break;
+        }
+      }
     });
 }
 
 Instruction Instruction::create(const InstructionType type,
-                                const std::string &syntax,
-                                const Operands &operands,
+                                const Syntax &syntax, const Operands &operands,
                                 const Operands &implicitDestinations,
                                 const Operands &implicitSources) {
-  size_t operandIndex = 0;
-  auto setOperand     = [&](auto &toOperands) {
-    return [&](size_t) {
-      assert(operandIndex < operands.size() && "missing operands");
-      using operand_type =
-        typename std::decay_t<decltype(toOperands)>::value_type;
-      assert(helpers::hasType<operand_type>(operands[operandIndex])
-             && "operand's type mismatch");
-      toOperands.push_back(boost::get<operand_type>(operands[operandIndex++]));
-    };
+  size_t operandIndex   = 0;
+  auto const setOperand = [&](auto &toOperands) {
+    assert(operandIndex < operands.size() && "missing operands");
+    using operand_type =
+      typename std::decay_t<decltype(toOperands)>::value_type;
+    assert(helpers::hasType<operand_type>(operands[operandIndex])
+           && "operand's type mismatch");
+    toOperands.push_back(boost::get<operand_type>(operands[operandIndex++]));
   };
 
-  auto const noop = [](auto) {};
-
   auto const fillInstruction = [&](auto &inst) {
-    parse(inst.m_syntax, setOperand(inst.m_labels),
-          setOperand(inst.m_destinations), setOperand(inst.m_sources),
-          setOperand(inst.m_immediates), noop);
+    for (const auto &segment : inst.m_syntax.segments()) {
+      switch (segment.m_type) {
+        case Syntax::SegmentType::TEXT:
+          break;
+        case Syntax::SegmentType::SOURCE:
+          setOperand(inst.m_sources);
+          break;
+        case Syntax::SegmentType::DESTINATION:
+          setOperand(inst.m_destinations);
+          break;
+        case Syntax::SegmentType::LABEL:
+          setOperand(inst.m_labels);
+          break;
+        case Syntax::SegmentType::IMMEDIATE:
+          setOperand(inst.m_immediates);
+          break;
+      }
+    }
     auto const toRegisters = ranges::view::transform(
       [](const Operand &op) { return boost::get<temp::Register>(op); });
-    inst.m_implicitDestinations = implicitDestinations | toRegisters;
-    inst.m_implicitSources      = implicitSources | toRegisters;
+    ranges::copy(implicitDestinations | toRegisters,
+                 ranges::back_inserter(inst.m_implicitDestinations));
+    ranges::copy(implicitSources | toRegisters,
+                 ranges::back_inserter(inst.m_implicitSources));
     ranges::for_each(operands.begin() + operandIndex, operands.end(),
                      [&inst](const Operand &operand) {
                        helpers::match(operand)(
@@ -151,20 +209,21 @@ Instruction Instruction::create(const InstructionType type,
   }
 }
 
-temp::Registers Instruction::destinations() const {
+RegisterView Instruction::destinations() const {
+  static const RegisterList none;
   return helpers::match(*this)(
-    [](const Label &) -> temp::Registers { return {}; },
-    [](const auto &inst) -> temp::Registers {
-      return ranges::view::concat(inst.m_destinations,
-                                  inst.m_implicitDestinations);
+    [](const Label &) { return boost::join(none, none); },
+    [](const auto &inst) {
+      return boost::join(inst.m_destinations, inst.m_implicitDestinations);
     });
 }
 
-temp::Registers Instruction::sources() const {
+RegisterView Instruction::sources() const {
+  static const RegisterList none;
   return helpers::match(*this)(
-    [](const Label &) -> temp::Registers { return {}; },
-    [](const auto &inst) -> temp::Registers {
-      return ranges::view::concat(inst.m_sources, inst.m_implicitSources);
+    [](const Label &) { return boost::join(none, none); },
+    [](const auto &inst) {
+      return boost::join(inst.m_sources, inst.m_implicitSources);
     });
 }
 
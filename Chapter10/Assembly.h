@@ -1,8 +1,11 @@
 #pragma once
 #include "TempMap.h"
+#include <boost/container/small_vector.hpp>
+#include <boost/range/join.hpp>
 #include <boost/variant.hpp>
 #include <gsl/span>
 #include <gsl/string_span>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -10,22 +13,60 @@
 namespace tiger {
 
 namespace assembly {
-using Immediates = std::vector<int>;
+// most instructions have no more than a couple of operands of each kind, which
+// are kept inline
+using RegisterList = boost::container::small_vector<temp::Register, 2>;
+using LabelList    = boost::container::small_vector<temp::Label, 1>;
+using Immediates   = boost::container::small_vector<int, 2>;
+
+// the explicit registers of an instruction followed by the implicit ones
+using RegisterView =
+  boost::range::joined_range<const RegisterList, const RegisterList>;
 
 enum class InstructionType { OPERATION, JUMP, MOVE, LABEL };
 
+// the syntax of an instruction, where `s, `d, `l and `i followed by an index
+// stand for sources, destinations, labels and immediates and `` for a literal
+// backtick. it is parsed once into segments shared by all of its copies
+class Syntax {
+public:
+  enum class SegmentType { TEXT, SOURCE, DESTINATION, LABEL, IMMEDIATE };
+
+  struct Segment {
+    SegmentType m_type;
+    // literal text of a TEXT segment
+    std::string m_text;
+    // operand index of any other segment
+    size_t m_index;
+  };
+
+  using Segments = std::vector<Segment>;
+
+  Syntax() = default;
+  Syntax(const std::string &syntax);
+  Syntax(const char *syntax);
+
+  const Segments &segments() const;
+
+  // the syntax as written, with operand placeholders
+  std::string str() const;
+
+private:
+  std::shared_ptr<const Segments> m_segments;
+};
+
 template <InstructionType> struct InstructionBase {
-  std::string m_syntax;
-  temp::Registers m_destinations;
-  temp::Registers m_sources;
-  temp::Labels m_labels;
+  Syntax m_syntax;
+  RegisterList m_destinations;
+  RegisterList m_sources;
+  LabelList m_labels;
   Immediates m_immediates;
-  temp::Registers m_implicitDestinations;
-  temp::Registers m_implicitSources;
+  RegisterList m_implicitDestinations;
+  RegisterList m_implicitSources;
 };
 
 template <> struct InstructionBase<InstructionType::LABEL> {
-  std::string m_syntax;
+  Syntax m_syntax;
   temp::Label m_label;
 };
 
@@ -45,13 +86,14 @@ public:
 
   void print(std::ostream &out, const temp::Map &tempMap) const;
 
-  static Instruction create(const InstructionType type,
-                            const std::string &syntax, const Operands &operands,
+  static Instruction create(const InstructionType type, const Syntax &syntax,
+                            const Operands &operands,
                             const Operands &implicitDestinations,
                             const Operands &implicitSources);
 
-  temp::Registers destinations() const;
-  temp::Registers sources() const;
+  // views into the instruction, valid as long as it isn't changed
+  RegisterView destinations() const;
+  RegisterView sources() const;
   bool isMove() const;
 };
 
@@ -0,0 +1,425 @@
+#include "Bytecode.h"
+#include "CallingConvention.h"
+#include "variantMatch.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace tiger {
+namespace bytecode {
+
+size_t operands(Opcode opcode) {
+  switch (opcode) {
+    case Opcode::RETURN:
+      return 0;
+    case Opcode::JUMP:
+    case Opcode::TAIL_CALL:
+      return 1;
+    case Opcode::CONST:
+    case Opcode::STRING:
+    case Opcode::MOVE:
+      return 2;
+    default:
+      return 3;
+  }
+}
+
+namespace {
+const std::unordered_map<std::string, RuntimeFunction> &runtimeFunctions() {
+  static const std::unordered_map<std::string, RuntimeFunction> functions{
+    {"malloc", RuntimeFunction::MALLOC},
+    {"initArray", RuntimeFunction::INIT_ARRAY},
+    {"allocRecord", RuntimeFunction::ALLOC_RECORD},
+    {"allocArray", RuntimeFunction::ALLOC_ARRAY},
+    {"stringCompare", RuntimeFunction::STRING_COMPARE},
+    {"print", RuntimeFunction::PRINT},
+    {"flush", RuntimeFunction::FLUSH},
+    {"getchar", RuntimeFunction::GETCHAR},
+    {"ord", RuntimeFunction::ORD},
+    {"chr", RuntimeFunction::CHR},
+    {"size", RuntimeFunction::SIZE},
+    {"substring", RuntimeFunction::SUBSTRING},
+    {"concat", RuntimeFunction::CONCAT},
+    {"not", RuntimeFunction::NOT},
+    {"exit", RuntimeFunction::EXIT}};
+  return functions;
+}
+
+Opcode binaryOpcode(ir::BinOp op) {
+  switch (op) {
+    case ir::BinOp::PLUS:
+      return Opcode::ADD;
+    case ir::BinOp::MINUS:
+      return Opcode::SUB;
+    case ir::BinOp::MUL:
+      return Opcode::MUL;
+    case ir::BinOp::DIV:
+      return Opcode::DIV;
+    case ir::BinOp::AND:
+      return Opcode::AND;
+    case ir::BinOp::OR:
+      return Opcode::OR;
+    case ir::BinOp::LSHIFT:
+      return Opcode::SHL;
+    case ir::BinOp::RSHIFT:
+      return Opcode::SHR;
+    case ir::BinOp::ARSHIFT:
+      return Opcode::SAR;
+    case ir::BinOp::XOR:
+      return Opcode::XOR;
+  }
+  throw std::logic_error{"Unknown binary operation"};
+}
+
+Opcode jumpOpcode(ir::RelOp op) {
+  switch (op) {
+    case ir::RelOp::EQ:
+      return Opcode::JEQ;
+    case ir::RelOp::NE:
+      return Opcode::JNE;
+    case ir::RelOp::LT:
+      return Opcode::JLT;
+    case ir::RelOp::GT:
+      return Opcode::JGT;
+    case ir::RelOp::LE:
+      return Opcode::JLE;
+    case ir::RelOp::GE:
+      return Opcode::JGE;
+    case ir::RelOp::ULT:
+      return Opcode::JULT;
+    case ir::RelOp::ULE:
+      return Opcode::JULE;
+    case ir::RelOp::UGT:
+      return Opcode::JUGT;
+    case ir::RelOp::UGE:
+      return Opcode::JUGE;
+  }
+  throw std::logic_error{"Unknown relation"};
+}
+} // namespace
+
+Compiler::Compiler(const frame::CallingConvention &callingConvention) :
+    m_callingConvention{callingConvention} {
+  if (m_callingConvention.wordSize() != sizeof(Runtime::Word)) {
+    throw std::logic_error{"Bytecode needs IR with 64 bit words"};
+  }
+  m_program.m_argumentRegisters =
+    m_callingConvention.argumentRegisters().size();
+}
+
+void Compiler::addFunction(ir::Statements statements) {
+  auto const name = boost::get<temp::Label>(&statements.front());
+  if (!name) {
+    throw std::logic_error{"A function must start with its label"};
+  }
+
+  m_registers = {{m_callingConvention.framePointer(), FRAME_POINTER},
+                 {m_callingConvention.stackPointer(), STACK_POINTER},
+                 {m_callingConvention.returnValue(), RETURN_VALUE}};
+  auto const &argumentRegisters = m_callingConvention.argumentRegisters();
+  for (size_t i = 0; i < argumentRegisters.size(); ++i) {
+    m_registers.emplace(argumentRegisters[i],
+                        FIRST_ARGUMENT + static_cast<Slot>(i));
+  }
+  m_registerCount = FIRST_ARGUMENT + static_cast<Slot>(argumentRegisters.size());
+  m_lowestOffset  = 0;
+  for (const auto &statement : statements) {
+    helpers::match(statement)(
+      [this](const ir::Jump &jump) { collect(jump.exp); },
+      [this](const ir::ConditionalJump &cjump) {
+        collect(cjump.left);
+        collect(cjump.right);
+      },
+      [this](const ir::Move &move) {
+        collect(move.src);
+        collect(move.dst);
+      },
+      [this](const ir::ExpressionStatement &expressionStatement) {
+        collect(expressionStatement.exp);
+      },
+      [](const auto & /* default */) {});
+  }
+
+  m_functions.emplace(*name, m_program.m_functions.size());
+  m_program.m_functions.push_back(
+    Function{m_program.m_code.size(), 0, static_cast<size_t>(m_registerCount)});
+  auto maxRegisters = m_registerCount;
+  for (size_t i = 0; i < statements.size(); ++i) {
+    // scratch registers only live during a statement
+    m_scratch = m_registerCount;
+    compile(statements[i], i + 1 < statements.size() ? &statements[i + 1]
+                                                     : nullptr);
+    maxRegisters = std::max(maxRegisters, m_scratch);
+  }
+  emit(Opcode::RETURN, {});
+
+  auto &function       = m_program.m_functions.back();
+  function.m_registers = static_cast<size_t>(maxRegisters);
+  function.m_locals    = static_cast<size_t>(-m_lowestOffset)
+                      / static_cast<size_t>(m_callingConvention.wordSize());
+}
+
+void Compiler::addString(const StringFragment &string) {
+  m_strings.emplace(string.m_label, m_program.m_constants.size());
+  m_program.m_constants.push_back(string.m_string);
+}
+
+Program Compiler::finish() {
+  auto const main = m_functions.find(temp::Label{"main"});
+  if (main == m_functions.end()) {
+    throw std::logic_error{"The program has no main function"};
+  }
+  m_program.m_main = main->second;
+
+  for (const auto &jump : m_jumps) {
+    auto const target = m_labels.find(jump.second);
+    if (target == m_labels.end()) {
+      throw std::logic_error{"Jump to an unknown label " + jump.second.get()};
+    }
+    m_program.m_code[jump.first] = static_cast<Slot>(target->second);
+  }
+
+  for (const auto &call : m_calls) {
+    auto &opcode      = m_program.m_code[call.first];
+    auto &operand     = m_program.m_code[call.first + 1];
+    auto const isJump = opcode == static_cast<Slot>(Opcode::JUMP);
+    auto const function = m_functions.find(call.second);
+    if (function != m_functions.end()) {
+      opcode  = static_cast<Slot>(isJump ? Opcode::TAIL_CALL : Opcode::CALL);
+      operand = static_cast<Slot>(function->second);
+      continue;
+    }
+
+    if (isJump) {
+      auto const target = m_labels.find(call.second);
+      if (target == m_labels.end()) {
+        throw std::logic_error{"Jump to an unknown label "
+                               + call.second.get()};
+      }
+      operand = static_cast<Slot>(target->second);
+      continue;
+    }
+
+    auto const runtimeFunction = runtimeFunctions().find(call.second.get());
+    if (runtimeFunction == runtimeFunctions().end()) {
+      throw std::logic_error{"Call to an unknown function "
+                             + call.second.get()};
+    }
+    opcode  = static_cast<Slot>(Opcode::CALL_RUNTIME);
+    operand = static_cast<Slot>(runtimeFunction->second);
+  }
+
+  for (const auto &stringLoad : m_stringLoads) {
+    auto const string = m_strings.find(stringLoad.second);
+    if (string == m_strings.end()) {
+      throw std::logic_error{"Only the addresses of strings are known, not "
+                             + stringLoad.second.get()};
+    }
+    m_program.m_code[stringLoad.first] = static_cast<Slot>(string->second);
+  }
+
+  m_jumps.clear();
+  m_calls.clear();
+  m_stringLoads.clear();
+  return std::move(m_program);
+}
+
+void Compiler::compile(const ir::Statement &statement,
+                       const ir::Statement *next) {
+  helpers::match(statement)(
+    [this](const temp::Label &label) {
+      m_labels.emplace(label, m_program.m_code.size());
+    },
+    [this](const ir::Jump &jump) {
+      auto const label = boost::get<temp::Label>(&jump.exp);
+      if (!label) {
+        throw std::logic_error{"Only jumps to labels can be compiled"};
+      }
+      // the label may be another function, which is a tail call
+      m_calls.emplace_back(m_program.m_code.size(), *label);
+      emit(Opcode::JUMP, {0});
+    },
+    [this, next](const ir::ConditionalJump &cjump) {
+      auto const left  = value(cjump.left);
+      auto const right = value(cjump.right);
+      emit(jumpOpcode(cjump.op), {left, right});
+      emitLabel(*cjump.trueDest);
+      // the false label usually follows
+      auto const nextLabel = next ? boost::get<temp::Label>(next) : nullptr;
+      if (!nextLabel || *nextLabel != *cjump.falseDest) {
+        emit(Opcode::JUMP, {});
+        emitLabel(*cjump.falseDest);
+      }
+    },
+    [this](const ir::Move &move) {
+      if (auto const call = boost::get<ir::Call>(&move.src)) {
+        auto const result = boost::get<temp::Register>(&move.dst);
+        if (!result) {
+          throw std::logic_error{
+            "The result of a call must be moved to a register"};
+        }
+        compileCall(*call, reg(*result));
+        return;
+      }
+      helpers::match(move.dst)(
+        [&](const temp::Register &destination) {
+          compileInto(move.src, reg(destination));
+        },
+        [&](const ir::MemoryAccess &memoryAccess) {
+          auto const destination = address(memoryAccess.address);
+          auto const source      = value(move.src);
+          emit(Opcode::STORE,
+               {destination.first, destination.second, source});
+        },
+        [](const auto & /* default */) {
+          throw std::logic_error{"Only registers and memory can be assigned"};
+        });
+    },
+    [this](const ir::ExpressionStatement &expressionStatement) {
+      if (auto const call = boost::get<ir::Call>(&expressionStatement.exp)) {
+        compileCall(*call, -1);
+        return;
+      }
+      value(expressionStatement.exp);
+    },
+    [](const auto & /* default */) {
+      throw std::logic_error{"Only canonical IR can be compiled"};
+    });
+}
+
+void Compiler::compileCall(const ir::Call &call, Slot result) {
+  auto const label = boost::get<temp::Label>(&call.fun);
+  if (!label) {
+    throw std::logic_error{"Only calls to labels can be compiled"};
+  }
+
+  std::vector<Slot> arguments;
+  arguments.reserve(call.args.size());
+  for (const auto &argument : call.args) {
+    arguments.push_back(value(argument));
+  }
+  // the label may be a function or the runtime
+  m_calls.emplace_back(m_program.m_code.size(), *label);
+  emit(Opcode::CALL, {0, result, static_cast<Slot>(arguments.size())});
+  m_program.m_code.insert(m_program.m_code.end(), arguments.begin(),
+                          arguments.end());
+}
+
+Compiler::Slot Compiler::value(const ir::Expression &expression) {
+  if (auto const r = boost::get<temp::Register>(&expression)) {
+    return reg(*r);
+  }
+  auto const destination = m_scratch++;
+  compileInto(expression, destination);
+  return destination;
+}
+
+void Compiler::compileInto(const ir::Expression &expression,
+                           Slot destination) {
+  helpers::match(expression)(
+    [&](int value) { emit(Opcode::CONST, {destination, value}); },
+    [&](const temp::Label &label) {
+      emit(Opcode::STRING, {destination});
+      m_stringLoads.emplace_back(m_program.m_code.size(), label);
+      m_program.m_code.push_back(0);
+    },
+    [&](const temp::Register &source) {
+      if (reg(source) != destination) {
+        emit(Opcode::MOVE, {destination, reg(source)});
+      }
+    },
+    [&](const ir::BinaryOperation &binaryOperation) {
+      auto const left  = boost::get<int>(&binaryOperation.left);
+      auto const right = boost::get<int>(&binaryOperation.right);
+      if (binaryOperation.op == ir::BinOp::PLUS && right) {
+        emit(Opcode::ADDI, {destination, value(binaryOperation.left), *right});
+      } else if (binaryOperation.op == ir::BinOp::PLUS && left) {
+        emit(Opcode::ADDI, {destination, value(binaryOperation.right), *left});
+      } else if (binaryOperation.op == ir::BinOp::MINUS && right) {
+        emit(Opcode::ADDI,
+             {destination, value(binaryOperation.left), -Slot{*right}});
+      } else {
+        auto const leftValue  = value(binaryOperation.left);
+        auto const rightValue = value(binaryOperation.right);
+        emit(binaryOpcode(binaryOperation.op),
+             {destination, leftValue, rightValue});
+      }
+    },
+    [&](const ir::MemoryAccess &memoryAccess) {
+      auto const source = address(memoryAccess.address);
+      emit(Opcode::LOAD, {destination, source.first, source.second});
+    },
+    [](const auto & /* default */) {
+      throw std::logic_error{"Only canonical IR can be compiled"};
+    });
+}
+
+std::pair<Compiler::Slot, Compiler::Slot>
+  Compiler::address(const ir::Expression &expression) {
+  if (auto const binaryOperation =
+        boost::get<ir::BinaryOperation>(&expression)) {
+    auto const left  = boost::get<int>(&binaryOperation->left);
+    auto const right = boost::get<int>(&binaryOperation->right);
+    if (binaryOperation->op == ir::BinOp::PLUS && right) {
+      return {value(binaryOperation->left), *right};
+    }
+    if (binaryOperation->op == ir::BinOp::PLUS && left) {
+      return {value(binaryOperation->right), *left};
+    }
+    if (binaryOperation->op == ir::BinOp::MINUS && right) {
+      return {value(binaryOperation->left), -Slot{*right}};
+    }
+  }
+  return {value(expression), 0};
+}
+
+Compiler::Slot Compiler::reg(const temp::Register &reg) {
+  return m_registers.at(reg);
+}
+
+void Compiler::collect(const ir::Expression &expression) {
+  helpers::match(expression)(
+    [this](const temp::Register &reg) {
+      if (m_registers.emplace(reg, m_registerCount).second) {
+        ++m_registerCount;
+      }
+    },
+    [this](const ir::BinaryOperation &binaryOperation) {
+      // locals are addressed by offsets from the frame pointer
+      auto const framePointer = m_callingConvention.framePointer();
+      auto const offset       = [&]() -> boost::optional<int> {
+        auto const left  = boost::get<temp::Register>(&binaryOperation.left);
+        auto const right = boost::get<int>(&binaryOperation.right);
+        if (left && *left == framePointer && right) {
+          return binaryOperation.op == ir::BinOp::MINUS ? -*right : *right;
+        }
+        return boost::none;
+      }();
+      if (offset) {
+        m_lowestOffset = std::min(m_lowestOffset, *offset);
+      }
+      collect(binaryOperation.left);
+      collect(binaryOperation.right);
+    },
+    [this](const ir::MemoryAccess &memoryAccess) {
+      collect(memoryAccess.address);
+    },
+    [this](const ir::Call &call) {
+      for (const auto &argument : call.args) {
+        collect(argument);
+      }
+    },
+    [](const auto & /* default */) {});
+}
+
+void Compiler::emit(Opcode opcode, std::initializer_list<Slot> operands) {
+  m_program.m_code.push_back(static_cast<Slot>(opcode));
+  m_program.m_code.insert(m_program.m_code.end(), operands);
+}
+
+void Compiler::emitLabel(const temp::Label &label) {
+  m_jumps.emplace_back(m_program.m_code.size(), label);
+  m_program.m_code.push_back(0);
+}
+
+} // namespace bytecode
+} // namespace tiger
@@ -0,0 +1,174 @@
+#pragma once
+#include "Fragment.h"
+#include "Runtime.h"
+#include <deque>
+#include <unordered_map>
+
+namespace tiger {
+
+namespace frame {
+class CallingConvention;
+}
+
+namespace bytecode {
+
+// every instruction is an opcode followed by its operands. registers are
+// indices into the registers of the running function
+enum class Opcode : std::int64_t {
+  // register, value
+  CONST,
+  // register, index of the string in the constant pool
+  STRING,
+  // destination, source
+  MOVE,
+  // destination, left, right
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  AND,
+  OR,
+  SHL,
+  SHR,
+  SAR,
+  XOR,
+  // destination, source, value
+  ADDI,
+  // destination, base, offset
+  LOAD,
+  // base, offset, source
+  STORE,
+  // target
+  JUMP,
+  // left, right, target
+  JEQ,
+  JNE,
+  JLT,
+  JGT,
+  JLE,
+  JGE,
+  JULT,
+  JULE,
+  JUGT,
+  JUGE,
+  // function, result register or -1, argument count, argument registers
+  CALL,
+  CALL_RUNTIME,
+  // function, which gets the argument registers
+  TAIL_CALL,
+  RETURN,
+  OPCODES
+};
+
+// the number of operands following the opcode, not counting the arguments of
+// calls
+size_t operands(Opcode opcode);
+
+enum class RuntimeFunction : std::int64_t {
+  MALLOC,
+  INIT_ARRAY,
+  ALLOC_RECORD,
+  ALLOC_ARRAY,
+  STRING_COMPARE,
+  PRINT,
+  FLUSH,
+  GETCHAR,
+  ORD,
+  CHR,
+  SIZE,
+  SUBSTRING,
+  CONCAT,
+  NOT,
+  EXIT
+};
+
+// the registers every function has at the same indices. the argument
+// registers of the calling convention follow them
+enum FixedRegister : std::int64_t {
+  FRAME_POINTER,
+  STACK_POINTER,
+  RETURN_VALUE,
+  FIRST_ARGUMENT
+};
+
+struct Function {
+  size_t m_entry;
+  // words below the frame pointer
+  size_t m_locals;
+  size_t m_registers;
+};
+
+// a frame holds the function's locals below the frame pointer, the arguments
+// of the call above it, where the stack pointer reads them, and then the
+// registers. static links are frame pointers, as in the IR
+struct Program {
+  std::vector<std::int64_t> m_code;
+  std::vector<Function> m_functions;
+  std::deque<std::string> m_constants;
+  size_t m_main;
+  size_t m_argumentRegisters;
+};
+
+// compiles the canonical IR of a program to bytecode. values are 64 bit, so
+// the IR must be translated for a machine with 64 bit words
+class Compiler {
+public:
+  explicit Compiler(const frame::CallingConvention &callingConvention);
+
+  // the canonical statements of a function, starting with its label
+  void addFunction(ir::Statements statements);
+
+  void addString(const StringFragment &string);
+
+  // resolves the labels, once all the fragments are added
+  Program finish();
+
+private:
+  using Slot = std::int64_t;
+
+  void compile(const ir::Statement &statement, const ir::Statement *next);
+
+  void compileCall(const ir::Call &call, Slot result);
+
+  // evaluates expression into a register, which is new unless expression is
+  // a register
+  Slot value(const ir::Expression &expression);
+
+  void compileInto(const ir::Expression &expression, Slot destination);
+
+  // splits a memory address into a register and an offset
+  std::pair<Slot, Slot> address(const ir::Expression &expression);
+
+  Slot reg(const temp::Register &reg);
+
+  // walks expression, numbering the registers and finding the lowest frame
+  // offset it uses
+  void collect(const ir::Expression &expression);
+
+  void emit(Opcode opcode, std::initializer_list<Slot> operands);
+
+  // a slot patched with the code offset of label
+  void emitLabel(const temp::Label &label);
+
+  const frame::CallingConvention &m_callingConvention;
+  Program m_program;
+  std::unordered_map<temp::Label, size_t> m_strings;
+  std::unordered_map<temp::Label, size_t> m_labels;
+  std::unordered_map<temp::Label, size_t> m_functions;
+  // slots to be patched with the code offset of a label
+  std::vector<std::pair<size_t, temp::Label>> m_jumps;
+  // calls and jumps to a label which may be a function or the runtime, by the
+  // position of their opcode
+  std::vector<std::pair<size_t, temp::Label>> m_calls;
+  // slots to be patched with the index of a string in the constant pool
+  std::vector<std::pair<size_t, temp::Label>> m_stringLoads;
+
+  // the function being compiled
+  std::unordered_map<temp::Register, Slot> m_registers;
+  Slot m_scratch;
+  Slot m_registerCount;
+  int m_lowestOffset;
+};
+
+} // namespace bytecode
+} // namespace tiger
@@ -33,14 +33,15 @@ assembly::Instructions
   CallingConvention::procEntryExit2(const assembly::Instructions &body) const {
   // appends a “sink” instruction to the function body to tell the
   // register allocator that certain registers are live at procedure exit
-  namespace rv     = ranges::view;
+  namespace rv          = ranges::view;
+  auto const liveAtExit = liveAtExitRegisters();
+  assembly::Operation sink{{}, {}, {liveAtExit.begin(), liveAtExit.end()}};
 #ifdef _MSC_VER
   auto res = body;
-  res.push_back(assembly::Operation{{}, {}, liveAtExitRegisters()});
+  res.push_back(sink);
   return res;
 #else
-  return ranges::view::concat(
-    body, rv::single(assembly::Operation{{}, {}, liveAtExitRegisters()}));
+  return ranges::view::concat(body, rv::single(sink));
 #endif
 }
 
@@ -0,0 +1,180 @@
+#include "CanonicalLoops.h"
+#include "variantMatch.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace tiger {
+
+using helpers::hasType;
+using helpers::match;
+
+CanonicalLoops::CanonicalLoops(const ir::Statements &statements) :
+    m_blocks{basicBlocks(statements)}, m_size{statements.size()},
+    m_analyser{successors(statements, m_blocks)} {}
+
+std::vector<bool>
+  CanonicalLoops::statementsOf(const LoopAnalyser::Loop &loop) const {
+  std::vector<bool> res(m_size);
+  for (auto block : loop.m_nodes) {
+    std::fill(res.begin() + m_blocks[block].m_first,
+              res.begin() + m_blocks[block].m_last, true);
+  }
+  return res;
+}
+
+boost::optional<temp::Label>
+  CanonicalLoops::headerLabel(const LoopAnalyser::Loop &loop) const {
+  auto const &header = m_blocks[loop.m_header];
+  // nothing can come before the function entry
+  if (header.m_first == 0) {
+    return {};
+  }
+  return header.m_label;
+}
+
+void CanonicalLoops::insertPreheader(ir::Statements &statements,
+                                     std::vector<bool> &inLoop,
+                                     const temp::Label &header,
+                                     ir::Statements &&preheader,
+                                     temp::Map &tempMap) {
+  auto const headerIt =
+    std::find_if(statements.begin(), statements.end(),
+                 [&header](const ir::Statement &stm) {
+                   auto const label = boost::get<temp::Label>(&stm);
+                   return label && *label == header;
+                 });
+  assert(headerIt != statements.begin() && headerIt != statements.end()
+         && "loop header should be labelled and not the function entry");
+  auto const headerIndex = static_cast<size_t>(headerIt - statements.begin());
+
+  // jumps from outside the loop enter through the preheader
+  auto const preheaderLabel = tempMap.newLabel();
+  auto const retarget       = [&](const temp::Label &label) {
+    return label == header ? preheaderLabel : label;
+  };
+  for (size_t i = 0; i < statements.size(); ++i) {
+    if (inLoop[i]) {
+      continue;
+    }
+    auto retargeted = match(statements[i])(
+      [&](const ir::Jump &jump) -> boost::optional<ir::Statement> {
+        if (jump.jumps.size() == 1 && jump.jumps.front() == header) {
+          return ir::Statement{ir::Jump{preheaderLabel}};
+        }
+        return {};
+      },
+      [&](const ir::ConditionalJump &cjump) -> boost::optional<ir::Statement> {
+        if (*cjump.trueDest == header || *cjump.falseDest == header) {
+          return ir::Statement{ir::ConditionalJump{
+            cjump.op, cjump.left, cjump.right, retarget(*cjump.trueDest),
+            retarget(*cjump.falseDest)}};
+        }
+        return {};
+      },
+      [](const auto & /*default*/) -> boost::optional<ir::Statement> {
+        return {};
+      });
+    if (retargeted) {
+      statements[i] = std::move(*retargeted);
+    }
+  }
+
+  // a loop block falling through to the header must still skip the
+  // preheader
+  ir::Statements inserted;
+  auto const before = headerIndex - 1;
+  if (inLoop[before]) {
+    auto const replaced = match(statements[before])(
+      [&](const ir::ConditionalJump &cjump) -> boost::optional<ir::Statement> {
+        if (*cjump.falseDest != header) {
+          return {};
+        }
+        // keep the false label right after the conditional jump
+        auto const falseLabel = tempMap.newLabel();
+        inserted.emplace_back(falseLabel);
+        inserted.emplace_back(ir::Jump{header});
+        return ir::Statement{ir::ConditionalJump{
+          cjump.op, cjump.left, cjump.right, *cjump.trueDest, falseLabel}};
+      },
+      [](const ir::Jump &) -> boost::optional<ir::Statement> { return {}; },
+      [&](const auto & /*default*/) -> boost::optional<ir::Statement> {
+        inserted.emplace_back(ir::Jump{header});
+        return {};
+      });
+    if (replaced) {
+      statements[before] = std::move(*replaced);
+    }
+  }
+  auto const loopStatements = inserted.size();
+
+  inserted.emplace_back(preheaderLabel);
+  std::move(preheader.begin(), preheader.end(), std::back_inserter(inserted));
+  statements.insert(statements.begin() + headerIndex,
+                    std::make_move_iterator(inserted.begin()),
+                    std::make_move_iterator(inserted.end()));
+  inLoop.insert(inLoop.begin() + headerIndex, loopStatements, true);
+  inLoop.insert(inLoop.begin() + headerIndex + loopStatements,
+                inserted.size() - loopStatements, false);
+}
+
+CanonicalLoops::Blocks
+  CanonicalLoops::basicBlocks(const ir::Statements &statements) {
+  Blocks res;
+  size_t first     = 0;
+  auto const close = [&](size_t last) {
+    auto const label = boost::get<temp::Label>(&statements[first]);
+    res.push_back(
+      {first, last, label ? *label : boost::optional<temp::Label>{}});
+    first = last;
+  };
+  for (size_t i = 0; i < statements.size(); ++i) {
+    if (i != first && hasType<temp::Label>(statements[i])) {
+      close(i);
+    }
+    if (ir::isJump(statements[i])) {
+      close(i + 1);
+    }
+  }
+  if (first != statements.size()) {
+    close(statements.size());
+  }
+  return res;
+}
+
+LoopAnalyser::Successors
+  CanonicalLoops::successors(const ir::Statements &statements,
+                             const Blocks &blocks) {
+  std::unordered_map<temp::Label, size_t> labelBlocks;
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    if (blocks[i].m_label) {
+      labelBlocks.emplace(*blocks[i].m_label, i);
+    }
+  }
+
+  LoopAnalyser::Successors res(blocks.size());
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    auto const addSuccessor = [&](const temp::Label &label) {
+      auto const it = labelBlocks.find(label);
+      if (it != labelBlocks.end()) {
+        res[i].push_back(it->second);
+      }
+    };
+
+    match(statements[blocks[i].m_last - 1])(
+      [&](const ir::Jump &jump) {
+        std::for_each(jump.jumps.begin(), jump.jumps.end(), addSuccessor);
+      },
+      [&](const ir::ConditionalJump &cjump) {
+        addSuccessor(*cjump.trueDest);
+        addSuccessor(*cjump.falseDest);
+      },
+      [&](const auto & /*default*/) {
+        if (i + 1 < blocks.size()) {
+          res[i].push_back(i + 1);
+        }
+      });
+  }
+  return res;
+}
+
+} // namespace tiger
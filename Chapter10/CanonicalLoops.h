@@ -0,0 +1,53 @@
+#pragma once
+#include "LoopAnalyser.h"
+#include "Tree.h"
+
+namespace tiger {
+
+// the basic blocks and loops of canonical IR
+class CanonicalLoops {
+public:
+  struct Block {
+    size_t m_first, m_last;
+    boost::optional<temp::Label> m_label;
+  };
+
+  using Blocks = std::vector<Block>;
+
+  CanonicalLoops(const ir::Statements &statements);
+
+  // ordered so that a loop comes after the loops containing it
+  const std::vector<LoopAnalyser::Loop> &loops() const {
+    return m_analyser.loops();
+  }
+
+  // marks the statements which belong to loop
+  std::vector<bool> statementsOf(const LoopAnalyser::Loop &loop) const;
+
+  // the label starting the header of loop, if a preheader can be inserted
+  // before it
+  boost::optional<temp::Label>
+    headerLabel(const LoopAnalyser::Loop &loop) const;
+
+  // inserts preheader before the loop whose header starts with header, so
+  // that it is executed once whenever the loop is entered. inLoop marks the
+  // statements of the loop and is updated with the inserted statements
+  static void insertPreheader(ir::Statements &statements,
+                              std::vector<bool> &inLoop,
+                              const temp::Label &header,
+                              ir::Statements &&preheader, temp::Map &tempMap);
+
+  static Blocks basicBlocks(const ir::Statements &statements);
+
+  // the successors of a block are its jump targets in order, or the next
+  // block when it falls through
+  static LoopAnalyser::Successors successors(const ir::Statements &statements,
+                                             const Blocks &blocks);
+
+private:
+  Blocks m_blocks;
+  size_t m_size;
+  LoopAnalyser m_analyser;
+};
+
+} // namespace tiger
@@ -1,5 +1,6 @@
 #include "Canonicalizer.h"
 #include "CallingConvention.h"
+#include "Simplifier.h"
 #include "variantMatch.h"
 #include <numeric>
 
@@ -7,7 +8,10 @@ namespace tiger {
 
 using helpers::match;
 
-Canonicalizer::Canonicalizer(temp::Map &tempMap) : m_tempMap{tempMap} {}
+Canonicalizer::Canonicalizer(temp::Map &tempMap,
+                             boost::optional<SideEffects> sideEffects) :
+    m_tempMap{tempMap},
+    m_sideEffects{std::move(sideEffects)} {}
 
 ir::Statements Canonicalizer::canonicalize(ir::Statement &&statement) {
   // add jump to end
@@ -154,7 +158,14 @@ ir::Statements Canonicalizer::traceSchedule(BasicBlocks &&blocks) const {
 
 bool Canonicalizer::commutes(const ir::Statement &stm,
                              const ir::Expression &exp) const {
-  return isConst(exp) || isNop(stm);
+  if (isConst(exp) || isNop(stm)) {
+    return true;
+  }
+
+  // a pure expression can be evaluated after a statement which doesn't write
+  // the temps and memory it reads
+  return m_sideEffects && Simplifier::isPure(exp)
+         && !m_sideEffects->kills(stm, exp);
 }
 
 template <typename T, typename... Ts>
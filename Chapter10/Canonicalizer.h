@@ -1,5 +1,6 @@
 #pragma once
 #include "Fragment.h"
+#include "SideEffects.h"
 #include "Tree.h"
 #include "type_traits.h"
 
@@ -9,7 +10,9 @@ class Canonicalizer {
 public:
   using BasicBlocks = std::vector<ir::Statements>;
 
-  Canonicalizer(temp::Map &tempMap);
+  // without sideEffects only constants are known to commute with statements
+  Canonicalizer(temp::Map &tempMap,
+                boost::optional<SideEffects> sideEffects = boost::none);
 
   // reduce program to a list of statements
   ir::Statements canonicalize(ir::Statement &&statement);
@@ -25,7 +28,7 @@ private:
   // its false label
   ir::Statements traceSchedule(BasicBlocks &&block) const;
 
-  // estimates (very naively) whether stm and exp commute
+  // estimates whether stm and exp commute
   bool commutes(const ir::Statement &stm, const ir::Expression &exp) const;
 
   // pull all the ir::ExpressionSequence-s out of a list of expressions
@@ -69,6 +72,7 @@ private:
                              const ir::Statements &right) const;
 
   temp::Map &m_tempMap;
+  boost::optional<SideEffects> m_sideEffects;
 };
 
 } // namespace tiger
@@ -1,5 +1,6 @@
 #include "CodeGenerator.h"
 #include "CallingConvention.h"
+#include "Simplifier.h"
 #include "TreeAdapted.h"
 #include "variantMatch.h"
 #include "warning_suppress.h"
@@ -40,10 +41,11 @@ CodeGenerator::CodeGenerator(frame::CallingConvention &callingConvention,
     m_patterns{std::move(patterns)} {}
 
 Instructions CodeGenerator::translateFunction(const ir::Statements &statements,
-                                              temp::Map &tempMap) const {
+                                              temp::Map &tempMap,
+                                              bool orderByNeed) const {
   Instructions instructions;
   ranges::for_each(statements, [&](const ir::Statement &statement) {
-    auto matched = match(statement, tempMap);
+    auto matched = match(statement, tempMap, orderByNeed);
     if (!matched) {
       std::stringstream sst;
       sst << "Could find a match for ";
@@ -56,9 +58,30 @@ Instructions CodeGenerator::translateFunction(const ir::Statements &statements,
   return instructions;
 }
 
+namespace {
+
+// Sethi-Ullman labeling: the number of registers needed to evaluate exp
+// without spilling
+unsigned registerNeed(const ir::Expression &exp) {
+  return helpers::match(exp)(
+    [](const ir::BinaryOperation &binOperation) {
+      auto const left  = registerNeed(binOperation.left);
+      auto const right = registerNeed(binOperation.right);
+      return left == right ? left + 1 : std::max(left, right);
+    },
+    [](const ir::MemoryAccess &memAccess) {
+      return std::max(1u, registerNeed(memAccess.address));
+    },
+    [](const auto & /*default*/) { return 0u; });
+}
+
+} // namespace
+
 struct DagMatcher {
-  DagMatcher(const CodeGenerator &codeGenerator, temp::Map &tempMap) :
-      m_codeGenerator{codeGenerator}, m_tempMap{tempMap} {}
+  DagMatcher(const CodeGenerator &codeGenerator, temp::Map &tempMap,
+             bool orderByNeed) :
+      m_codeGenerator{codeGenerator},
+      m_tempMap{tempMap}, m_orderByNeed{orderByNeed} {}
 
   struct MatchData {
     Instructions m_instructions;
@@ -102,6 +125,9 @@ struct DagMatcher {
   bool match(const ir::Call &code, const ir::Call &pattern,
              MatchData &matchData) const;
 
+  bool match(const ir::BinaryOperation &code,
+             const ir::BinaryOperation &pattern, MatchData &matchData) const;
+
   template <typename T, typename U>
   bool match(const T &, const U &, MatchData &) const {
     return false;
@@ -109,12 +135,13 @@ struct DagMatcher {
 
   const CodeGenerator &m_codeGenerator;
   temp::Map &m_tempMap;
+  bool m_orderByNeed;
 };
 
 boost::optional<Instructions>
   CodeGenerator::match(const ir::Statement &statement,
-                       temp::Map &tempMap) const {
-  DagMatcher dagMatcher{*this, tempMap};
+                       temp::Map &tempMap, bool orderByNeed) const {
+  DagMatcher dagMatcher{*this, tempMap, orderByNeed};
   auto dag = helpers::match(statement)(
     [](const ir::ExpressionStatement &expStatement) -> Dag {
       return expStatement.exp;
@@ -339,6 +366,44 @@ bool DagMatcher::match(const ir::Call &code, const ir::Call &pattern,
   return true;
 } // namespace assembly
 
+bool DagMatcher::match(const ir::BinaryOperation &code,
+                       const ir::BinaryOperation &pattern,
+                       MatchData &matchData) const {
+  if (code.op != pattern.op) {
+    return false;
+  }
+
+  // the operands are pure so they can be evaluated in any order
+  auto const rightFirst =
+    m_orderByNeed && registerNeed(code.right) > registerNeed(code.left)
+    && Simplifier::isPure(code.left) && Simplifier::isPure(code.right);
+  if (!rightFirst) {
+    return match(code.left, pattern.left, matchData)
+           && match(code.right, pattern.right, matchData);
+  }
+
+  MatchData rightMatchData;
+  if (!match(code.right, pattern.right, rightMatchData)) {
+    return false;
+  }
+
+  auto const leftPosition = matchData.m_instructions.size();
+  if (!match(code.left, pattern.left, matchData)) {
+    return false;
+  }
+
+  // emit the right operand instructions before the left ones, but keep the
+  // operands in pattern order
+  matchData.m_instructions.insert(
+    matchData.m_instructions.begin() + leftPosition,
+    std::make_move_iterator(rightMatchData.m_instructions.begin()),
+    std::make_move_iterator(rightMatchData.m_instructions.end()));
+  std::move(rightMatchData.m_operands.begin(),
+            rightMatchData.m_operands.end(),
+            std::back_inserter(matchData.m_operands));
+  return true;
+}
+
 std::string CodeGenerator::escape(const std::string &str) const {
   namespace karma = boost::spirit::karma;
   std::string res;
@@ -17,7 +17,7 @@ using Dag       = boost::variant<ir::Expression, ir::Statement>;
 using Arguments = std::vector<boost::variant<temp::Register, size_t>>;
 struct InstructionInitializer {
   InstructionType m_type;
-  std::string m_syntax;
+  Syntax m_syntax;
   Arguments m_explicitArguments;
   Arguments m_implicitSources;
   Arguments m_implicitDestinations;
@@ -43,8 +43,11 @@ public:
   CodeGenerator(frame::CallingConvention &callingConvention,
                 Patterns &&patterns);
 
+  // when orderByNeed is set, the operand which needs more registers is
+  // evaluated first
   Instructions translateFunction(const ir::Statements &statements,
-                                 temp::Map &tempMap) const;
+                                 temp::Map &tempMap,
+                                 bool orderByNeed = false) const;
 
   virtual Instructions translateString(const temp::Label &label,
                                        const std::string &string,
@@ -57,7 +60,8 @@ protected:
 
 private:
   boost::optional<Instructions> match(const ir::Statement &statement,
-                                      temp::Map &tempMap) const;
+                                      temp::Map &tempMap,
+                                      bool orderByNeed) const;
 
   virtual Instructions translateArgs(const std::vector<ir::Expression> &args,
                                      const temp::Map &tempMap) const = 0;
@@ -0,0 +1,387 @@
+#include "ConstantPropagation.h"
+#include "Simplifier.h"
+#include "variantMatch.h"
+#include <algorithm>
+
+namespace tiger {
+
+using helpers::match;
+
+namespace {
+
+template <typename F> void forEachUse(const ir::Expression &exp, F &&f) {
+  ir::replaceUses(exp, [&f](const temp::Register &reg) -> ir::Expression {
+    f(reg);
+    return reg;
+  });
+}
+
+template <typename F> void forEachUse(const ir::Statement &stm, F &&f) {
+  ir::replaceUses(stm, [&f](const temp::Register &reg) -> ir::Expression {
+    f(reg);
+    return reg;
+  });
+}
+
+} // namespace
+
+bool ConstantPropagation::Value::operator==(const Value &other) const {
+  return m_kind == other.m_kind
+         && (m_kind != Kind::CONSTANT || m_constant == other.m_constant);
+}
+
+ConstantPropagation::ConstantPropagation(temp::Map &tempMap) :
+    m_ssaBuilder{tempMap} {}
+
+ir::Statements
+  ConstantPropagation::propagate(ir::Statements &&statements) const {
+  auto ssa = m_ssaBuilder.build(std::move(statements));
+  if (ssa.m_blocks.empty()) {
+    return {};
+  }
+
+  Context context{ssa, {}, {}, {}, {}, {}, {}};
+  analyse(context);
+  transform(context);
+  removeUnused(ssa);
+  return m_ssaBuilder.destruct(std::move(ssa));
+}
+
+void ConstantPropagation::analyse(Context &context) const {
+  auto const &blocks = context.m_ssa.m_blocks;
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    auto const &block = blocks[b];
+    auto const count  = block.m_statements.size();
+    for (size_t i = 0; i < count; ++i) {
+      forEachUse(block.m_statements[i], [&](const temp::Register &reg) {
+        context.m_uses[reg].push_back({b, i});
+      });
+    }
+    for (size_t i = 0; i < block.m_phis.size(); ++i) {
+      for (const auto &arg : block.m_phis[i].m_args) {
+        forEachUse(arg, [&](const temp::Register &reg) {
+          context.m_uses[reg].push_back({b, count + i});
+        });
+      }
+    }
+    context.m_executable.emplace_back(block.m_successors.size());
+  }
+  context.m_visited.resize(blocks.size());
+
+  auto const visitBlock = [&](size_t b) {
+    context.m_visited[b] = true;
+    auto const &block    = blocks[b];
+    auto const count     = block.m_statements.size() + block.m_phis.size();
+    for (size_t i = 0; i < count; ++i) {
+      visit({b, i}, context);
+    }
+  };
+
+  visitBlock(0);
+  while (!context.m_edgeWorklist.empty() || !context.m_useWorklist.empty()) {
+    while (!context.m_edgeWorklist.empty()) {
+      auto const edge = context.m_edgeWorklist.back();
+      context.m_edgeWorklist.pop_back();
+      auto &&executable = context.m_executable[edge.first][edge.second];
+      if (executable) {
+        continue;
+      }
+      executable = true;
+
+      auto const successor = blocks[edge.first].m_successors[edge.second];
+      if (!context.m_visited[successor]) {
+        visitBlock(successor);
+        continue;
+      }
+      // a new edge only changes the phis of a visited block
+      auto const &block = blocks[successor];
+      for (size_t i = 0; i < block.m_phis.size(); ++i) {
+        visit({successor, block.m_statements.size() + i}, context);
+      }
+    }
+
+    while (!context.m_useWorklist.empty()) {
+      auto const use = context.m_useWorklist.back();
+      context.m_useWorklist.pop_back();
+      if (context.m_visited[use.m_block]) {
+        visit(use, context);
+      }
+    }
+
+    if (!context.m_edgeWorklist.empty()) {
+      continue;
+    }
+    // conditions reading temps which are never defined may take any branch
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      auto const &executable = context.m_executable[b];
+      if (context.m_visited[b]
+          && helpers::hasType<ir::ConditionalJump>(
+               blocks[b].m_statements.back())
+          && std::none_of(executable.begin(), executable.end(),
+                          [](bool e) { return e; })) {
+        context.m_edgeWorklist.emplace_back(b, 0);
+        context.m_edgeWorklist.emplace_back(b, 1);
+      }
+    }
+  }
+}
+
+void ConstantPropagation::visit(const Use &use, Context &context) const {
+  auto const &block = context.m_ssa.m_blocks[use.m_block];
+  auto const count  = block.m_statements.size();
+  auto const markEdge = [&](size_t successor) {
+    context.m_edgeWorklist.emplace_back(use.m_block, successor);
+  };
+
+  if (use.m_index >= count) {
+    auto const &phi = block.m_phis[use.m_index - count];
+    Value value{Value::Kind::UNDEFINED, 0};
+    for (size_t i = 0; i < phi.m_args.size(); ++i) {
+      auto const &predecessor = block.m_predecessors[i];
+      if (context.m_executable[predecessor.m_block]
+                              [predecessor.m_successor]) {
+        value = meet(value, evaluate(phi.m_args[i], context));
+      }
+    }
+    setValue(phi.m_dst, value, context);
+    return;
+  }
+
+  auto const &stm    = block.m_statements[use.m_index];
+  auto const isJump = match(stm)(
+    [&](const ir::Move &move) {
+      auto const reg = boost::get<temp::Register>(&move.dst);
+      if (reg && context.m_ssa.m_originals.count(*reg)) {
+        setValue(*reg, evaluate(move.src, context), context);
+      }
+      return false;
+    },
+    [&](const ir::ConditionalJump &cjump) {
+      auto const left  = evaluate(cjump.left, context);
+      auto const right = evaluate(cjump.right, context);
+      if (left.m_kind == Value::Kind::CONSTANT
+          && right.m_kind == Value::Kind::CONSTANT) {
+        markEdge(Simplifier::evaluate(cjump.op, left.m_constant,
+                                      right.m_constant)
+                   ? 0
+                   : 1);
+      } else if (left.m_kind == Value::Kind::VARYING
+                 || right.m_kind == Value::Kind::VARYING) {
+        markEdge(0);
+        markEdge(1);
+      }
+      return true;
+    },
+    [&](const ir::Jump &) {
+      for (size_t i = 0; i < block.m_successors.size(); ++i) {
+        markEdge(i);
+      }
+      return true;
+    },
+    [](const auto & /*default*/) { return false; });
+
+  // falling through to the next block
+  if (!isJump && use.m_index + 1 == count && !block.m_successors.empty()) {
+    markEdge(0);
+  }
+}
+
+void ConstantPropagation::setValue(const temp::Register &reg,
+                                   const Value &value,
+                                   Context &context) const {
+  auto &current  = context.m_values[reg];
+  auto const met = meet(current, value);
+  if (met == current) {
+    return;
+  }
+  current = met;
+  auto const &uses = context.m_uses[reg];
+  std::copy(uses.begin(), uses.end(),
+            std::back_inserter(context.m_useWorklist));
+}
+
+ConstantPropagation::Value
+  ConstantPropagation::evaluate(const ir::Expression &exp,
+                                const Context &context) const {
+  return match(exp)(
+    [](int i) { return Value{Value::Kind::CONSTANT, i}; },
+    [&](const temp::Register &reg) {
+      // temps which are not renamed come from outside the function
+      if (!context.m_ssa.m_originals.count(reg)) {
+        return Value{Value::Kind::VARYING, 0};
+      }
+      auto const it = context.m_values.find(reg);
+      return it == context.m_values.end() ? Value{Value::Kind::UNDEFINED, 0}
+                                          : it->second;
+    },
+    [&](const ir::BinaryOperation &binOperation) {
+      auto const left  = evaluate(binOperation.left, context);
+      auto const right = evaluate(binOperation.right, context);
+      if (left.m_kind == Value::Kind::VARYING
+          || right.m_kind == Value::Kind::VARYING) {
+        return Value{Value::Kind::VARYING, 0};
+      }
+      if (left.m_kind == Value::Kind::UNDEFINED
+          || right.m_kind == Value::Kind::UNDEFINED) {
+        return Value{Value::Kind::UNDEFINED, 0};
+      }
+      auto const res = Simplifier::evaluate(binOperation.op, left.m_constant,
+                                            right.m_constant);
+      return res ? Value{Value::Kind::CONSTANT, *res}
+                 : Value{Value::Kind::VARYING, 0};
+    },
+    [](const auto & /*default*/) { return Value{Value::Kind::VARYING, 0}; });
+}
+
+ConstantPropagation::Value ConstantPropagation::meet(const Value &left,
+                                                     const Value &right) {
+  if (left.m_kind == Value::Kind::UNDEFINED) {
+    return right;
+  }
+  if (right.m_kind == Value::Kind::UNDEFINED || left == right) {
+    return left;
+  }
+  return {Value::Kind::VARYING, 0};
+}
+
+void ConstantPropagation::transform(Context &context) const {
+  auto &ssa    = context.m_ssa;
+  auto &blocks = ssa.m_blocks;
+
+  // a branch taken one way becomes a jump, which is dropped when its target
+  // comes next
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    auto &statements = blocks[b].m_statements;
+    auto const cjump = boost::get<ir::ConditionalJump>(&statements.back());
+    auto const &executable = context.m_executable[b];
+    if (!context.m_visited[b] || !cjump || executable[0] == executable[1]) {
+      continue;
+    }
+    auto const taken = executable[0] ? 0 : 1;
+    auto const label = taken == 0 ? *cjump->trueDest : *cjump->falseDest;
+    ssa.removeEdge(b, 1 - taken);
+    if (blocks[b].m_successors.front() == b + 1 && statements.size() > 1) {
+      statements.pop_back();
+    } else {
+      statements.back() = ir::Jump{label};
+    }
+  }
+
+  std::vector<bool> unreachable(blocks.size());
+  std::transform(context.m_visited.begin(), context.m_visited.end(),
+                 unreachable.begin(), [](bool visited) { return !visited; });
+  ssa.removeBlocks(unreachable);
+
+  for (auto &block : blocks) {
+    for (auto &stm : block.m_statements) {
+      stm = match(stm)(
+        [&](const ir::Move &move) -> ir::Statement {
+          return match(move.dst)(
+            [&](const ir::MemoryAccess &memAccess) -> ir::Statement {
+              return ir::Move{
+                rewrite(move.src, context),
+                ir::MemoryAccess{rewrite(memAccess.address, context)}};
+            },
+            [&](const auto &dst) -> ir::Statement {
+              return ir::Move{rewrite(move.src, context), dst};
+            });
+        },
+        [&](const ir::ExpressionStatement &expStatement) -> ir::Statement {
+          return ir::ExpressionStatement{rewrite(expStatement.exp, context)};
+        },
+        [&](const ir::ConditionalJump &cjump) -> ir::Statement {
+          return ir::ConditionalJump{cjump.op, rewrite(cjump.left, context),
+                                     rewrite(cjump.right, context),
+                                     *cjump.trueDest, *cjump.falseDest};
+        },
+        [](const auto &stm) -> ir::Statement { return stm; });
+    }
+  }
+}
+
+ir::Expression ConstantPropagation::rewrite(const ir::Expression &exp,
+                                            const Context &context) const {
+  auto const value = evaluate(exp, context);
+  if (value.m_kind == Value::Kind::CONSTANT) {
+    return value.m_constant;
+  }
+
+  return match(exp)(
+    [&](const ir::BinaryOperation &binOperation) -> ir::Expression {
+      return ir::BinaryOperation{binOperation.op,
+                                 rewrite(binOperation.left, context),
+                                 rewrite(binOperation.right, context)};
+    },
+    [&](const ir::MemoryAccess &memAccess) -> ir::Expression {
+      return ir::MemoryAccess{rewrite(memAccess.address, context)};
+    },
+    [&](const ir::Call &call) -> ir::Expression {
+      ir::Call res{call.fun, {}};
+      res.args.reserve(call.args.size());
+      for (const auto &arg : call.args) {
+        res.args.push_back(rewrite(arg, context));
+      }
+      return res;
+    },
+    [](const auto &exp) -> ir::Expression { return exp; });
+}
+
+void ConstantPropagation::removeUnused(SsaForm &ssa) const {
+  std::unordered_map<temp::Register, size_t> uses;
+  auto const addUse    = [&uses](const temp::Register &reg) { ++uses[reg]; };
+  auto const removeUse = [&uses](const temp::Register &reg) { --uses[reg]; };
+  for (const auto &block : ssa.m_blocks) {
+    for (const auto &stm : block.m_statements) {
+      forEachUse(stm, addUse);
+    }
+    for (const auto &phi : block.m_phis) {
+      for (const auto &arg : phi.m_args) {
+        forEachUse(arg, addUse);
+      }
+    }
+  }
+
+  auto const unused = [&](const temp::Register &reg) {
+    return ssa.m_originals.count(reg) && !uses[reg];
+  };
+
+  // removing a definition may leave the temps it used unused
+  for (auto removed = true; removed;) {
+    removed = false;
+    for (auto &block : ssa.m_blocks) {
+      auto &statements  = block.m_statements;
+      auto const notUsed = [&](const ir::Statement &stm) {
+        auto const move = boost::get<ir::Move>(&stm);
+        if (!move) {
+          return false;
+        }
+        auto const reg = boost::get<temp::Register>(&move->dst);
+        if (!reg || !unused(*reg) || !Simplifier::isPure(move->src)) {
+          return false;
+        }
+        forEachUse(move->src, removeUse);
+        removed = true;
+        return true;
+      };
+      statements.erase(
+        std::remove_if(statements.begin(), statements.end(), notUsed),
+        statements.end());
+
+      auto &phis = block.m_phis;
+      phis.erase(std::remove_if(phis.begin(), phis.end(),
+                                [&](const SsaForm::Phi &phi) {
+                                  if (!unused(phi.m_dst)) {
+                                    return false;
+                                  }
+                                  for (const auto &arg : phi.m_args) {
+                                    forEachUse(arg, removeUse);
+                                  }
+                                  removed = true;
+                                  return true;
+                                }),
+                 phis.end());
+    }
+  }
+}
+
+} // namespace tiger
@@ -0,0 +1,68 @@
+#pragma once
+#include "SsaBuilder.h"
+
+namespace tiger {
+
+// sparse conditional constant propagation on the SSA form of canonical IR.
+// Blocks are assumed unreachable and temps undefined until shown otherwise, so
+// constants are found through branches whose conditions are constant. Temps
+// holding constants are replaced with their values, branches with constant
+// conditions become jumps and unreachable blocks and unused definitions are
+// removed
+class ConstantPropagation {
+public:
+  explicit ConstantPropagation(temp::Map &tempMap);
+
+  ir::Statements propagate(ir::Statements &&statements) const;
+
+private:
+  struct Value {
+    enum class Kind { UNDEFINED, CONSTANT, VARYING } m_kind;
+    int m_constant;
+
+    bool operator==(const Value &other) const;
+  };
+
+  using Values = std::unordered_map<temp::Register, Value>;
+
+  // a statement, or a phi when m_index is past the statements
+  struct Use {
+    size_t m_block;
+    size_t m_index;
+  };
+
+  struct Context {
+    SsaForm &m_ssa;
+    Values m_values;
+    std::unordered_map<temp::Register, std::vector<Use>> m_uses;
+    std::vector<bool> m_visited;
+    // executable edges, by block and successor index
+    std::vector<std::vector<bool>> m_executable;
+    std::vector<std::pair<size_t, size_t>> m_edgeWorklist;
+    std::vector<Use> m_useWorklist;
+  };
+
+  void analyse(Context &context) const;
+
+  void visit(const Use &use, Context &context) const;
+
+  void setValue(const temp::Register &reg, const Value &value,
+                Context &context) const;
+
+  Value evaluate(const ir::Expression &exp, const Context &context) const;
+
+  static Value meet(const Value &left, const Value &right);
+
+  void transform(Context &context) const;
+
+  // replaces the expressions with constant values
+  ir::Expression rewrite(const ir::Expression &exp,
+                         const Context &context) const;
+
+  // removes the definitions of temps which are never used
+  void removeUnused(SsaForm &ssa) const;
+
+  SsaBuilder m_ssaBuilder;
+};
+
+} // namespace tiger
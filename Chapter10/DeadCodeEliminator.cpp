@@ -0,0 +1,76 @@
+#include "DeadCodeEliminator.h"
+#include "FlowGraph.h"
+#include "LivenessAnalyser.h"
+#include "irange.h"
+#include "variantMatch.h"
+#include <algorithm>
+
+namespace tiger {
+namespace regalloc {
+
+assembly::Instructions
+  DeadCodeEliminator::eliminate(assembly::Instructions &&instructions,
+                                const temp::Map &tempMap) const {
+  // removing an instruction may make the registers it uses dead
+  while (eliminateOnce(instructions, tempMap)) {
+  }
+  return std::move(instructions);
+}
+
+bool DeadCodeEliminator::eliminateOnce(assembly::Instructions &instructions,
+                                       const temp::Map &tempMap) const {
+  if (instructions.empty()) {
+    return false;
+  }
+
+  FlowGraph flowGraph{instructions};
+  LivenessAnalyser livenessAnalyser{flowGraph, tempMap};
+
+  // the first instruction is the function entry
+  std::vector<bool> reachable(instructions.size());
+  std::vector<FlowGraph::vertex_descriptor> worklist{0};
+  reachable[0] = true;
+  while (!worklist.empty()) {
+    auto const v = worklist.back();
+    worklist.pop_back();
+    for (auto u : irange(boost::adjacent_vertices(v, flowGraph))) {
+      if (!reachable[u]) {
+        reachable[u] = true;
+        worklist.push_back(u);
+      }
+    }
+  }
+
+  auto const isDead = [&](FlowGraph::vertex_descriptor v) {
+    auto const &defs = flowGraph.defs(v);
+    auto const &live = livenessAnalyser.liveOuts(v);
+    // machine registers are kept, as they may be read implicitly, e.g. by a
+    // call or the function epilogue
+    auto const usedDef = std::any_of(
+      defs.begin(), defs.end(), [&live](const temp::Register &def) {
+        return temp::isMachineRegister(def)
+               || std::binary_search(live.begin(), live.end(), def);
+      });
+    // the instruction before a jump may set the condition codes it tests
+    auto const beforeJump =
+      v + 1 < instructions.size()
+      && helpers::hasType<assembly::Jump>(instructions[v + 1]);
+    return !defs.empty() && !usedDef && !beforeJump
+           && !helpers::hasType<assembly::Jump>(instructions[v]);
+  };
+
+  assembly::Instructions res;
+  res.reserve(instructions.size());
+  for (auto v : irange(boost::vertices(flowGraph))) {
+    if (reachable[v] && !isDead(v)) {
+      res.push_back(std::move(instructions[v]));
+    }
+  }
+
+  auto const removed = res.size() != instructions.size();
+  instructions       = std::move(res);
+  return removed;
+}
+
+} // namespace regalloc
+} // namespace tiger
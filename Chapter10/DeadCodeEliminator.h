@@ -0,0 +1,22 @@
+#pragma once
+#include "Assembly.h"
+
+namespace tiger {
+namespace regalloc {
+
+// removes instructions which can't be reached and instructions whose results
+// are never used, until no more instructions can be removed
+class DeadCodeEliminator {
+public:
+  assembly::Instructions eliminate(assembly::Instructions &&instructions,
+                                   const temp::Map &tempMap) const;
+
+private:
+  // removes a single round of dead instructions, returns whether any was
+  // removed
+  bool eliminateOnce(assembly::Instructions &instructions,
+                     const temp::Map &tempMap) const;
+};
+
+} // namespace regalloc
+} // namespace tiger
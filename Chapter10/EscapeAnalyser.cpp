@@ -4,22 +4,37 @@
 
 namespace tiger {
 
+EscapeAnalyser::EscapeAnalyser(bool precise) : m_precise{precise} {}
+
 void EscapeAnalyser::analyse(ast::Expression &exp) {
   helpers::match(exp)(
     [this](ast::VarExpression &varExp) { analyseVar(varExp); },
+    [this](ast::AssignExpression &assignExp) { analyseAssign(assignExp); },
     [this](ast::LetExpression &letExp) { analyseLet(letExp); },
     [this](ast::ForExpression &forExp) { analyseFor(forExp); },
     [this](auto &exp) { this->analyse(exp); });
 }
 
-void EscapeAnalyser::analyseVar(ast::VarExpression &exp) {
+void EscapeAnalyser::analyseVar(ast::VarExpression &exp, bool assignment) {
   // search environments for this variable
   for (auto it = m_environments.rbegin(); it != m_environments.rend(); ++it) {
     auto itt = it->find(exp.first);
     if (itt != it->end()) {
+      auto &var = itt->second;
+      if (m_precise) {
+        // only nested functions need the variable in the frame
+        if (var.m_depth < m_depth) {
+          var.m_escapes.get() = true;
+        }
+        // assigning a field or an element doesn't change the variable
+        if (assignment && exp.rest.empty()) {
+          var.m_assigned.get() = true;
+        }
+        break;
+      }
       if (it != m_environments.rbegin()) {
         // variable escapes if it is used in a nested frame
-        itt->second.get() = true;
+        var.m_escapes.get() = true;
       }
     }
   }
@@ -30,6 +45,12 @@ void EscapeAnalyser::analyseVar(ast::VarExpression &exp) {
   }
 }
 
+void EscapeAnalyser::analyseAssign(ast::AssignExpression &exp) {
+  // a nested function assigning the variable needs it in the frame too
+  analyseVar(exp.var, true);
+  analyse(exp.exp);
+}
+
 void EscapeAnalyser::analyseLet(ast::LetExpression &exp) {
   m_environments.emplace_back();
 
@@ -46,36 +67,47 @@ void EscapeAnalyser::analyseLet(ast::LetExpression &exp) {
 }
 
 void EscapeAnalyser::analyseFuncDec(ast::FunctionDeclarations &decs) {
+  ++m_depth;
   for (auto &dec : decs) {
-    Environment newEnv;
+    m_environments.emplace_back();
     for (auto &param : dec.params) {
-      param.escapes = false;
-      newEnv.emplace(param.name.name, param.escapes);
+      declareVariable(param.name.name, param.escapes, param.assigned);
     }
 
-    m_environments.push_back(std::move(newEnv));
-
     analyse(dec.body);
 
     m_environments.pop_back();
   }
+  --m_depth;
 }
 
 void EscapeAnalyser::analyseVarDec(ast::VarDeclaration &dec) {
-  dec.escapes = false;
-  m_environments.back().emplace(dec.name, dec.escapes);
+  if (m_precise) {
+    analyse(dec.init);
+  }
+  declareVariable(dec.name, dec.escapes, dec.assigned);
 }
 
 void EscapeAnalyser::analyseFor(ast::ForExpression &exp) {
-  exp.escapes = false;
-  Environment newEnv;
-  newEnv.emplace(exp.var.name, exp.escapes);
+  if (m_precise) {
+    analyse(exp.lo);
+    analyse(exp.hi);
+  }
 
-  m_environments.push_back(std::move(newEnv));
+  m_environments.emplace_back();
+  declareVariable(exp.var.name, exp.escapes, exp.assigned);
 
   analyse(exp.body);
 
   m_environments.pop_back();
 }
 
+void EscapeAnalyser::declareVariable(const std::string &name, bool &escapes,
+                                     bool &assigned) {
+  escapes = false;
+  // only the precise analysis finds the variables which are never assigned
+  assigned = !m_precise;
+  m_environments.back().emplace(name, Variable{escapes, assigned, m_depth});
+}
+
 } // namespace tiger
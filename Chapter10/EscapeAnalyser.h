@@ -7,10 +7,15 @@
 namespace tiger {
 class EscapeAnalyser {
 public:
+  // a precise analysis only lets variables used by nested functions escape and
+  // finds the variables which are never assigned
+  explicit EscapeAnalyser(bool precise = false);
+
   void analyse(ast::Expression &exp);
 
 private:
-  void analyseVar(ast::VarExpression &exp);
+  void analyseVar(ast::VarExpression &exp, bool assignment = false);
+  void analyseAssign(ast::AssignExpression &exp);
   void analyseLet(ast::LetExpression &exp);
   void analyseFuncDec(ast::FunctionDeclarations &decs);
   void analyseVarDec(ast::VarDeclaration &dec);
@@ -22,9 +27,20 @@ private:
   template <typename T>
   std::enable_if_t<!boost::fusion::traits::is_sequence<T>::value> analyse(T &t);
 
-  using Environment =
-    std::unordered_map<std::string, std::reference_wrapper<bool>>;
+  struct Variable {
+    std::reference_wrapper<bool> m_escapes;
+    std::reference_wrapper<bool> m_assigned;
+    // nesting depth of the declaring function
+    size_t m_depth;
+  };
+
+  using Environment = std::unordered_map<std::string, Variable>;
+
+  void declareVariable(const std::string &name, bool &escapes, bool &assigned);
 
+  bool m_precise;
+  // nesting depth of the analysed function, the main program is at depth 0
+  size_t m_depth = 0;
   std::vector<Environment> m_environments;
 };
 
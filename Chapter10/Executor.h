@@ -0,0 +1,22 @@
+#pragma once
+#include "Assembly.h"
+#include "Runtime.h"
+
+namespace tiger {
+namespace assembly {
+
+// collects the machine code of the fragments of a program, once they are
+// lowered to run, and runs it in the compiling process
+class Executor {
+public:
+  virtual ~Executor() = default;
+
+  virtual void addFragment(const Instructions &instructions) = 0;
+
+  // calls main, with runtime implementing the functions the program calls,
+  // and returns the status passed to exit or else the value of the program
+  virtual Runtime::Word run(Runtime &runtime) = 0;
+};
+
+} // namespace assembly
+} // namespace tiger
@@ -3,9 +3,9 @@
 #include "warning_suppress.h"
 #include <boost/graph/graph_utility.hpp>
 MSC_DIAG_OFF(4459)
-#include <range/v3/action/sort.hpp>
-#include <range/v3/action/unique.hpp>
 #include <range/v3/algorithm/for_each.hpp>
+#include <range/v3/algorithm/sort.hpp>
+#include <range/v3/algorithm/unique.hpp>
 #include <range/v3/to_container.hpp>
 #include <range/v3/view.hpp>
 MSC_DIAG_ON()
@@ -18,7 +18,6 @@ FlowGraph::FlowGraph(const assembly::Instructions &instructions) :
     m_defs{instructions.size()}, m_isMove{instructions.size()} {
   using namespace assembly;
   namespace rv = ranges::view;
-  namespace ra = ranges::action;
 
   const std::unordered_map<temp::Label, int> label_map =
     rv::zip(instructions, rv::ints)
@@ -37,6 +36,14 @@ FlowGraph::FlowGraph(const assembly::Instructions &instructions) :
     }
   };
 
+  // the registers are copied in place, which doesn't allocate for most
+  // instructions
+  auto const assignSorted = [](RegisterList &to, const RegisterView &from) {
+    to.assign(from.begin(), from.end());
+    ranges::sort(to);
+    to.erase(ranges::unique(to), to.end());
+  };
+
   ranges::for_each(rv::zip(rv::ints, instructions), [&](const auto &p) {
     auto const processInstruction = [&](int index,
                                         const Instruction &instruction) {
@@ -50,8 +57,8 @@ FlowGraph::FlowGraph(const assembly::Instructions &instructions) :
           });
         },
         [&](const auto & /*default*/) { add_edge(index, index + 1); });
-      m_uses[index]   = instruction.sources() | ra::sort | ra::unique;
-      m_defs[index]   = instruction.destinations() | ra::sort | ra::unique;
+      assignSorted(m_uses[index], instruction.sources());
+      assignSorted(m_defs[index], instruction.destinations());
       m_isMove[index] = instruction.isMove();
       (*this)[index]  = instruction;
     };
@@ -61,10 +68,10 @@ FlowGraph::FlowGraph(const assembly::Instructions &instructions) :
   //boost::print_graph(*this);
 }
 
-const temp::Registers &FlowGraph::uses(vertex_descriptor v) const {
+const assembly::RegisterList &FlowGraph::uses(vertex_descriptor v) const {
   return m_uses[v];
 }
-const temp::Registers &FlowGraph::defs(vertex_descriptor v) const {
+const assembly::RegisterList &FlowGraph::defs(vertex_descriptor v) const {
   return m_defs[v];
 }
 bool FlowGraph::isMove(vertex_descriptor v) const { return m_isMove[v]; }
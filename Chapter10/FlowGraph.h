@@ -9,6 +9,7 @@ namespace tiger {
 namespace regalloc {
 
 using LiveRegisters = std::vector<temp::Registers>;
+using InstructionRegisters = std::vector<assembly::RegisterList>;
 
 class FlowGraph
     : public boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS,
@@ -17,15 +18,16 @@ class FlowGraph
 public:
   FlowGraph(const assembly::Instructions &instructions);
 
-  const temp::Registers &uses(vertex_descriptor v) const;
-  const temp::Registers &defs(vertex_descriptor v) const;
+  // sorted and without duplicates
+  const assembly::RegisterList &uses(vertex_descriptor v) const;
+  const assembly::RegisterList &defs(vertex_descriptor v) const;
   bool isMove(vertex_descriptor v) const;
 
 private:
   using base = boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS,
                                      assembly::Instruction>;
-  LiveRegisters m_uses;
-  LiveRegisters m_defs;
+  InstructionRegisters m_uses;
+  InstructionRegisters m_defs;
   boost::dynamic_bitset<> m_isMove;
 };
 
@@ -15,7 +15,9 @@ struct StringFragment {
 
 struct FunctionFragment {
   ir::Statement m_body;
-  std::shared_ptr<const frame::Frame> m_frame;
+  std::shared_ptr<frame::Frame> m_frame;
+  // whether the first formal of the frame is the static link
+  bool m_hasStaticLink;
 };
 
 using Fragment     = boost::variant<StringFragment, FunctionFragment>;
@@ -0,0 +1,449 @@
+#include "Inliner.h"
+#include "CallingConvention.h"
+#include "variantMatch.h"
+#include <algorithm>
+
+namespace tiger {
+
+using helpers::match;
+
+namespace {
+
+// calls onExpression and onStatement for every node of the tree
+template <typename E, typename S>
+void walk(const ir::Expression &exp, E &onExpression, S &onStatement);
+
+template <typename E, typename S>
+void walk(const ir::Statement &stm, E &onExpression, S &onStatement) {
+  onStatement(stm);
+  match(stm)(
+    [&](const ir::Sequence &sequence) {
+      for (const auto &stm : sequence.statements) {
+        walk(stm, onExpression, onStatement);
+      }
+    },
+    [&](const ir::Jump &jump) { walk(jump.exp, onExpression, onStatement); },
+    [&](const ir::ConditionalJump &cjump) {
+      walk(cjump.left, onExpression, onStatement);
+      walk(cjump.right, onExpression, onStatement);
+    },
+    [&](const ir::Move &move) {
+      walk(move.src, onExpression, onStatement);
+      walk(move.dst, onExpression, onStatement);
+    },
+    [&](const ir::ExpressionStatement &expStatement) {
+      walk(expStatement.exp, onExpression, onStatement);
+    },
+    [](const auto & /*default*/) {});
+}
+
+template <typename E, typename S>
+void walk(const ir::Expression &exp, E &onExpression, S &onStatement) {
+  onExpression(exp);
+  match(exp)(
+    [&](const ir::BinaryOperation &binOperation) {
+      walk(binOperation.left, onExpression, onStatement);
+      walk(binOperation.right, onExpression, onStatement);
+    },
+    [&](const ir::MemoryAccess &memAccess) {
+      walk(memAccess.address, onExpression, onStatement);
+    },
+    [&](const ir::ExpressionSequence &expSequence) {
+      walk(expSequence.stm, onExpression, onStatement);
+      walk(expSequence.exp, onExpression, onStatement);
+    },
+    [&](const ir::Call &call) {
+      walk(call.fun, onExpression, onStatement);
+      for (const auto &arg : call.args) {
+        walk(arg, onExpression, onStatement);
+      }
+    },
+    [](const auto & /*default*/) {});
+}
+
+// the labels used as values in stm
+template <typename F> void forEachLabel(const ir::Statement &stm, F &&f) {
+  auto onExpression = [&f](const ir::Expression &exp) {
+    if (auto const label = boost::get<temp::Label>(&exp)) {
+      f(*label);
+    }
+  };
+  auto onStatement = [](const ir::Statement &) {};
+  walk(stm, onExpression, onStatement);
+}
+
+} // namespace
+
+Inliner::Inliner(temp::Map &tempMap,
+                 const frame::CallingConvention &callingConvention) :
+    m_tempMap{tempMap},
+    m_callingConvention{callingConvention} {}
+
+void Inliner::inlineCalls(FragmentList &fragments) const {
+  Callees candidates;
+  std::unordered_map<temp::Label, size_t> callSites;
+  for (const auto &fragment : fragments) {
+    auto const function = boost::get<FunctionFragment>(&fragment);
+    if (!function) {
+      continue;
+    }
+    if (auto callee = candidate(*function)) {
+      candidates.emplace(function->m_frame->name(), std::move(*callee));
+    }
+    auto onExpression = [&callSites](const ir::Expression &exp) {
+      if (auto const call = boost::get<ir::Call>(&exp)) {
+        if (auto const label = boost::get<temp::Label>(&call->fun)) {
+          ++callSites[*label];
+        }
+      }
+    };
+    auto onStatement = [](const ir::Statement &) {};
+    walk(function->m_body, onExpression, onStatement);
+  }
+
+  // the benefit of removing a call outweighs the growth of small functions,
+  // while functions called once don't grow the program at all
+  Callees callees;
+  for (auto &candidate : candidates) {
+    auto const size = candidate.second.m_size;
+    if (size <= SMALL_SIZE
+        || (callSites[candidate.first] == 1 && size <= SINGLE_CALL_SIZE)) {
+      callees.insert(std::move(candidate));
+    }
+  }
+  if (callees.empty()) {
+    return;
+  }
+
+  Labels inlined;
+  for (auto &fragment : fragments) {
+    auto const function = boost::get<FunctionFragment>(&fragment);
+    if (!function) {
+      continue;
+    }
+    // a function is not inlined into itself
+    auto self = callees.extract(function->m_frame->name());
+    function->m_body =
+      inlineCalls(function->m_body, callees, *function->m_frame, inlined);
+    if (self) {
+      callees.insert(std::move(self));
+    }
+  }
+
+  // inlined functions which are no longer called are removed
+  auto const main = m_tempMap.namedLabel("main");
+  for (auto removed = true; removed;) {
+    Labels referenced;
+    for (const auto &fragment : fragments) {
+      if (auto const function = boost::get<FunctionFragment>(&fragment)) {
+        auto const name = function->m_frame->name();
+        forEachLabel(function->m_body, [&](const temp::Label &label) {
+          if (label != name) {
+            referenced.insert(label);
+          }
+        });
+      }
+    }
+
+    auto const unused = [&](const Fragment &fragment) {
+      auto const function = boost::get<FunctionFragment>(&fragment);
+      if (!function) {
+        return false;
+      }
+      auto const name = function->m_frame->name();
+      return name != main && inlined.count(name) && !referenced.count(name);
+    };
+    auto const it = std::remove_if(fragments.begin(), fragments.end(), unused);
+    removed       = it != fragments.end();
+    fragments.erase(it, fragments.end());
+  }
+}
+
+boost::optional<Inliner::Callee>
+  Inliner::candidate(const FunctionFragment &function) const {
+  // the body is the function label followed by the parameter moves and the
+  // move of the result
+  auto const &formals  = function.m_frame->formals();
+  auto const sequence = boost::get<ir::Sequence>(&function.m_body);
+  if (!sequence || sequence->statements.size() != 2) {
+    return {};
+  }
+  auto const entry = boost::get<ir::Sequence>(&sequence->statements.back());
+  if (!entry || entry->statements.size() != formals.size() + 1) {
+    return {};
+  }
+  auto const result = boost::get<ir::Move>(&entry->statements.back());
+  if (!result || !ir::equal(result->dst, m_callingConvention.returnValue())
+      || !isMovable(result->src, function.m_frame->name())) {
+    return {};
+  }
+
+  Callee res{result->src, formals, {}, 0};
+  auto onExpression = [&res](const ir::Expression &) { ++res.m_size; };
+  auto onStatement  = [&res](const ir::Statement &stm) {
+    ++res.m_size;
+    if (auto const label = boost::get<temp::Label>(&stm)) {
+      res.m_labels.push_back(*label);
+    }
+  };
+  walk(result->src, onExpression, onStatement);
+  return res;
+}
+
+bool Inliner::isMovable(const ir::Expression &exp,
+                        const temp::Label &name) const {
+  auto const isFrameSlot = [this](const ir::Expression &address) {
+    auto const binOperation = boost::get<ir::BinaryOperation>(&address);
+    return binOperation && binOperation->op == ir::BinOp::PLUS
+           && ir::equal(binOperation->left, m_callingConvention.framePointer())
+           && helpers::hasType<int>(binOperation->right);
+  };
+
+  return match(exp)(
+    [](int) { return true; },
+    [](const temp::Label &) { return true; },
+    // the frame pointer is only allowed in frame slot accesses, so that no
+    // nested function uses the frame
+    [](const temp::Register &reg) { return !temp::isMachineRegister(reg); },
+    [&](const ir::BinaryOperation &binOperation) {
+      return isMovable(binOperation.left, name)
+             && isMovable(binOperation.right, name);
+    },
+    [&](const ir::MemoryAccess &memAccess) {
+      return isFrameSlot(memAccess.address)
+             || isMovable(memAccess.address, name);
+    },
+    [&](const ir::ExpressionSequence &expSequence) {
+      return isMovable(expSequence.stm, name)
+             && isMovable(expSequence.exp, name);
+    },
+    [&](const ir::Call &call) {
+      // recursive functions are not inlined
+      auto const label = boost::get<temp::Label>(&call.fun);
+      return (!label || *label != name) && isMovable(call.fun, name)
+             && std::all_of(call.args.begin(), call.args.end(),
+                            [&](const ir::Expression &arg) {
+                              return isMovable(arg, name);
+                            });
+    },
+    [](ir::Placeholder) { return false; });
+}
+
+bool Inliner::isMovable(const ir::Statement &stm,
+                        const temp::Label &name) const {
+  return match(stm)(
+    [&](const ir::Sequence &sequence) {
+      return std::all_of(sequence.statements.begin(),
+                         sequence.statements.end(),
+                         [&](const ir::Statement &stm) {
+                           return isMovable(stm, name);
+                         });
+    },
+    [](const temp::Label &) { return true; },
+    [&](const ir::Jump &jump) { return isMovable(jump.exp, name); },
+    [&](const ir::ConditionalJump &cjump) {
+      return isMovable(cjump.left, name) && isMovable(cjump.right, name);
+    },
+    [&](const ir::Move &move) {
+      return isMovable(move.src, name) && isMovable(move.dst, name);
+    },
+    [&](const ir::ExpressionStatement &expStatement) {
+      return isMovable(expStatement.exp, name);
+    },
+    [](ir::Placeholder) { return false; });
+}
+
+ir::Expression Inliner::inlineCalls(const ir::Expression &exp,
+                                    const Callees &callees,
+                                    frame::Frame &caller,
+                                    Labels &inlined) const {
+  auto const recurse = [&](const ir::Expression &exp) {
+    return inlineCalls(exp, callees, caller, inlined);
+  };
+
+  return match(exp)(
+    [&](const ir::BinaryOperation &binOperation) -> ir::Expression {
+      return ir::BinaryOperation{binOperation.op, recurse(binOperation.left),
+                                 recurse(binOperation.right)};
+    },
+    [&](const ir::MemoryAccess &memAccess) -> ir::Expression {
+      return ir::MemoryAccess{recurse(memAccess.address)};
+    },
+    [&](const ir::ExpressionSequence &expSequence) -> ir::Expression {
+      return ir::ExpressionSequence{
+        inlineCalls(expSequence.stm, callees, caller, inlined),
+        recurse(expSequence.exp)};
+    },
+    [&](const ir::Call &call) -> ir::Expression {
+      ir::Call res{recurse(call.fun), {}};
+      res.args.reserve(call.args.size());
+      std::transform(call.args.begin(), call.args.end(),
+                     std::back_inserter(res.args), recurse);
+
+      auto const label = boost::get<temp::Label>(&res.fun);
+      auto const it    = label ? callees.find(*label) : callees.end();
+      if (it == callees.end()
+          || it->second.m_formals.size() != res.args.size()) {
+        return res;
+      }
+      inlined.insert(*label);
+      return expand(res, it->second, caller);
+    },
+    [](const auto &exp) -> ir::Expression { return exp; });
+}
+
+ir::Statement Inliner::inlineCalls(const ir::Statement &stm,
+                                   const Callees &callees,
+                                   frame::Frame &caller,
+                                   Labels &inlined) const {
+  auto const recurse = [&](const ir::Expression &exp) {
+    return inlineCalls(exp, callees, caller, inlined);
+  };
+
+  return match(stm)(
+    [&](const ir::Sequence &sequence) -> ir::Statement {
+      ir::Statements statements;
+      statements.reserve(sequence.statements.size());
+      for (const auto &stm : sequence.statements) {
+        statements.push_back(inlineCalls(stm, callees, caller, inlined));
+      }
+      return ir::Sequence{std::move(statements)};
+    },
+    [&](const ir::ConditionalJump &cjump) -> ir::Statement {
+      return ir::ConditionalJump{cjump.op, recurse(cjump.left),
+                                 recurse(cjump.right), *cjump.trueDest,
+                                 *cjump.falseDest};
+    },
+    [&](const ir::Move &move) -> ir::Statement {
+      return ir::Move{recurse(move.src), recurse(move.dst)};
+    },
+    [&](const ir::ExpressionStatement &expStatement) -> ir::Statement {
+      return ir::ExpressionStatement{recurse(expStatement.exp)};
+    },
+    [](const auto &stm) -> ir::Statement { return stm; });
+}
+
+ir::Expression Inliner::expand(const ir::Call &call, const Callee &callee,
+                               frame::Frame &caller) const {
+  Renaming renaming{{}, {}, {}, caller};
+  for (const auto &label : callee.m_labels) {
+    renaming.m_labels.emplace(label, m_tempMap.newLabel());
+  }
+
+  // the arguments are evaluated in order into the formals
+  ir::Statements statements;
+  auto const framePointer = m_callingConvention.framePointer();
+  for (size_t i = 0; i < call.args.size(); ++i) {
+    statements.emplace_back(ir::Move{
+      call.args[i],
+      rename(m_callingConvention.accessFrame(callee.m_formals[i], framePointer),
+             renaming)});
+  }
+  auto const result = m_tempMap.newTemp();
+  statements.emplace_back(ir::Move{rename(callee.m_body, renaming), result});
+  return ir::ExpressionSequence{ir::Sequence{std::move(statements)}, result};
+}
+
+ir::Expression Inliner::rename(const ir::Expression &exp,
+                               Renaming &renaming) const {
+  return match(exp)(
+    [](int i) -> ir::Expression { return i; },
+    [&](const temp::Label &label) -> ir::Expression {
+      return rename(label, renaming);
+    },
+    [&](const temp::Register &reg) -> ir::Expression {
+      auto const it = renaming.m_temps.find(reg);
+      if (it != renaming.m_temps.end()) {
+        return it->second;
+      }
+      auto const temp = m_tempMap.newTemp();
+      renaming.m_temps.emplace(reg, temp);
+      return temp;
+    },
+    [&](const ir::BinaryOperation &binOperation) -> ir::Expression {
+      return ir::BinaryOperation{binOperation.op,
+                                 rename(binOperation.left, renaming),
+                                 rename(binOperation.right, renaming)};
+    },
+    [&](const ir::MemoryAccess &memAccess) -> ir::Expression {
+      auto const binOperation =
+        boost::get<ir::BinaryOperation>(&memAccess.address);
+      auto const offset =
+        binOperation
+            && ir::equal(binOperation->left,
+                         m_callingConvention.framePointer())
+          ? boost::get<int>(&binOperation->right)
+          : nullptr;
+      if (!offset) {
+        return ir::MemoryAccess{rename(memAccess.address, renaming)};
+      }
+      // a callee frame slot becomes a local of the caller
+      auto it = renaming.m_slots.find(*offset);
+      if (it == renaming.m_slots.end()) {
+        it = renaming.m_slots
+               .emplace(*offset, m_callingConvention.accessFrame(
+                                   renaming.m_caller.allocateLocal(false),
+                                   m_callingConvention.framePointer()))
+               .first;
+      }
+      return it->second;
+    },
+    [&](const ir::ExpressionSequence &expSequence) -> ir::Expression {
+      return ir::ExpressionSequence{rename(expSequence.stm, renaming),
+                                    rename(expSequence.exp, renaming)};
+    },
+    [&](const ir::Call &call) -> ir::Expression {
+      ir::Call res{rename(call.fun, renaming), {}};
+      res.args.reserve(call.args.size());
+      for (const auto &arg : call.args) {
+        res.args.push_back(rename(arg, renaming));
+      }
+      return res;
+    },
+    [](ir::Placeholder placeholder) -> ir::Expression { return placeholder; });
+}
+
+ir::Statement Inliner::rename(const ir::Statement &stm,
+                              Renaming &renaming) const {
+  return match(stm)(
+    [&](const ir::Sequence &sequence) -> ir::Statement {
+      ir::Statements statements;
+      statements.reserve(sequence.statements.size());
+      for (const auto &stm : sequence.statements) {
+        statements.push_back(rename(stm, renaming));
+      }
+      return ir::Sequence{std::move(statements)};
+    },
+    [&](const temp::Label &label) -> ir::Statement {
+      return rename(label, renaming);
+    },
+    [&](const ir::Jump &jump) -> ir::Statement {
+      auto res = jump;
+      res.exp  = rename(jump.exp, renaming);
+      for (auto &label : res.jumps) {
+        label = rename(label, renaming);
+      }
+      return res;
+    },
+    [&](const ir::ConditionalJump &cjump) -> ir::Statement {
+      return ir::ConditionalJump{cjump.op, rename(cjump.left, renaming),
+                                 rename(cjump.right, renaming),
+                                 rename(*cjump.trueDest, renaming),
+                                 rename(*cjump.falseDest, renaming)};
+    },
+    [&](const ir::Move &move) -> ir::Statement {
+      return ir::Move{rename(move.src, renaming), rename(move.dst, renaming)};
+    },
+    [&](const ir::ExpressionStatement &expStatement) -> ir::Statement {
+      return ir::ExpressionStatement{rename(expStatement.exp, renaming)};
+    },
+    [](ir::Placeholder placeholder) -> ir::Statement { return placeholder; });
+}
+
+temp::Label Inliner::rename(const temp::Label &label,
+                            Renaming &renaming) const {
+  auto const it = renaming.m_labels.find(label);
+  return it == renaming.m_labels.end() ? label : it->second;
+}
+
+} // namespace tiger
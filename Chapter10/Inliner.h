@@ -0,0 +1,75 @@
+#pragma once
+#include "Fragment.h"
+#include "Frame.h"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace tiger {
+
+namespace frame {
+class CallingConvention;
+}
+
+// replaces calls to small functions with their bodies, before
+// canonicalization. A function is inlined when it's not recursive and its
+// frame is not used by functions nested in it, so that its frame variables can
+// become locals of the caller. Functions all of whose calls were inlined are
+// removed
+class Inliner {
+public:
+  Inliner(temp::Map &tempMap,
+          const frame::CallingConvention &callingConvention);
+
+  void inlineCalls(FragmentList &fragments) const;
+
+private:
+  // functions up to this size are always inlined
+  static constexpr size_t SMALL_SIZE = 32;
+  // functions called once are inlined up to this size
+  static constexpr size_t SINGLE_CALL_SIZE = 256;
+
+  struct Callee {
+    // the translated function body, without the parameter moves
+    ir::Expression m_body;
+    frame::AccessList m_formals;
+    // labels defined in the body
+    temp::Labels m_labels;
+    size_t m_size;
+  };
+
+  using Callees = std::unordered_map<temp::Label, Callee>;
+
+  // names of callee temps, frame slots and labels in the expanded copy
+  struct Renaming {
+    std::unordered_map<temp::Register, temp::Register> m_temps;
+    std::unordered_map<int, ir::Expression> m_slots;
+    std::unordered_map<temp::Label, temp::Label> m_labels;
+    frame::Frame &m_caller;
+  };
+
+  boost::optional<Callee> candidate(const FunctionFragment &function) const;
+
+  // whether exp may be moved to another frame
+  bool isMovable(const ir::Expression &exp, const temp::Label &name) const;
+  bool isMovable(const ir::Statement &stm, const temp::Label &name) const;
+
+  using Labels = std::unordered_set<temp::Label>;
+
+  // inlined gets the names of the inlined functions
+  ir::Expression inlineCalls(const ir::Expression &exp, const Callees &callees,
+                             frame::Frame &caller, Labels &inlined) const;
+  ir::Statement inlineCalls(const ir::Statement &stm, const Callees &callees,
+                            frame::Frame &caller, Labels &inlined) const;
+
+  ir::Expression expand(const ir::Call &call, const Callee &callee,
+                        frame::Frame &caller) const;
+
+  ir::Expression rename(const ir::Expression &exp, Renaming &renaming) const;
+  ir::Statement rename(const ir::Statement &stm, Renaming &renaming) const;
+  temp::Label rename(const temp::Label &label, Renaming &renaming) const;
+
+  temp::Map &m_tempMap;
+  const frame::CallingConvention &m_callingConvention;
+};
+
+} // namespace tiger
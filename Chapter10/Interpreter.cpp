@@ -0,0 +1,463 @@
+#include "Interpreter.h"
+#include "CallingConvention.h"
+#include "variantMatch.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace tiger {
+
+namespace {
+using Word = Runtime::Word;
+
+// where the blocks and frames are, far from any address the runtime's
+// strings may have
+constexpr Word HEAP_BASE  = Word{1} << 60;
+constexpr Word STACK_BASE = Word{1} << 61;
+// the distance between the frame pointers of nested calls
+constexpr Word FRAME_SPAN = Word{1} << 32;
+// the most words a frame may have below its frame pointer
+constexpr size_t MAX_LOCALS = size_t{1} << 20;
+
+Word calculate(ir::BinOp op, Word left, Word right) {
+  // wrapping around like the machine does
+  auto const uleft  = static_cast<std::uint64_t>(left);
+  auto const uright = static_cast<std::uint64_t>(right);
+  switch (op) {
+    case ir::BinOp::PLUS:
+      return static_cast<Word>(uleft + uright);
+    case ir::BinOp::MINUS:
+      return static_cast<Word>(uleft - uright);
+    case ir::BinOp::MUL:
+      return static_cast<Word>(uleft * uright);
+    case ir::BinOp::DIV:
+      if (right == 0) {
+        throw std::logic_error{"Division by zero"};
+      }
+      return left / right;
+    case ir::BinOp::AND:
+      return left & right;
+    case ir::BinOp::OR:
+      return left | right;
+    case ir::BinOp::LSHIFT:
+      return static_cast<Word>(uleft << (uright % 64));
+    case ir::BinOp::RSHIFT:
+      return static_cast<Word>(uleft >> (uright % 64));
+    case ir::BinOp::ARSHIFT:
+      return left >> (uright % 64);
+    case ir::BinOp::XOR:
+      return left ^ right;
+  }
+  throw std::logic_error{"Unknown binary operation"};
+}
+
+bool compare(ir::RelOp op, Word left, Word right) {
+  auto const uleft  = static_cast<std::uint64_t>(left);
+  auto const uright = static_cast<std::uint64_t>(right);
+  switch (op) {
+    case ir::RelOp::EQ:
+      return left == right;
+    case ir::RelOp::NE:
+      return left != right;
+    case ir::RelOp::LT:
+      return left < right;
+    case ir::RelOp::GT:
+      return left > right;
+    case ir::RelOp::LE:
+      return left <= right;
+    case ir::RelOp::GE:
+      return left >= right;
+    case ir::RelOp::ULT:
+      return uleft < uright;
+    case ir::RelOp::ULE:
+      return uleft <= uright;
+    case ir::RelOp::UGT:
+      return uleft > uright;
+    case ir::RelOp::UGE:
+      return uleft >= uright;
+  }
+  throw std::logic_error{"Unknown relation"};
+}
+} // namespace
+
+Interpreter::Interpreter(const frame::CallingConvention &callingConvention,
+                         std::istream &in, std::ostream &out) :
+    m_callingConvention{callingConvention},
+    m_runtime{in, out}, m_heapTop{HEAP_BASE} {}
+
+void Interpreter::addFunction(ir::Statements statements) {
+  auto const name = boost::get<temp::Label>(&statements.front());
+  if (!name) {
+    throw std::logic_error{"A function must start with its label"};
+  }
+
+  auto &function        = m_functions[*name];
+  function.m_statements = std::move(statements);
+  for (size_t i = 0; i < function.m_statements.size(); ++i) {
+    if (auto const label =
+          boost::get<temp::Label>(&function.m_statements[i])) {
+      function.m_labels.emplace(*label, i);
+    }
+  }
+}
+
+void Interpreter::addString(const StringFragment &string) {
+  m_stringValues.push_back(string.m_string);
+  m_strings[string.m_label] =
+    reinterpret_cast<Word>(m_stringValues.back().c_str());
+}
+
+InterpretResults Interpreter::run() {
+  auto const main = m_functions.find(temp::Label{"main"});
+  if (main == m_functions.end()) {
+    throw std::logic_error{"The program has no main function"};
+  }
+
+  // main gets an empty static link, like the runtime's main passes
+  enter(main->second, {0}, boost::none);
+  while (!m_stack.empty() && !m_runtime.exitStatus()) {
+    auto &activation = current();
+    if (activation.m_position == activation.m_function->m_statements.size()) {
+      leave();
+      continue;
+    }
+    execute(activation.m_function->m_statements[activation.m_position++]);
+  }
+
+  if (m_runtime.exitStatus()) {
+    m_results.m_value = *m_runtime.exitStatus();
+  }
+  return m_results;
+}
+
+void Interpreter::execute(const ir::Statement &statement) {
+  if (boost::get<temp::Label>(&statement)) {
+    return;
+  }
+
+  ++m_results.m_statements;
+  helpers::match(statement)(
+    [this](const ir::Jump &jump) {
+      auto const label = boost::get<temp::Label>(&jump.exp);
+      if (!label) {
+        throw std::logic_error{"Only jumps to labels can be interpreted"};
+      }
+      this->jump(*label);
+    },
+    [this](const ir::ConditionalJump &cjump) {
+      auto const left  = evaluate(cjump.left);
+      auto const right = evaluate(cjump.right);
+      jump(compare(cjump.op, left, right) ? *cjump.trueDest
+                                          : *cjump.falseDest);
+    },
+    [this](const ir::Move &move) {
+      if (auto const function = boost::get<ir::Call>(&move.src)) {
+        auto const result = boost::get<temp::Register>(&move.dst);
+        if (!result) {
+          throw std::logic_error{
+            "The result of a call must be moved to a register"};
+        }
+        call(*function, *result);
+        return;
+      }
+      assign(move.dst, evaluate(move.src));
+    },
+    [this](const ir::ExpressionStatement &expressionStatement) {
+      if (auto const function =
+            boost::get<ir::Call>(&expressionStatement.exp)) {
+        call(*function, boost::none);
+        return;
+      }
+      evaluate(expressionStatement.exp);
+    },
+    [](const auto & /* default */) {
+      throw std::logic_error{"Only canonical IR can be interpreted"};
+    });
+}
+
+void Interpreter::jump(const temp::Label &label) {
+  auto &activation = current();
+  auto const &labels = activation.m_function->m_labels;
+  auto const position = labels.find(label);
+  if (position != labels.end()) {
+    activation.m_position = position->second;
+    return;
+  }
+
+  // a tail call, which passes its arguments in registers and replaces the
+  // caller's frame
+  auto const function = m_functions.find(label);
+  if (function == m_functions.end()) {
+    throw std::logic_error{"Jump to an unknown label " + label.get()};
+  }
+  std::vector<Word> arguments;
+  for (const auto &reg : m_callingConvention.argumentRegisters()) {
+    auto const value = activation.m_registers.find(reg);
+    if (value == activation.m_registers.end()) {
+      break;
+    }
+    arguments.push_back(value->second);
+  }
+  auto const result = activation.m_result;
+  m_stack.pop_back();
+  enter(function->second, arguments, result);
+}
+
+Interpreter::Word Interpreter::evaluate(const ir::Expression &expression) {
+  return helpers::match(expression)(
+    [](int value) -> Word { return value; },
+    [this](const temp::Label &label) -> Word {
+      auto const string = m_strings.find(label);
+      if (string == m_strings.end()) {
+        throw std::logic_error{"Only the addresses of strings are known, not "
+                               + label.get()};
+      }
+      return string->second;
+    },
+    [this](const temp::Register &reg) -> Word {
+      auto const &registers = current().m_registers;
+      auto const value      = registers.find(reg);
+      if (value == registers.end()) {
+        throw std::logic_error{"Read of the unset register "
+                               + std::to_string(type_safe::get(reg))};
+      }
+      return value->second;
+    },
+    [this](const ir::BinaryOperation &binaryOperation) -> Word {
+      auto const left  = evaluate(binaryOperation.left);
+      auto const right = evaluate(binaryOperation.right);
+      return calculate(binaryOperation.op, left, right);
+    },
+    [this](const ir::MemoryAccess &memoryAccess) -> Word {
+      return memory(evaluate(memoryAccess.address));
+    },
+    [](const auto & /* default */) -> Word {
+      throw std::logic_error{"Only canonical IR can be interpreted"};
+    });
+}
+
+void Interpreter::assign(const ir::Expression &destination, Word value) {
+  helpers::match(destination)(
+    [&](const temp::Register &reg) { current().m_registers[reg] = value; },
+    [&](const ir::MemoryAccess &memoryAccess) {
+      memory(evaluate(memoryAccess.address)) = value;
+    },
+    [](const auto & /* default */) {
+      throw std::logic_error{"Only registers and memory can be assigned"};
+    });
+}
+
+void Interpreter::call(const ir::Call &call,
+                       boost::optional<temp::Register> result) {
+  ++m_results.m_calls;
+  auto const label = boost::get<temp::Label>(&call.fun);
+  if (!label) {
+    throw std::logic_error{"Only calls to labels can be interpreted"};
+  }
+
+  std::vector<Word> arguments;
+  arguments.reserve(call.args.size());
+  for (const auto &argument : call.args) {
+    arguments.push_back(evaluate(argument));
+  }
+
+  auto const function = m_functions.find(*label);
+  if (function != m_functions.end()) {
+    enter(function->second, arguments, result);
+    return;
+  }
+
+  auto const value = callRuntime(*label, arguments);
+  if (result) {
+    current().m_registers[*result] = value;
+  }
+}
+
+void Interpreter::enter(const Function &function,
+                        const std::vector<Word> &arguments,
+                        boost::optional<temp::Register> result) {
+  Activation activation{&function, 0, {}, {}, {}, result};
+  // the stack pointer points at the arguments passed in memory, which are
+  // above the frame pointer
+  auto const frame = framePointer(m_stack.size());
+  activation.m_registers[m_callingConvention.framePointer()] = frame;
+  activation.m_registers[m_callingConvention.stackPointer()] = frame;
+
+  auto const &argumentRegisters = m_callingConvention.argumentRegisters();
+  activation.m_arguments.resize(arguments.size());
+  for (size_t i = 0; i < arguments.size(); ++i) {
+    if (i < argumentRegisters.size()) {
+      activation.m_registers[argumentRegisters[i]] = arguments[i];
+    } else {
+      activation.m_arguments[i] = arguments[i];
+    }
+  }
+  m_stack.push_back(std::move(activation));
+}
+
+void Interpreter::leave() {
+  auto const &registers = current().m_registers;
+  auto const value = registers.find(m_callingConvention.returnValue());
+  auto const result = current().m_result;
+  if (result && value == registers.end()) {
+    throw std::logic_error{"A function didn't return a value"};
+  }
+
+  auto const returned = value == registers.end() ? 0 : value->second;
+  m_stack.pop_back();
+  if (m_stack.empty()) {
+    m_results.m_value = returned;
+  } else if (result) {
+    current().m_registers[*result] = returned;
+  }
+}
+
+Interpreter::Word
+  Interpreter::callRuntime(const temp::Label &function,
+                           const std::vector<Word> &arguments) {
+  auto const &name    = function.get();
+  auto const argument = [&](size_t i) {
+    if (i >= arguments.size()) {
+      throw std::logic_error{"Too few arguments to " + name};
+    }
+    return arguments[i];
+  };
+
+  if (name == "malloc") {
+    return malloc(argument(0));
+  }
+  if (name == "initArray") {
+    initArray(argument(0), argument(1));
+    return 0;
+  }
+  // the collected heap's functions, whose memory isn't collected here
+  if (name == "allocRecord") {
+    auto const descriptor = reinterpret_cast<const char *>(argument(0));
+    auto const fields     = static_cast<Word>(std::strlen(descriptor));
+    return malloc(fields * m_callingConvention.wordSize());
+  }
+  if (name == "allocArray") {
+    auto const size  = std::max<Word>(argument(0), 0);
+    auto const array = malloc(size * m_callingConvention.wordSize());
+    std::fill(m_heap.at(array).begin(), m_heap.at(array).end(), argument(1));
+    return array;
+  }
+  if (name == "stringCompare") {
+    return m_runtime.stringCompare(argument(0), argument(1));
+  }
+
+  // the standard library gets a static link first
+  if (name == "print") {
+    m_runtime.print(argument(1));
+    return 0;
+  }
+  if (name == "flush") {
+    m_runtime.flush();
+    return 0;
+  }
+  if (name == "getchar") {
+    return m_runtime.getchar();
+  }
+  if (name == "ord") {
+    return m_runtime.ord(argument(1));
+  }
+  if (name == "chr") {
+    return m_runtime.chr(argument(1));
+  }
+  if (name == "size") {
+    return m_runtime.size(argument(1));
+  }
+  if (name == "substring") {
+    return m_runtime.substring(argument(1), argument(2), argument(3));
+  }
+  if (name == "concat") {
+    return m_runtime.concat(argument(1), argument(2));
+  }
+  if (name == "not") {
+    return m_runtime.not_(argument(1));
+  }
+  if (name == "exit") {
+    m_runtime.exit(argument(1));
+    return 0;
+  }
+  throw std::logic_error{"Call to an unknown function " + name};
+}
+
+Interpreter::Word Interpreter::malloc(Word size) {
+  auto const wordSize = m_callingConvention.wordSize();
+  auto const words    = (std::max<Word>(size, 0) + wordSize - 1) / wordSize;
+  auto const address  = m_heapTop;
+  m_heap.emplace(address, std::vector<Word>(static_cast<size_t>(words)));
+  // leave a gap, so running past the end of a block is noticed
+  m_heapTop += (words + 1) * wordSize;
+
+  if (m_unfilled.size() == 64) {
+    m_unfilled.erase(m_unfilled.begin());
+  }
+  m_unfilled.push_back(address);
+  return address;
+}
+
+void Interpreter::initArray(Word size, Word init) {
+  auto const array = std::find_if(
+    m_unfilled.rbegin(), m_unfilled.rend(), [this, size](Word address) {
+      return static_cast<Word>(m_heap.at(address).size()) == size;
+    });
+  if (array == m_unfilled.rend()) {
+    return;
+  }
+
+  auto &words = m_heap.at(*array);
+  std::fill(words.begin(), words.end(), init);
+  m_unfilled.erase(std::prev(array.base()), m_unfilled.end());
+}
+
+Interpreter::Word Interpreter::framePointer(size_t depth) const {
+  // leaving room for the locals of the outermost frame
+  return STACK_BASE + static_cast<Word>(depth + 1) * FRAME_SPAN;
+}
+
+Interpreter::Word &Interpreter::memory(Word address) {
+  ++m_results.m_memoryAccesses;
+  auto const wordSize = m_callingConvention.wordSize();
+  if (address >= STACK_BASE) {
+    auto const depth =
+      static_cast<size_t>((address - STACK_BASE + FRAME_SPAN / 2) / FRAME_SPAN)
+      - 1;
+    auto const offset = address - framePointer(depth);
+    if (depth < m_stack.size() && offset % wordSize == 0) {
+      auto &activation = m_stack[depth];
+      if (offset >= 0) {
+        auto const index = static_cast<size_t>(offset / wordSize);
+        if (index < activation.m_arguments.size()) {
+          return activation.m_arguments[index];
+        }
+      } else {
+        // locals are allocated as they are used
+        auto const index = static_cast<size_t>(-offset / wordSize - 1);
+        if (index < MAX_LOCALS) {
+          if (index >= activation.m_locals.size()) {
+            activation.m_locals.resize(index + 1);
+          }
+          return activation.m_locals[index];
+        }
+      }
+    }
+  } else if (address >= HEAP_BASE) {
+    auto block = m_heap.upper_bound(address);
+    if (block != m_heap.begin()) {
+      --block;
+      auto const offset = address - block->first;
+      auto const index  = static_cast<size_t>(offset / wordSize);
+      if (offset % wordSize == 0 && index < block->second.size()) {
+        return block->second[index];
+      }
+    }
+  }
+  throw std::logic_error{"Invalid memory access at "
+                         + std::to_string(address)};
+}
+
+Interpreter::Activation &Interpreter::current() { return m_stack.back(); }
+
+} // namespace tiger
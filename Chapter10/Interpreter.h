@@ -0,0 +1,97 @@
+#pragma once
+#include "Fragment.h"
+#include "Program.h"
+#include "Runtime.h"
+#include <deque>
+#include <map>
+#include <unordered_map>
+
+namespace tiger {
+
+namespace frame {
+class CallingConvention;
+}
+
+// executes the canonical IR of a program, counting the statements, memory
+// accesses and calls it executes, which measures the work the program does
+// regardless of the machine. memory is made of words of the machine's size,
+// in blocks given by malloc and a frame for every call. reaching outside them
+// is an error. strings and the library are handled by a Runtime
+class Interpreter {
+public:
+  Interpreter(const frame::CallingConvention &callingConvention,
+              std::istream &in, std::ostream &out);
+
+  // the canonical statements of a function, starting with its label
+  void addFunction(ir::Statements statements);
+
+  void addString(const StringFragment &string);
+
+  // calls main, once all the fragments are added
+  InterpretResults run();
+
+private:
+  using Word = Runtime::Word;
+
+  struct Function {
+    ir::Statements m_statements;
+    std::unordered_map<temp::Label, size_t> m_labels;
+  };
+
+  struct Activation {
+    const Function *m_function;
+    // the next statement to execute
+    size_t m_position;
+    std::unordered_map<temp::Register, Word> m_registers;
+    // the words below the frame pointer
+    std::vector<Word> m_locals;
+    // the arguments which aren't passed in registers, above the frame pointer
+    std::vector<Word> m_arguments;
+    // the caller's register receiving the result
+    boost::optional<temp::Register> m_result;
+  };
+
+  void execute(const ir::Statement &statement);
+
+  void jump(const temp::Label &label);
+
+  Word evaluate(const ir::Expression &expression);
+
+  void assign(const ir::Expression &destination, Word value);
+
+  void call(const ir::Call &call, boost::optional<temp::Register> result);
+
+  // pushes the activation of function
+  void enter(const Function &function, const std::vector<Word> &arguments,
+             boost::optional<temp::Register> result);
+
+  void leave();
+
+  Word callRuntime(const temp::Label &function,
+                   const std::vector<Word> &arguments);
+
+  Word malloc(Word size);
+
+  void initArray(Word size, Word init);
+
+  Word framePointer(size_t depth) const;
+
+  Word &memory(Word address);
+
+  Activation &current();
+
+  const frame::CallingConvention &m_callingConvention;
+  Runtime m_runtime;
+  std::unordered_map<temp::Label, Function> m_functions;
+  std::deque<std::string> m_stringValues;
+  std::unordered_map<temp::Label, Word> m_strings;
+  // the blocks given by malloc, by their address
+  std::map<Word, std::vector<Word>> m_heap;
+  Word m_heapTop;
+  // blocks which may be arrays initArray hasn't filled, as in Runtime
+  std::vector<Word> m_unfilled;
+  std::vector<Activation> m_stack;
+  InterpretResults m_results;
+};
+
+} // namespace tiger
@@ -90,8 +90,8 @@ void LivenessAnalyser::calculateLiveness(const FlowGraph &flowGraph) {
       prevLiveOuts[v] = std::move(m_liveOuts[v]);
       // in[n] is all the variables in use[n], plus all the variables in
       // out[n] and not in def[n]
-      auto use = flowGraph.uses(v);
-      auto def = flowGraph.defs(v);
+      auto const &use = flowGraph.uses(v);
+      auto const &def = flowGraph.defs(v);
       assert(ranges::is_sorted(use) && "registers must be sorted");
       assert(ranges::is_sorted(def) && "registers must be sorted");
 #ifdef _MSC_VER
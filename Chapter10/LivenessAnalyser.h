@@ -45,6 +45,11 @@ public:
 
   const InterferenceGraph &interferenceGraph() const { return m_interferenceGraph; }
 
+  // registers live after the instruction at v is executed
+  const temp::Registers &liveOuts(FlowGraph::vertex_descriptor v) const {
+    return m_liveOuts[v];
+  }
+
 private:
   using CopiedRegisters =
     std::vector<std::pair<temp::Register, temp::Register>>;
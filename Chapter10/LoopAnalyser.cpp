@@ -0,0 +1,243 @@
+#include "LoopAnalyser.h"
+#include "FlowGraph.h"
+#include "irange.h"
+#include <algorithm>
+#include <numeric>
+
+namespace tiger {
+
+namespace {
+
+LoopAnalyser::Successors successors(const regalloc::FlowGraph &flowGraph) {
+  LoopAnalyser::Successors res(boost::num_vertices(flowGraph));
+  for (auto v : irange(boost::vertices(flowGraph))) {
+    for (auto u : irange(boost::adjacent_vertices(v, flowGraph))) {
+      res[v].push_back(u);
+    }
+  }
+  return res;
+}
+
+} // namespace
+
+LoopAnalyser::LoopAnalyser(const Successors &successors) :
+    m_immediateDominators(successors.size(), NONE),
+    m_dominatorChildren(successors.size()), m_preorder(successors.size()),
+    m_postorder(successors.size()), m_innermostLoops(successors.size(), NONE) {
+  if (successors.empty()) {
+    return;
+  }
+
+  calculateDominators(successors);
+  numberDominatorTree();
+  findLoops(successors);
+}
+
+LoopAnalyser::LoopAnalyser(const regalloc::FlowGraph &flowGraph) :
+    LoopAnalyser(successors(flowGraph)) {}
+
+bool LoopAnalyser::isReachable(Node node) const {
+  return m_immediateDominators[node] != NONE;
+}
+
+boost::optional<LoopAnalyser::Node>
+  LoopAnalyser::immediateDominator(Node node) const {
+  if (!isReachable(node)) {
+    return {};
+  }
+  return m_immediateDominators[node];
+}
+
+bool LoopAnalyser::dominates(Node dominator, Node node) const {
+  // dominator is an ancestor of node in the dominator tree
+  return isReachable(dominator) && isReachable(node)
+         && m_preorder[dominator] <= m_preorder[node]
+         && m_postorder[node] <= m_postorder[dominator];
+}
+
+const LoopAnalyser::Nodes &LoopAnalyser::dominatorChildren(Node node) const {
+  return m_dominatorChildren[node];
+}
+
+boost::optional<size_t> LoopAnalyser::innermostLoop(Node node) const {
+  if (m_innermostLoops[node] == NONE) {
+    return {};
+  }
+  return m_innermostLoops[node];
+}
+
+size_t LoopAnalyser::loopDepth(Node node) const {
+  auto const loop = m_innermostLoops[node];
+  return loop == NONE ? 0 : m_loops[loop].m_depth;
+}
+
+void LoopAnalyser::calculateDominators(const Successors &successors) {
+  // Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+  auto const size = successors.size();
+
+  // postorder of the reachable nodes, with an explicit stack so that deeply
+  // nested code doesn't overflow the call stack
+  Nodes postorder;
+  postorder.reserve(size);
+  std::vector<size_t> postorderNumbers(size, NONE);
+  std::vector<bool> visited(size);
+  std::vector<std::pair<Node, size_t>> stack{{0, 0}};
+  visited[0] = true;
+  while (!stack.empty()) {
+    auto &top = stack.back();
+    if (top.second < successors[top.first].size()) {
+      auto const next = successors[top.first][top.second++];
+      if (!visited[next]) {
+        visited[next] = true;
+        stack.emplace_back(next, 0);
+      }
+    } else {
+      postorderNumbers[top.first] = postorder.size();
+      postorder.push_back(top.first);
+      stack.pop_back();
+    }
+  }
+
+  Successors predecessors(size);
+  for (auto node : postorder) {
+    for (auto successor : successors[node]) {
+      predecessors[successor].push_back(node);
+    }
+  }
+
+  auto const intersect = [&](Node left, Node right) {
+    while (left != right) {
+      while (postorderNumbers[left] < postorderNumbers[right]) {
+        left = m_immediateDominators[left];
+      }
+      while (postorderNumbers[right] < postorderNumbers[left]) {
+        right = m_immediateDominators[right];
+      }
+    }
+    return left;
+  };
+
+  m_immediateDominators[0] = 0;
+  for (auto changed = true; changed;) {
+    changed = false;
+    // reverse postorder, skipping the entry
+    for (auto it = std::next(postorder.rbegin()); it != postorder.rend();
+         ++it) {
+      auto newDominator = NONE;
+      for (auto predecessor : predecessors[*it]) {
+        if (m_immediateDominators[predecessor] == NONE) {
+          continue;
+        }
+        newDominator = newDominator == NONE
+                         ? predecessor
+                         : intersect(predecessor, newDominator);
+      }
+      if (m_immediateDominators[*it] != newDominator) {
+        m_immediateDominators[*it] = newDominator;
+        changed                    = true;
+      }
+    }
+  }
+
+  for (auto node : postorder) {
+    if (node != 0) {
+      m_dominatorChildren[m_immediateDominators[node]].push_back(node);
+    }
+  }
+}
+
+void LoopAnalyser::numberDominatorTree() {
+  size_t preorder  = 0;
+  size_t postorder = 0;
+  std::vector<std::pair<Node, size_t>> stack{{0, 0}};
+  m_preorder[0] = preorder++;
+  while (!stack.empty()) {
+    auto &top = stack.back();
+    if (top.second < m_dominatorChildren[top.first].size()) {
+      auto const child  = m_dominatorChildren[top.first][top.second++];
+      m_preorder[child] = preorder++;
+      stack.emplace_back(child, 0);
+    } else {
+      m_postorder[top.first] = postorder++;
+      stack.pop_back();
+    }
+  }
+}
+
+void LoopAnalyser::findLoops(const Successors &successors) {
+  // an edge whose target dominates its source is a back edge, and the loop
+  // of a header is all the nodes which reach one of its back edges without
+  // passing through the header
+  Successors predecessors(successors.size());
+  std::vector<Nodes> latches(successors.size());
+  for (Node node = 0; node < successors.size(); ++node) {
+    if (!isReachable(node)) {
+      continue;
+    }
+    for (auto successor : successors[node]) {
+      predecessors[successor].push_back(node);
+      if (dominates(successor, node)) {
+        latches[successor].push_back(node);
+      }
+    }
+  }
+
+  std::vector<Loop> loops;
+  std::vector<bool> inLoop(successors.size());
+  for (Node header = 0; header < successors.size(); ++header) {
+    if (latches[header].empty()) {
+      continue;
+    }
+
+    Nodes nodes{header};
+    inLoop[header] = true;
+    Nodes worklist;
+    for (auto latch : latches[header]) {
+      if (!inLoop[latch]) {
+        inLoop[latch] = true;
+        nodes.push_back(latch);
+        worklist.push_back(latch);
+      }
+    }
+    while (!worklist.empty()) {
+      auto const node = worklist.back();
+      worklist.pop_back();
+      for (auto predecessor : predecessors[node]) {
+        if (!inLoop[predecessor]) {
+          inLoop[predecessor] = true;
+          nodes.push_back(predecessor);
+          worklist.push_back(predecessor);
+        }
+      }
+    }
+
+    for (auto node : nodes) {
+      inLoop[node] = false;
+    }
+    std::sort(nodes.begin(), nodes.end());
+    loops.push_back(Loop{header, std::move(nodes), boost::none, 1});
+  }
+
+  // an enclosing loop has more nodes than the loops nested in it
+  std::vector<size_t> order(loops.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&loops](size_t l, size_t r) {
+    return loops[l].m_nodes.size() > loops[r].m_nodes.size();
+  });
+
+  m_loops.reserve(loops.size());
+  for (auto index : order) {
+    auto loop         = std::move(loops[index]);
+    auto const parent = m_innermostLoops[loop.m_header];
+    if (parent != NONE) {
+      loop.m_parent = parent;
+      loop.m_depth  = m_loops[parent].m_depth + 1;
+    }
+    for (auto node : loop.m_nodes) {
+      m_innermostLoops[node] = m_loops.size();
+    }
+    m_loops.push_back(std::move(loop));
+  }
+}
+
+} // namespace tiger
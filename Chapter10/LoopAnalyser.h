@@ -0,0 +1,67 @@
+#pragma once
+#include <boost/optional.hpp>
+#include <vector>
+
+namespace tiger {
+
+namespace regalloc {
+class FlowGraph;
+}
+
+// computes the dominator tree and the natural loops of a control flow graph
+// whose entry is node 0
+class LoopAnalyser {
+public:
+  using Node       = size_t;
+  using Nodes      = std::vector<Node>;
+  using Successors = std::vector<Nodes>;
+
+  struct Loop {
+    Node m_header;
+    // sorted nodes of the loop, including those of nested loops
+    Nodes m_nodes;
+    boost::optional<size_t> m_parent;
+    // 1 for outermost loops
+    size_t m_depth;
+  };
+
+  LoopAnalyser(const Successors &successors);
+  LoopAnalyser(const regalloc::FlowGraph &flowGraph);
+
+  bool isReachable(Node node) const;
+
+  // the entry is its own immediate dominator, unreachable nodes have none
+  boost::optional<Node> immediateDominator(Node node) const;
+
+  // whether every path from the entry to node passes through dominator
+  bool dominates(Node dominator, Node node) const;
+
+  // children of node in the dominator tree
+  const Nodes &dominatorChildren(Node node) const;
+
+  // loops are ordered so that a loop comes after the loops containing it
+  const std::vector<Loop> &loops() const { return m_loops; }
+
+  // index of the innermost loop containing node
+  boost::optional<size_t> innermostLoop(Node node) const;
+
+  // number of loops containing node
+  size_t loopDepth(Node node) const;
+
+private:
+  void calculateDominators(const Successors &successors);
+  void numberDominatorTree();
+  void findLoops(const Successors &successors);
+
+  static constexpr auto NONE = static_cast<size_t>(-1);
+
+  std::vector<size_t> m_immediateDominators;
+  std::vector<Nodes> m_dominatorChildren;
+  // preorder and postorder numbers in the dominator tree
+  std::vector<size_t> m_preorder;
+  std::vector<size_t> m_postorder;
+  std::vector<Loop> m_loops;
+  std::vector<size_t> m_innermostLoops;
+};
+
+} // namespace tiger
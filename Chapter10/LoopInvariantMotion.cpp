@@ -0,0 +1,240 @@
+#include "LoopInvariantMotion.h"
+#include "Frame.h"
+#include "Simplifier.h"
+#include "variantMatch.h"
+#include <algorithm>
+
+namespace tiger {
+
+using helpers::hasType;
+using helpers::match;
+
+namespace {
+
+// whether it's worth computing exp into a temp
+bool isCandidate(const ir::Expression &exp) {
+  return match(exp)(
+    [](const ir::BinaryOperation &binOperation) {
+      // register + constant is folded into the addressing mode
+      return !(binOperation.op == ir::BinOp::PLUS
+               && hasType<temp::Register>(binOperation.left)
+               && hasType<int>(binOperation.right));
+    },
+    [](const ir::MemoryAccess &) { return true; },
+    [](const auto & /*default*/) { return false; });
+}
+
+} // namespace
+
+LoopInvariantMotion::LoopInvariantMotion(temp::Map &tempMap,
+                                         const temp::Register &framePointer) :
+    m_tempMap{tempMap},
+    m_framePointer{framePointer}, m_sideEffects{framePointer} {}
+
+ir::Statements LoopInvariantMotion::hoist(ir::Statements &&statements,
+                                          const frame::Frame &frame,
+                                          bool hasStaticLink) const {
+  auto const staticLinkOffset =
+    !hasStaticLink
+      ? boost::optional<int>{}
+      : match(frame.formals().front())(
+          [](const frame::InFrame &inFrame) -> boost::optional<int> {
+            return inFrame.m_offset;
+          },
+          [](const frame::InReg &) -> boost::optional<int> { return {}; });
+
+  // hoisting changes the blocks, so the loops are analysed again until there
+  // is nothing left to hoist
+  for (auto hoisted = true; hoisted;) {
+    hoisted = false;
+    CanonicalLoops canonicalLoops{statements};
+    auto const &loops = canonicalLoops.loops();
+    // inner loops first, so that what they hoist may be hoisted further out
+    // of the enclosing loops
+    for (auto it = loops.rbegin(); it != loops.rend() && !hoisted; ++it) {
+      hoisted = hoistLoop(statements, canonicalLoops, *it, staticLinkOffset);
+    }
+  }
+
+  return std::move(statements);
+}
+
+bool LoopInvariantMotion::hoistLoop(
+  ir::Statements &statements, const CanonicalLoops &canonicalLoops,
+  const LoopAnalyser::Loop &loop, boost::optional<int> staticLinkOffset) const {
+  auto const headerLabel = canonicalLoops.headerLabel(loop);
+  if (!headerLabel) {
+    return false;
+  }
+
+  auto inLoop = canonicalLoops.statementsOf(loop);
+  Context context{{}, {}, false, staticLinkOffset, {}};
+  for (size_t i = 0; i < statements.size(); ++i) {
+    if (!inLoop[i]) {
+      continue;
+    }
+    match(statements[i])(
+      [&](const ir::Move &move) {
+        context.m_hasCall |= !Simplifier::isPure(move.src);
+        match(move.dst)(
+          [&](const temp::Register &reg) {
+            context.m_definitions.push_back(reg);
+          },
+          [&](const ir::MemoryAccess &memAccess) {
+            context.m_stores.push_back(memAccess.address);
+          },
+          [](const auto & /*default*/) {});
+      },
+      [&](const ir::ExpressionStatement &expStatement) {
+        context.m_hasCall |= !Simplifier::isPure(expStatement.exp);
+      },
+      [](const auto & /*default*/) {});
+  }
+  std::sort(context.m_definitions.begin(), context.m_definitions.end());
+
+  for (size_t i = 0; i < statements.size(); ++i) {
+    if (inLoop[i]) {
+      statements[i] = rewrite(statements[i], context);
+    }
+  }
+
+  if (context.m_hoisted.empty()) {
+    return false;
+  }
+
+  ir::Statements preheader;
+  for (auto &hoisted : context.m_hoisted) {
+    preheader.emplace_back(
+      ir::Move{std::move(hoisted.m_expression), hoisted.m_temp});
+  }
+  CanonicalLoops::insertPreheader(statements, inLoop, *headerLabel,
+                                  std::move(preheader), m_tempMap);
+  return true;
+}
+
+ir::Statement LoopInvariantMotion::rewrite(const ir::Statement &stm,
+                                           Context &context) const {
+  return match(stm)(
+    [&](const ir::Move &move) -> ir::Statement {
+      auto src = rewrite(move.src, context);
+      return match(move.dst)(
+        [&](const ir::MemoryAccess &memAccess) -> ir::Statement {
+          auto address = rewrite(memAccess.address, context);
+          return ir::Move{src, ir::MemoryAccess{address}};
+        },
+        [&](const auto &dst) -> ir::Statement {
+          return ir::Move{src, dst};
+        });
+    },
+    [&](const ir::ExpressionStatement &expStatement) -> ir::Statement {
+      return ir::ExpressionStatement{rewrite(expStatement.exp, context)};
+    },
+    [&](const ir::ConditionalJump &cjump) -> ir::Statement {
+      return ir::ConditionalJump{cjump.op, rewrite(cjump.left, context),
+                                 rewrite(cjump.right, context),
+                                 *cjump.trueDest, *cjump.falseDest};
+    },
+    [](const auto &stm) -> ir::Statement { return stm; });
+}
+
+ir::Expression LoopInvariantMotion::rewrite(const ir::Expression &exp,
+                                            Context &context) const {
+  if (isCandidate(exp) && isInvariant(exp, context)) {
+    auto const found = std::find_if(
+      context.m_hoisted.begin(), context.m_hoisted.end(),
+      [&exp](const Hoisted &hoisted) {
+        return ir::equal(hoisted.m_expression, exp);
+      });
+    if (found != context.m_hoisted.end()) {
+      return found->m_temp;
+    }
+    auto const t = m_tempMap.newTemp();
+    context.m_hoisted.push_back({exp, t});
+    return t;
+  }
+
+  return match(exp)(
+    [&](const ir::BinaryOperation &binOperation) -> ir::Expression {
+      return ir::BinaryOperation{binOperation.op,
+                                 rewrite(binOperation.left, context),
+                                 rewrite(binOperation.right, context)};
+    },
+    [&](const ir::MemoryAccess &memAccess) -> ir::Expression {
+      return ir::MemoryAccess{rewrite(memAccess.address, context)};
+    },
+    [&](const ir::Call &call) -> ir::Expression {
+      ir::Call res{call.fun, {}};
+      res.args.reserve(call.args.size());
+      for (const auto &arg : call.args) {
+        res.args.push_back(rewrite(arg, context));
+      }
+      return res;
+    },
+    [](const auto &exp) -> ir::Expression { return exp; });
+}
+
+bool LoopInvariantMotion::isInvariant(const ir::Expression &exp,
+                                      const Context &context) const {
+  return match(exp)(
+    [](int) { return true; },
+    [](const temp::Label &) { return true; },
+    [&](const temp::Register &reg) {
+      return !std::binary_search(context.m_definitions.begin(),
+                                 context.m_definitions.end(), reg)
+             && (!temp::isMachineRegister(reg) || reg == m_framePointer);
+    },
+    [&](const ir::BinaryOperation &binOperation) {
+      // division by a value which might be 0 is not moved
+      auto const divisor = boost::get<int>(&binOperation.right);
+      return (binOperation.op != ir::BinOp::DIV || (divisor && *divisor != 0))
+             && isInvariant(binOperation.left, context)
+             && isInvariant(binOperation.right, context);
+    },
+    [&](const ir::MemoryAccess &memAccess) {
+      // loads are only moved from frames, which are always valid
+      auto const &address = memAccess.address;
+      auto const frameAddress =
+        isFramePointer(address, context)
+        || match(address)(
+             [&](const ir::BinaryOperation &binOperation) {
+               return binOperation.op == ir::BinOp::PLUS
+                      && hasType<int>(binOperation.right)
+                      && isFramePointer(binOperation.left, context);
+             },
+             [](const auto & /*default*/) { return false; });
+      return frameAddress && !context.m_hasCall
+             && isInvariant(address, context)
+             && std::none_of(context.m_stores.begin(), context.m_stores.end(),
+                             [&](const ir::Expression &store) {
+                               return m_sideEffects.mayAlias(store, address);
+                             });
+    },
+    [](const auto & /*default*/) { return false; });
+}
+
+bool LoopInvariantMotion::isFramePointer(const ir::Expression &exp,
+                                         const Context &context) const {
+  auto const offset = context.m_staticLinkOffset;
+  return match(exp)(
+    [&](const temp::Register &reg) { return reg == m_framePointer; },
+    [&](const ir::MemoryAccess &memAccess) {
+      // the static link of a frame holds the enclosing frame pointer
+      if (!offset) {
+        return false;
+      }
+      if (*offset == 0 && isFramePointer(memAccess.address, context)) {
+        return true;
+      }
+      return match(memAccess.address)(
+        [&](const ir::BinaryOperation &binOperation) {
+          auto const right = boost::get<int>(&binOperation.right);
+          return binOperation.op == ir::BinOp::PLUS && right
+                 && *right == *offset
+                 && isFramePointer(binOperation.left, context);
+        },
+        [](const auto & /*default*/) { return false; });
+    },
+    [](const auto & /*default*/) { return false; });
+}
+
+} // namespace tiger
@@ -0,0 +1,61 @@
+#pragma once
+#include "CanonicalLoops.h"
+#include "SideEffects.h"
+#include "Tree.h"
+
+namespace tiger {
+
+namespace frame {
+class Frame;
+}
+
+// moves expressions whose value doesn't change inside a loop of canonical IR
+// to a preheader, where they are computed once into temps. Only expressions
+// which can't fault are moved, as the loop body might not execute at all
+class LoopInvariantMotion {
+public:
+  LoopInvariantMotion(temp::Map &tempMap, const temp::Register &framePointer);
+
+  // hasStaticLink tells whether the first formal of frame is the static link
+  ir::Statements hoist(ir::Statements &&statements, const frame::Frame &frame,
+                       bool hasStaticLink) const;
+
+private:
+  struct Hoisted {
+    ir::Expression m_expression;
+    temp::Register m_temp;
+  };
+
+  struct Context {
+    // sorted registers written inside the loop
+    temp::Registers m_definitions;
+    // addresses written inside the loop
+    std::vector<ir::Expression> m_stores;
+    bool m_hasCall;
+    boost::optional<int> m_staticLinkOffset;
+    std::vector<Hoisted> m_hoisted;
+  };
+
+  // hoists the invariant expressions of a single loop, returns whether
+  // anything was hoisted
+  bool hoistLoop(ir::Statements &statements,
+                 const CanonicalLoops &canonicalLoops,
+                 const LoopAnalyser::Loop &loop,
+                 boost::optional<int> staticLinkOffset) const;
+
+  ir::Statement rewrite(const ir::Statement &stm, Context &context) const;
+
+  ir::Expression rewrite(const ir::Expression &exp, Context &context) const;
+
+  bool isInvariant(const ir::Expression &exp, const Context &context) const;
+
+  // whether exp holds the frame pointer of the current or an enclosing
+  // function, following the static links
+  bool isFramePointer(const ir::Expression &exp, const Context &context) const;
+
+  temp::Map &m_tempMap;
+  temp::Register m_framePointer;
+  SideEffects m_sideEffects;
+};
+
+} // namespace tiger
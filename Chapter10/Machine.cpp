@@ -0,0 +1,15 @@
+#include "Machine.h"
+#include "Executor.h"
+#include "ObjectWriter.h"
+
+namespace tiger {
+
+std::unique_ptr<assembly::ObjectWriter> Machine::createObjectWriter() const {
+  return nullptr;
+}
+
+std::unique_ptr<assembly::Executor> Machine::createExecutor() const {
+  return nullptr;
+}
+
+} // namespace tiger
@@ -1,14 +1,21 @@
 #pragma once
 #include "TempMap.h"
+#include <memory>
+#include <stdexcept>
 #include <vector>
 
 namespace tiger {
 namespace frame {
 class CallingConvention;
-}
+class Frame;
+} // namespace frame
 
 namespace assembly {
 class CodeGenerator;
+class Instruction;
+using Instructions = std::vector<Instruction>;
+class ObjectWriter;
+class Executor;
 } // namespace assembly
 
 class Machine {
@@ -22,5 +29,18 @@ public:
 
   virtual assembly::CodeGenerator &codeGenerator()             = 0;
   virtual const assembly::CodeGenerator &codeGenerator() const = 0;
+
+  // makes the instructions of a function ready to be assembled and run
+  virtual assembly::Instructions
+    lowerFunction(const assembly::Instructions & /* body */,
+                  const frame::Frame & /* frame */) const {
+    throw std::logic_error{"The machine's instructions can't be lowered"};
+  }
+
+  // encodes lowered fragments, null if the machine has no encoder
+  virtual std::unique_ptr<assembly::ObjectWriter> createObjectWriter() const;
+
+  // runs lowered fragments in this process, null if the machine can't
+  virtual std::unique_ptr<assembly::Executor> createExecutor() const;
 };
 } // namespace tiger
\ No newline at end of file
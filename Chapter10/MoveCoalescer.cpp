@@ -0,0 +1,170 @@
+#include "MoveCoalescer.h"
+#include "CallingConvention.h"
+#include "FlowGraph.h"
+#include "LivenessAnalyser.h"
+#include "irange.h"
+#include "variantMatch.h"
+#include <algorithm>
+
+namespace tiger {
+namespace regalloc {
+
+MoveCoalescer::MoveCoalescer(
+  const frame::CallingConvention &callingConvention) :
+    m_registers{callingConvention.callDefinedRegisters()} {
+  auto const &calleeSaved = callingConvention.calleeSavedRegisters();
+  m_registers.insert(m_registers.end(), calleeSaved.begin(), calleeSaved.end());
+  std::sort(m_registers.begin(), m_registers.end());
+  m_registers.erase(std::unique(m_registers.begin(), m_registers.end()),
+                    m_registers.end());
+}
+
+assembly::Instructions
+  MoveCoalescer::coalesce(assembly::Instructions &&instructions,
+                          const temp::Map &tempMap) const {
+  // coalescing changes liveness, which may allow more moves to be coalesced
+  while (coalesceOnce(instructions, tempMap)) {
+  }
+  return std::move(instructions);
+}
+
+bool MoveCoalescer::coalesceOnce(assembly::Instructions &instructions,
+                                 const temp::Map &tempMap) const {
+  FlowGraph flowGraph{instructions};
+  LivenessAnalyser livenessAnalyser{flowGraph, tempMap};
+  auto const &interferenceGraph = livenessAnalyser.interferenceGraph();
+
+  Neighbors neighbors;
+  for (auto v : irange(boost::vertices(interferenceGraph))) {
+    auto &adjacent = neighbors[interferenceGraph[v]];
+    for (auto u : irange(boost::adjacent_vertices(v, interferenceGraph))) {
+      adjacent.insert(interferenceGraph[u]);
+    }
+  }
+
+  std::unordered_map<temp::Register, temp::Register> aliases;
+  auto const alias = [&aliases](temp::Register reg) {
+    for (auto it = aliases.find(reg); it != aliases.end();
+         it      = aliases.find(reg)) {
+      reg = it->second;
+    }
+    return reg;
+  };
+
+  auto coalesced = false;
+  for (auto v : irange(boost::vertices(flowGraph))) {
+    if (!flowGraph.isMove(v)) {
+      continue;
+    }
+
+    auto const src = alias(flowGraph.uses(v).front());
+    auto const dst = alias(flowGraph.defs(v).front());
+    // a machine register keeps its name
+    auto const into = temp::isMachineRegister(dst) ? dst : src;
+    auto const from = into == dst ? src : dst;
+    if (from == into || temp::isMachineRegister(from)
+        || (temp::isMachineRegister(into)
+            && !std::binary_search(m_registers.begin(), m_registers.end(),
+                                   into))
+        || neighbors[from].count(into) != 0) {
+      continue;
+    }
+
+    if (temp::isMachineRegister(into) ? !george(from, into, neighbors)
+                                      : !briggs(from, into, neighbors)) {
+      continue;
+    }
+
+    // merge from into into
+    auto fromNeighbors = std::move(neighbors[from]);
+    neighbors.erase(from);
+    for (const auto &neighbor : fromNeighbors) {
+      neighbors[neighbor].erase(from);
+      neighbors[neighbor].insert(into);
+      neighbors[into].insert(neighbor);
+    }
+    aliases.emplace(from, into);
+    coalesced = true;
+  }
+
+  if (!coalesced) {
+    return false;
+  }
+
+  for (auto &instruction : instructions) {
+    helpers::match(instruction)(
+      [](assembly::Label & /*label*/) {},
+      [&alias](auto &inst) {
+        for (auto *registers :
+             {&inst.m_destinations, &inst.m_sources,
+              &inst.m_implicitDestinations, &inst.m_implicitSources}) {
+          std::transform(registers->begin(), registers->end(),
+                         registers->begin(), alias);
+        }
+      });
+  }
+
+  // moves between coalesced registers are now redundant
+  instructions.erase(
+    std::remove_if(instructions.begin(), instructions.end(),
+                   [](const assembly::Instruction &instruction) {
+                     return instruction.isMove()
+                            && instruction.sources()
+                                 == instruction.destinations();
+                   }),
+    instructions.end());
+
+  return true;
+}
+
+bool MoveCoalescer::isSignificant(const temp::Register &reg,
+                                  const Neighbors &neighbors) const {
+  if (temp::isMachineRegister(reg)) {
+    return true;
+  }
+  auto const it = neighbors.find(reg);
+  return it != neighbors.end() && it->second.size() >= m_registers.size();
+}
+
+bool MoveCoalescer::briggs(const temp::Register &left,
+                           const temp::Register &right,
+                           const Neighbors &neighbors) const {
+  // the merged node has fewer than K neighbors of significant degree
+  std::unordered_set<temp::Register> merged;
+  for (const auto &reg : {left, right}) {
+    auto const it = neighbors.find(reg);
+    if (it != neighbors.end()) {
+      merged.insert(it->second.begin(), it->second.end());
+    }
+  }
+
+  auto const significant =
+    std::count_if(merged.begin(), merged.end(), [&](const temp::Register &reg) {
+      return isSignificant(reg, neighbors);
+    });
+  return static_cast<size_t>(significant) < m_registers.size();
+}
+
+bool MoveCoalescer::george(const temp::Register &temp,
+                           const temp::Register &machine,
+                           const Neighbors &neighbors) const {
+  // every neighbor of temp already interferes with machine or is of
+  // insignificant degree
+  auto const it = neighbors.find(temp);
+  if (it == neighbors.end()) {
+    return true;
+  }
+
+  return std::all_of(
+    it->second.begin(), it->second.end(), [&](const temp::Register &reg) {
+      if (temp::isMachineRegister(reg) || !isSignificant(reg, neighbors)) {
+        return true;
+      }
+      auto const adjacent = neighbors.find(reg);
+      return adjacent != neighbors.end()
+             && adjacent->second.count(machine) != 0;
+    });
+}
+
+} // namespace regalloc
+} // namespace tiger
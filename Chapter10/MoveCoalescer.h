@@ -0,0 +1,50 @@
+#pragma once
+#include "Assembly.h"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace tiger {
+
+namespace frame {
+class CallingConvention;
+}
+
+namespace regalloc {
+
+// conservatively coalesces the source and destination of moves which don't
+// interfere, removing the moves. Two temps are coalesced using the Briggs
+// criterion and a temp is coalesced into a machine register using the George
+// criterion, so that the interference graph stays as colorable as it was
+class MoveCoalescer {
+public:
+  MoveCoalescer(const frame::CallingConvention &callingConvention);
+
+  assembly::Instructions coalesce(assembly::Instructions &&instructions,
+                                  const temp::Map &tempMap) const;
+
+private:
+  using Neighbors =
+    std::unordered_map<temp::Register, std::unordered_set<temp::Register>>;
+
+  // coalesces the moves of a single liveness analysis, returns whether any
+  // move was coalesced
+  bool coalesceOnce(assembly::Instructions &instructions,
+                    const temp::Map &tempMap) const;
+
+  // whether reg is of a degree which may prevent its neighbors from being
+  // colored
+  bool isSignificant(const temp::Register &reg,
+                     const Neighbors &neighbors) const;
+
+  bool briggs(const temp::Register &left, const temp::Register &right,
+              const Neighbors &neighbors) const;
+
+  bool george(const temp::Register &temp, const temp::Register &machine,
+              const Neighbors &neighbors) const;
+
+  // registers available for allocation
+  temp::Registers m_registers;
+};
+
+} // namespace regalloc
+} // namespace tiger
@@ -0,0 +1,20 @@
+#pragma once
+#include "Assembly.h"
+#include <ostream>
+
+namespace tiger {
+namespace assembly {
+
+// collects the machine code of the fragments of a program, once they are
+// lowered to run, and writes it as a relocatable object
+class ObjectWriter {
+public:
+  virtual ~ObjectWriter() = default;
+
+  virtual void addFragment(const Instructions &instructions) = 0;
+
+  virtual void write(std::ostream &out) const = 0;
+};
+
+} // namespace assembly
+} // namespace tiger
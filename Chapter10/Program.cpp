@@ -1,30 +1,44 @@
 #include "Program.h"
 #include "CallingConvention.h"
+#include "Bytecode.h"
 #include "Canonicalizer.h"
 #include "CodeGenerator.h"
+#include "ConstantPropagation.h"
+#include "DeadCodeEliminator.h"
 #include "EscapeAnalyser.h"
+#include "Executor.h"
 #include "ExpressionParser.h"
 #include "FlowGraph.h"
+#include "Interpreter.h"
+#include "Inliner.h"
 #include "LivenessAnalyser.h"
+#include "LoopAnalyser.h"
+#include "LoopInvariantMotion.h"
 #include "MachineRegistrar.h"
+#include "MoveCoalescer.h"
 #include "MachineRegistration.h"
+#include "ObjectWriter.h"
 #include "SemanticAnalyzer.h"
+#include "SideEffects.h"
+#include "Simplifier.h"
+#include "StaticLinkAnalyser.h"
+#include "StrengthReduction.h"
+#include "TailCallEliminator.h"
 #include "Translator.h"
+#include "ValueNumbering.h"
+#include "VirtualMachine.h"
 #include "irange.h"
 #include "printRange.h"
 #include <boost/graph/graph_utility.hpp>
 #include <boost/spirit/include/classic_position_iterator.hpp>
 #include <boost/spirit/include/support_multi_pass.hpp>
+#include <cstdio>
 #include <fstream>
-MSC_DIAG_OFF(4459)
-#include <range/v3/action/join.hpp>
-#include <range/v3/action/transform.hpp>
-MSC_DIAG_ON()
+#include <functional>
 #include <range/v3/algorithm/for_each.hpp>
-#include <range/v3/view/iota.hpp>
-#include <range/v3/view/join.hpp>
+#include <range/v3/to_container.hpp>
 #include <range/v3/view/transform.hpp>
-#include <range/v3/view/zip.hpp>
+#include <sstream>
 
 namespace tiger {
 
@@ -33,9 +47,18 @@ namespace qi     = spirit::qi;
 
 namespace detail {
 
+// receives the instructions of every fragment as soon as they are generated
+using FragmentSink =
+  std::function<void(const assembly::Instructions &, const temp::Map &)>;
+
+// receives the canonical IR of every function, after the IR optimizations, and
+// every string, which are then not translated to instructions
+using CanonicalSink = std::function<void(Fragment &&)>;
+
 template <typename Iterator>
-CompileResult compile(const std::string &arch, Iterator &first,
-                      const Iterator &last) {
+bool compile(const std::string &arch, Iterator &first, const Iterator &last,
+             const CompileOptions &options, const FragmentSink &sink,
+             const CanonicalSink &canonicalSink = {}) {
   using Grammer      = ExpressionParser<Iterator>;
   using Skipper      = Skipper<Iterator>;
   using ErrorHandler = ErrorHandler<Iterator>;
@@ -45,7 +68,7 @@ CompileResult compile(const std::string &arch, Iterator &first,
   Annotation annotation;
   Grammer grammer{errorHandler, annotation};
   Skipper skipper;
-  EscapeAnalyser escapeAnalyser;
+  EscapeAnalyser escapeAnalyser{options.m_preciseEscapes};
 
   try {
     ast::Expression ast;
@@ -59,107 +82,305 @@ CompileResult compile(const std::string &arch, Iterator &first,
 #endif
 
       escapeAnalyser.analyse(ast);
+      if (options.m_lambdaLifting) {
+        StaticLinkAnalyser{}.analyse(ast);
+      }
 
       auto machine            = createMachine(arch);
       auto &callingConvention = machine->callingConvention();
       temp::Map tempMap{machine->predefinedRegisters()};
-      SemanticAnalyzer semanticAnalyzer{errorHandler, annotation, tempMap,
-                                        callingConvention};
+      SemanticAnalyzer semanticAnalyzer{
+        errorHandler,
+        annotation,
+        tempMap,
+        callingConvention,
+        options.m_lambdaLifting,
+        options.m_display ? translator::NonLocalAccess::DISPLAY
+                          : translator::NonLocalAccess::STATIC_LINKS,
+        options.m_garbageCollection ? translator::Allocation::COLLECTED
+                                    : translator::Allocation::MALLOC};
       auto compiled = semanticAnalyzer.compile(ast);
+      if (options.m_inline) {
+        Inliner{tempMap, callingConvention}.inlineCalls(compiled);
+      }
 
-      Canonicalizer canonicalizer{tempMap};
+      boost::optional<SideEffects> sideEffects;
+      if (options.m_commutation) {
+        sideEffects = SideEffects{callingConvention.framePointer()};
+      }
+      Canonicalizer canonicalizer{tempMap, sideEffects};
+      TailCallEliminator tailCallEliminator{tempMap, callingConvention};
+      ConstantPropagation constantPropagation{tempMap};
+      Simplifier simplifier;
+      LoopInvariantMotion loopInvariantMotion{tempMap,
+                                              callingConvention.framePointer()};
+      StrengthReduction strengthReduction{tempMap,
+                                          callingConvention.framePointer()};
+      ValueNumbering valueNumbering{tempMap, callingConvention.framePointer()};
       auto &codeGenerator = machine->codeGenerator();
+      regalloc::DeadCodeEliminator deadCodeEliminator;
+      regalloc::MoveCoalescer moveCoalescer{callingConvention};
 
+      // fragments are translated one at a time and handed to the sink, so
+      // only one of them is kept at any time
       namespace rv = ranges::view;
-      namespace ra = ranges::action;
-      auto const fragments =
+      auto fragments =
         compiled | rv::transform([&](Fragment &fragment) {
           return helpers::match(fragment)(
             [&](FunctionFragment &function) {
               auto canonicalized =
                 canonicalizer.canonicalize(std::move(function.m_body));
-              auto translated =
-                codeGenerator.translateFunction(canonicalized, tempMap);
-              auto instructions = function.m_frame->procEntryExit3(
-                callingConvention.procEntryExit2(translated));
+              if (options.m_tailCalls) {
+                canonicalized = tailCallEliminator.eliminate(
+                  std::move(canonicalized), *function.m_frame);
+              }
+              if (options.m_constantPropagation) {
+                canonicalized =
+                  constantPropagation.propagate(std::move(canonicalized));
+              }
+              if (options.m_simplify) {
+                canonicalized = simplifier.simplify(std::move(canonicalized));
+              }
+              if (options.m_loopInvariantMotion) {
+                canonicalized = loopInvariantMotion.hoist(
+                  std::move(canonicalized), *function.m_frame,
+                  function.m_hasStaticLink);
+              }
+              if (options.m_strengthReduction) {
+                canonicalized =
+                  strengthReduction.reduce(std::move(canonicalized));
+              }
+              if (options.m_valueNumbering) {
+                canonicalized =
+                  valueNumbering.eliminate(std::move(canonicalized));
+              }
+              if (canonicalSink) {
+                canonicalSink(FunctionFragment{
+                  ir::Sequence{std::move(canonicalized)}, function.m_frame,
+                  function.m_hasStaticLink});
+                return assembly::Instructions{};
+              }
+              auto translated = codeGenerator.translateFunction(
+                canonicalized, tempMap, options.m_orderByNeed);
+              auto body = callingConvention.procEntryExit2(translated);
+              if (options.m_deadCode) {
+                body = deadCodeEliminator.eliminate(std::move(body), tempMap);
+              }
+              if (options.m_coalesce) {
+                body = moveCoalescer.coalesce(std::move(body), tempMap);
+              }
+              auto instructions = function.m_frame->procEntryExit3(body);
+              if (options.m_runnable) {
+                instructions =
+                  machine->lowerFunction(instructions, *function.m_frame);
+              }
 
               return instructions;
             },
             [&](StringFragment &str) {
+              if (canonicalSink) {
+                canonicalSink(std::move(str));
+                return assembly::Instructions{};
+              }
               return codeGenerator.translateString(str.m_label, str.m_string,
                                                    tempMap);
             });
         });
 
-      auto const flowGraphs =
-        fragments
-        | rv::transform([](const assembly::Instructions &instructions) {
-            return regalloc::FlowGraph{instructions};
-          })
-        | ranges::to_vector;
-
-      auto const toString = helpers::overload(
-        [&tempMap](const temp::Register &reg) { return *tempMap.lookup(reg); },
-        [](size_t i) { return std::to_string(i); });
-
-      auto instructions =
-        flowGraphs | rv::transform([&](const regalloc::FlowGraph &flowGraph) {
-          return irange(boost::vertices(flowGraph))
-                 | rv::transform([&](auto v) {
-                     std::stringstream sst;
-                     flowGraph[v].print(sst, tempMap);
-                     sst << "; successors: ";
-                     helpers::printRange(
-                       sst, irange(boost::adjacent_vertices(v, flowGraph)),
-                       toString);
-                     sst << " uses: ";
-                     helpers::printRange(sst, flowGraph.uses(v), toString);
-                     sst << " defs: ";
-                     helpers::printRange(sst, flowGraph.defs(v), toString);
-                     sst << " isMove: " << std::boolalpha
-                         << flowGraph.isMove(v);
-                     return sst.str();
-                   });
-        })
-        | ra::join;
-
-      auto const interferenceGraphs =
-        flowGraphs
-        | rv::transform([&toString,
-                         &tempMap](const regalloc::FlowGraph &flowGraph) {
-            regalloc::LivenessAnalyser livenessAnalyser{flowGraph, tempMap};
-            auto const &interferenceGraph =
-              livenessAnalyser.interferenceGraph();
-            auto const vertexToString =
-              [&interferenceGraph, &toString](
-                const regalloc::InterferenceGraph::vertex_descriptor &v) {
-                return toString(interferenceGraph[v]);
-              };
-
-            return irange(boost::vertices(interferenceGraph))
-                   | rv::transform([&vertexToString,
-                                    &interferenceGraph](const auto &v) {
-                       return std::make_pair(
-                         vertexToString(v),
-                         irange(boost::adjacent_vertices(v, interferenceGraph))
-                           | rv::transform(vertexToString)
-                           | ranges::to_<std::set>());
-                     })
-                   | ranges::to_<
-                       std::map<std::string, std::set<std::string>>>();
-          })
-        | ranges::to_vector;
-      return CompileResults{instructions | rv::join('\n'), interferenceGraphs};
+      ranges::for_each(fragments,
+                       [&](const assembly::Instructions &instructions) {
+                         if (!canonicalSink) {
+                           sink(instructions, tempMap);
+                         }
+                       });
+
+      return true;
     }
 
     errorHandler("Parsing failed", "", first);
   } catch (const std::exception &e) { std::cerr << e.what(); }
+  return false;
+}
+
+template <typename Iterator>
+bool compile(const std::string &arch, Iterator &first, const Iterator &last,
+             std::ostream &out, const CompileOptions &options) {
+  auto const stream = [&out](const assembly::Instructions &instructions,
+                             const temp::Map &tempMap) {
+    assembly::print(out, instructions, tempMap);
+  };
+  return compile(arch, first, last, options, stream) && out;
+}
+
+template <typename Iterator>
+CompileResult compile(const std::string &arch, Iterator &first,
+                      const Iterator &last, const CompileOptions &options) {
+  namespace rv = ranges::view;
+
+  CompileResults results;
+  if (!options.m_diagnostics) {
+    std::ostringstream assembly;
+    if (!compile(arch, first, last, assembly, options)) {
+      return {};
+    }
+    results.m_assembly = assembly.str();
+    return results;
+  }
+
+  auto const collect = [&results](const assembly::Instructions &instructions,
+                                  const temp::Map &tempMap) {
+    regalloc::FlowGraph flowGraph{instructions};
+
+    auto const toString = helpers::overload(
+      [&tempMap](const temp::Register &reg) { return *tempMap.lookup(reg); },
+      [](size_t i) { return std::to_string(i); });
+
+    ranges::for_each(irange(boost::vertices(flowGraph)), [&](auto v) {
+      std::stringstream sst;
+      if (!results.m_assembly.empty()) {
+        sst << '\n';
+      }
+      flowGraph[v].print(sst, tempMap);
+      sst << "; successors: ";
+      helpers::printRange(sst, irange(boost::adjacent_vertices(v, flowGraph)),
+                          toString);
+      sst << " uses: ";
+      helpers::printRange(sst, flowGraph.uses(v), toString);
+      sst << " defs: ";
+      helpers::printRange(sst, flowGraph.defs(v), toString);
+      sst << " isMove: " << std::boolalpha << flowGraph.isMove(v);
+      results.m_assembly += sst.str();
+    });
+
+    regalloc::LivenessAnalyser livenessAnalyser{flowGraph, tempMap};
+    auto const &interferenceGraph = livenessAnalyser.interferenceGraph();
+    auto const vertexToString =
+      [&interferenceGraph,
+       &toString](const regalloc::InterferenceGraph::vertex_descriptor &v) {
+        return toString(interferenceGraph[v]);
+      };
+    results.m_interferenceGraphs.push_back(
+      irange(boost::vertices(interferenceGraph))
+      | rv::transform([&vertexToString, &interferenceGraph](const auto &v) {
+          return std::make_pair(
+            vertexToString(v),
+            irange(boost::adjacent_vertices(v, interferenceGraph))
+              | rv::transform(vertexToString) | ranges::to_<std::set>());
+        })
+      | ranges::to_<CompileResults::InterferenceGraph>());
+
+    LoopAnalyser loopAnalyser{flowGraph};
+    results.m_loopDepths.push_back(
+      irange(boost::vertices(flowGraph))
+      | rv::transform([&loopAnalyser](auto v) {
+          return loopAnalyser.loopDepth(v);
+        })
+      | ranges::to_vector);
+  };
+
+  if (!compile(arch, first, last, options, collect)) {
+    return {};
+  }
+  return results;
+}
+
+template <typename Iterator>
+bool compileObject(const std::string &arch, Iterator &first,
+                   const Iterator &last, std::ostream &out,
+                   CompileOptions options) {
+  try {
+    auto const objectWriter = createMachine(arch)->createObjectWriter();
+    if (!objectWriter) {
+      std::cerr << "can't encode " << arch << " instructions\n";
+      return false;
+    }
+
+    options.m_runnable = true;
+    auto const encode = [&objectWriter](
+                          const assembly::Instructions &instructions,
+                          const temp::Map & /* tempMap */) {
+      objectWriter->addFragment(instructions);
+    };
+    if (!compile(arch, first, last, options, encode)) {
+      return false;
+    }
+    objectWriter->write(out);
+    return static_cast<bool>(out);
+  } catch (const std::exception &e) { std::cerr << e.what(); }
+  return false;
+}
+
+template <typename Iterator>
+RunResult run(const std::string &arch, Iterator &first, const Iterator &last,
+              std::istream &in, std::ostream &out, CompileOptions options) {
+  try {
+    auto const executor = createMachine(arch)->createExecutor();
+    if (!executor) {
+      std::cerr << "can't run " << arch << " instructions here\n";
+      return {};
+    }
+
+    options.m_runnable = true;
+    auto const load = [&executor](const assembly::Instructions &instructions,
+                                  const temp::Map & /* tempMap */) {
+      executor->addFragment(instructions);
+    };
+    if (!compile(arch, first, last, options, load)) {
+      return {};
+    }
+    Runtime runtime{in, out};
+    return executor->run(runtime);
+  } catch (const std::exception &e) { std::cerr << e.what(); }
   return {};
-} // namespace detail
-} // namespace detail
+}
 
-CompileResult compileFile(const std::string &arch,
-                          const std::string &filename) {
+// adds the canonical fragments to target, an Interpreter or a
+// bytecode::Compiler
+template <typename Target> CanonicalSink loadInto(Target &target) {
+  return [&target](Fragment &&fragment) {
+    helpers::match(fragment)(
+      [&](FunctionFragment &function) {
+        target.addFunction(
+          std::move(boost::get<ir::Sequence>(function.m_body).statements));
+      },
+      [&](const StringFragment &string) { target.addString(string); });
+  };
+}
+
+template <typename Iterator>
+InterpretResult interpret(const std::string &arch, Iterator &first,
+                          const Iterator &last, std::istream &in,
+                          std::ostream &out, const CompileOptions &options) {
+  try {
+    auto const machine = createMachine(arch);
+    Interpreter interpreter{machine->callingConvention(), in, out};
+    if (!compile(arch, first, last, options, {}, loadInto(interpreter))) {
+      return {};
+    }
+    return interpreter.run();
+  } catch (const std::exception &e) { std::cerr << e.what(); }
+  return {};
+}
+
+template <typename Iterator>
+RunResult runBytecode(const std::string &arch, Iterator &first,
+                      const Iterator &last, Runtime &runtime,
+                      const CompileOptions &options) {
+  try {
+    auto const machine = createMachine(arch);
+    bytecode::Compiler compiler{machine->callingConvention()};
+    if (!compile(arch, first, last, options, {}, loadInto(compiler))) {
+      return {};
+    }
+    VirtualMachine virtualMachine{compiler.finish()};
+    return virtualMachine.run(runtime);
+  } catch (const std::exception &e) { std::cerr << e.what(); }
+  return {};
+}
+
+// calls compile with the range of the file's contents
+template <typename Result, typename Compile>
+Result compileFile(const std::string &filename, Compile &&compile) {
   std::ifstream inputFile(filename, std::ios::in);
   if (!inputFile) {
     std::cerr << "failed to read from " << filename << "\n";
@@ -174,10 +395,12 @@ CompileResult compileFile(const std::string &arch,
                  filename};
   Iterator last;
 
-  return detail::compile(arch, first, last);
+  return compile(first, last);
 }
 
-CompileResult compile(const std::string &arch, const std::string &string) {
+// calls compile with the range of string
+template <typename Compile>
+auto compileString(const std::string &string, Compile &&compile) {
   using ForwardIterator = std::string::const_iterator;
   using Iterator        = spirit::classic::position_iterator2<ForwardIterator>;
 
@@ -185,7 +408,86 @@ CompileResult compile(const std::string &arch, const std::string &string) {
                  "STRING"};
   Iterator last;
 
-  return detail::compile(arch, first, last);
+  return compile(first, last);
+}
+
+// calls compile with a stream writing to filename, which is removed if
+// compilation fails
+template <typename Compile>
+bool writeFile(const std::string &filename, std::ios::openmode mode,
+               Compile &&compile) {
+  std::ofstream outputFile(filename, mode | std::ios::out | std::ios::trunc);
+  if (!outputFile) {
+    std::cerr << "failed to write to " << filename << "\n";
+    return false;
+  }
+
+  if (!compile(outputFile)) {
+    // don't leave a partial file behind
+    outputFile.close();
+    std::remove(filename.c_str());
+    return false;
+  }
+  return true;
+}
+} // namespace detail
+
+CompileResult compileFile(const std::string &arch,
+                          const std::string &filename,
+                          const CompileOptions &options /*= {}*/) {
+  return detail::compileFile<CompileResult>(
+    filename, [&](auto &first, const auto &last) {
+      return detail::compile(arch, first, last, options);
+    });
+}
+
+bool compileFile(const std::string &arch, const std::string &filename,
+                 std::ostream &out, const CompileOptions &options /*= {}*/) {
+  return detail::compileFile<bool>(
+    filename, [&](auto &first, const auto &last) {
+      return detail::compile(arch, first, last, out, options);
+    });
+}
+
+bool compileFile(const std::string &arch, const std::string &filename,
+                 const std::string &outputFilename,
+                 const CompileOptions &options /*= {}*/) {
+  return detail::writeFile(outputFilename, {}, [&](std::ostream &out) {
+    return compileFile(arch, filename, out, options);
+  });
+}
+
+CompileResult compile(const std::string &arch, const std::string &string,
+                      const CompileOptions &options /*= {}*/) {
+  return detail::compileString(string, [&](auto &first, const auto &last) {
+    return detail::compile(arch, first, last, options);
+  });
+}
+
+bool compile(const std::string &arch, const std::string &string,
+             std::ostream &out, const CompileOptions &options /*= {}*/) {
+  return detail::compileString(string, [&](auto &first, const auto &last) {
+    return detail::compile(arch, first, last, out, options);
+  });
+}
+
+bool compileObject(const std::string &arch, const std::string &string,
+                   std::ostream &out, const CompileOptions &options /*= {}*/) {
+  return detail::compileString(string, [&](auto &first, const auto &last) {
+    return detail::compileObject(arch, first, last, out, options);
+  });
+}
+
+bool compileObjectFile(const std::string &arch, const std::string &filename,
+                       const std::string &outputFilename,
+                       const CompileOptions &options /*= {}*/) {
+  return detail::writeFile(
+    outputFilename, std::ios::binary, [&](std::ostream &out) {
+      return detail::compileFile<bool>(
+        filename, [&](auto &first, const auto &last) {
+          return detail::compileObject(arch, first, last, out, options);
+        });
+    });
 }
 
 std::ostream &operator<<(std::ostream &ost, const CompileResults &results) {
@@ -205,4 +507,71 @@ std::ostream &operator<<(std::ostream &ost, const CompileResults &results) {
   return ost;
 }
 
+std::ostream &operator<<(std::ostream &ost, const InterpretResults &results) {
+  return ost << "value " << results.m_value << ", " << results.m_statements
+             << " statements, " << results.m_memoryAccesses
+             << " memory accesses, " << results.m_calls << " calls";
+}
+
+RunResult run(const std::string &arch, const std::string &string,
+              std::istream &in, std::ostream &out,
+              const CompileOptions &options /*= {}*/) {
+  return detail::compileString(string, [&](auto &first, const auto &last) {
+    return detail::run(arch, first, last, in, out, options);
+  });
+}
+
+RunResult runFile(const std::string &arch, const std::string &filename,
+                  std::istream &in, std::ostream &out,
+                  const CompileOptions &options /*= {}*/) {
+  return detail::compileFile<RunResult>(
+    filename, [&](auto &first, const auto &last) {
+      return detail::run(arch, first, last, in, out, options);
+    });
+}
+
+InterpretResult interpret(const std::string &arch, const std::string &string,
+                          std::istream &in, std::ostream &out,
+                          const CompileOptions &options /*= {}*/) {
+  return detail::compileString(string, [&](auto &first, const auto &last) {
+    return detail::interpret(arch, first, last, in, out, options);
+  });
+}
+
+InterpretResult interpretFile(const std::string &arch,
+                              const std::string &filename, std::istream &in,
+                              std::ostream &out,
+                              const CompileOptions &options /*= {}*/) {
+  return detail::compileFile<InterpretResult>(
+    filename, [&](auto &first, const auto &last) {
+      return detail::interpret(arch, first, last, in, out, options);
+    });
+}
+
+RunResult runBytecode(const std::string &arch, const std::string &string,
+                      std::istream &in, std::ostream &out,
+                      const CompileOptions &options /*= {}*/) {
+  Runtime runtime{in, out};
+  return runBytecode(arch, string, runtime, options);
+}
+
+RunResult runBytecode(const std::string &arch, const std::string &string,
+                      Runtime &runtime,
+                      const CompileOptions &options /*= {}*/) {
+  return detail::compileString(string, [&](auto &first, const auto &last) {
+    return detail::runBytecode(arch, first, last, runtime, options);
+  });
+}
+
+RunResult runBytecodeFile(const std::string &arch,
+                          const std::string &filename, std::istream &in,
+                          std::ostream &out,
+                          const CompileOptions &options /*= {}*/) {
+  Runtime runtime{in, out};
+  return detail::compileFile<RunResult>(
+    filename, [&](auto &first, const auto &last) {
+      return detail::runBytecode(arch, first, last, runtime, options);
+    });
+}
+
 } // namespace tiger
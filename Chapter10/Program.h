@@ -1,6 +1,8 @@
 #pragma once
 #include "TempRegister.h"
 #include <boost/optional/optional_fwd.hpp>
+#include <cstdint>
+#include <istream>
 #include <map>
 #include <ostream>
 #include <set>
@@ -9,10 +11,17 @@
 
 namespace tiger {
 
+class Runtime;
+
 struct CompileResults {
+  // with diagnostics, every instruction is followed by its successors, uses,
+  // defs and whether it is a move
   std::string m_assembly;
   using InterferenceGraph = std::map<std::string, std::set<std::string>>;
+  // the following are only computed with diagnostics
   std::vector<InterferenceGraph> m_interferenceGraphs;
+  // loop nesting depth of every instruction, per fragment
+  std::vector<std::vector<size_t>> m_loopDepths;
 
   friend std::ostream &operator<<(std::ostream &ost,
                                   const CompileResults &results);
@@ -20,8 +29,139 @@ struct CompileResults {
 
 using CompileResult = boost::optional<CompileResults>;
 
-CompileResult compileFile(const std::string &arch, const std::string &filename);
+// the status a program passed to exit, or else its value
+using RunResult = boost::optional<std::int64_t>;
+
+// what the interpreter executed to run a program
+struct InterpretResults {
+  // the status the program passed to exit, or else its value
+  std::int64_t m_value = 0;
+  // labels aren't counted
+  size_t m_statements = 0;
+  // loads and stores
+  size_t m_memoryAccesses = 0;
+  // of both the program's and the runtime's functions
+  size_t m_calls = 0;
+
+  friend std::ostream &operator<<(std::ostream &ost,
+                                  const InterpretResults &results);
+};
+
+using InterpretResult = boost::optional<InterpretResults>;
+
+struct CompileOptions {
+  // annotate the assembly with flow graph attributes and compute interference
+  // graphs and loop depths, which tests examine. otherwise only assembly is
+  // emitted
+  bool m_diagnostics = false;
+  // give every temp a slot in the frame and add prologs and epilogs, so the
+  // assembly can be assembled and run. only x64 supports it
+  bool m_runnable = false;
+  // let only variables used by nested functions escape, keeping a register
+  // copy of those which are never assigned
+  bool m_preciseEscapes = false;
+  // drop the static link of functions which don't use enclosing frames
+  bool m_lambdaLifting = false;
+  // reach the frames of enclosing functions through displays instead of
+  // static link chains
+  bool m_display = false;
+  // replace calls to small functions with their bodies
+  bool m_inline = false;
+  // compile calls in tail position as jumps, turning self recursion into loops
+  bool m_tailCalls = false;
+  // fold constants and remove dead branches in the canonical IR
+  bool m_simplify = false;
+  // propagate constants through branches, using SSA form
+  bool m_constantPropagation = false;
+  // compute values which don't change inside a loop before entering it
+  bool m_loopInvariantMotion = false;
+  // replace multiplications of loop counters with additions
+  bool m_strengthReduction = false;
+  // reuse values computed earlier in the same basic block
+  bool m_valueNumbering = false;
+  // analyse side effects instead of spilling to temps when canonicalizing
+  bool m_commutation = false;
+  // evaluate the operand needing more registers first
+  bool m_orderByNeed = false;
+  // remove unreachable instructions and instructions with unused results
+  bool m_deadCode = false;
+  // coalesce the registers of moves when it doesn't hurt coloring
+  bool m_coalesce = false;
+  // allocate records and arrays with the runtime's allocRecord and
+  // allocArray, describing which of their fields are pointers, so they can be
+  // garbage collected. only the bytecode virtual machine collects them
+  bool m_garbageCollection = false;
+};
+
+CompileResult compileFile(const std::string &arch, const std::string &filename,
+                          const CompileOptions &options = {});
+
+CompileResult compile(const std::string &arch, const std::string &string,
+                      const CompileOptions &options = {});
+
+// write the assembly to out as every fragment is compiled, instead of keeping
+// it in memory, and return whether compilation succeeded
+bool compileFile(const std::string &arch, const std::string &filename,
+                 std::ostream &out, const CompileOptions &options = {});
+
+bool compile(const std::string &arch, const std::string &string,
+             std::ostream &out, const CompileOptions &options = {});
+
+// writes the assembly to outputFilename, usually a .s file, which is removed
+// if compilation fails
+bool compileFile(const std::string &arch, const std::string &filename,
+                 const std::string &outputFilename,
+                 const CompileOptions &options = {});
+
+// writes the machine code to out as a relocatable object, instead of the
+// assembly, which is made runnable as by m_runnable. only x64 supports it
+bool compileObject(const std::string &arch, const std::string &string,
+                   std::ostream &out, const CompileOptions &options = {});
+
+// writes the object to outputFilename, usually a .o file, which is removed if
+// compilation fails
+bool compileObjectFile(const std::string &arch, const std::string &filename,
+                       const std::string &outputFilename,
+                       const CompileOptions &options = {});
+
+// compiles the program and runs it in this process, made runnable as by
+// m_runnable, with in and out as its standard input and output. only x64 on
+// Linux supports it
+RunResult run(const std::string &arch, const std::string &string,
+              std::istream &in, std::ostream &out,
+              const CompileOptions &options = {});
+
+RunResult runFile(const std::string &arch, const std::string &filename,
+                  std::istream &in, std::ostream &out,
+                  const CompileOptions &options = {});
+
+// compiles the program to canonical IR, after the IR optimizations in
+// options, and runs it with the interpreter, with in and out as its standard
+// input and output
+InterpretResult interpret(const std::string &arch, const std::string &string,
+                          std::istream &in, std::ostream &out,
+                          const CompileOptions &options = {});
+
+InterpretResult interpretFile(const std::string &arch,
+                              const std::string &filename, std::istream &in,
+                              std::ostream &out,
+                              const CompileOptions &options = {});
+
+// compiles the program to canonical IR, after the IR optimizations in
+// options, then to bytecode, which the virtual machine runs with in and out as
+// its standard input and output. the machine must have 64 bit words
+RunResult runBytecode(const std::string &arch, const std::string &string,
+                      std::istream &in, std::ostream &out,
+                      const CompileOptions &options = {});
+
+// as above, with the program calling runtime, which can be inspected after it
+// ran, e.g. for its heap
+RunResult runBytecode(const std::string &arch, const std::string &string,
+                      Runtime &runtime, const CompileOptions &options = {});
 
-CompileResult compile(const std::string &arch, const std::string &string);
+RunResult runBytecodeFile(const std::string &arch,
+                          const std::string &filename, std::istream &in,
+                          std::ostream &out,
+                          const CompileOptions &options = {});
 
 } // namespace tiger
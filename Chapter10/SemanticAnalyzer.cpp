@@ -44,8 +44,11 @@ SemanticAnalyzer::result_type
 
   auto namedType = var->m_type;
 
-  auto translatedExp =
-    m_translator.translateVar(m_functionLevels, var->m_access);
+  auto const &access =
+    var->m_copy && var->m_copy->level == m_functionLevels.back()
+      ? *var->m_copy
+      : var->m_access;
+  auto translatedExp = m_translator.translateVar(m_functionLevels, access);
 
   for (const auto &v : exp.rest) {
     if (!helpers::match(v)(
@@ -148,7 +151,8 @@ SemanticAnalyzer::result_type
   return CompiledExpression{
     func->m_resultType,
     m_translator.translateCall(m_functionLevels, func->m_label,
-                               func->m_declerationLevel, translatedArgs)};
+                               func->m_declerationLevel, translatedArgs,
+                               func->m_staticLink)};
 }
 
 SemanticAnalyzer::result_type
@@ -265,8 +269,13 @@ SemanticAnalyzer::result_type
     }
   }
 
-  return CompiledExpression{*type,
-                            m_translator.translateRecord(translatedFields)};
+  std::vector<bool> pointers;
+  for (const auto &field : recordFields) {
+    pointers.push_back(isPointer(field.m_type));
+  }
+
+  return CompiledExpression{
+    *type, m_translator.translateRecord(translatedFields, pointers)};
 }
 
 SemanticAnalyzer::result_type
@@ -369,8 +378,10 @@ SemanticAnalyzer::result_type
     m_errorHandler(id(exp.hi), "Expression must be of type int");
   }
 
-  VariableType forVar{s_intType, m_translator.allocateLocal(
-                                   m_functionLevels.back(), exp.escapes)};
+  VariableType forVar{s_intType,
+                      m_translator.allocateLocal(m_functionLevels.back(),
+                                                 exp.escapes),
+                      registerCopy(exp.escapes, exp.assigned)};
 
   m_environments.emplace_back();
   addToEnv(exp.var, forVar);
@@ -385,11 +396,18 @@ SemanticAnalyzer::result_type
     m_errorHandler(id(exp.body), "Expression must produce no value");
   }
 
+  auto counter = m_translator.translateVar(m_functionLevels, forVar.m_access);
+  boost::optional<translator::Expression> frameSlot;
+  if (forVar.m_copy) {
+    // count in the register, nested functions read the frame slot
+    frameSlot = counter;
+    counter   = m_translator.translateVar(m_functionLevels, *forVar.m_copy);
+  }
+
   CompiledExpression res{
     s_voidType, m_translator.translateForLoop(
-                  m_translator.translateVar(m_functionLevels, forVar.m_access),
-                  fromExp.m_translated, toExp.m_translated,
-                  bodyExp.m_translated, m_breakTargets.back())};
+                  counter, fromExp.m_translated, toExp.m_translated,
+                  bodyExp.m_translated, m_breakTargets.back(), frameSlot)};
 
   m_breakTargets.pop_back();
 
@@ -444,8 +462,9 @@ SemanticAnalyzer::result_type
   }
 
   return CompiledExpression{
-    *type,
-    m_translator.translateArray(sizeExp.m_translated, initExp.m_translated)};
+    *type, m_translator.translateArray(sizeExp.m_translated,
+                                       initExp.m_translated,
+                                       isPointer(arrayType->m_elementType))};
 }
 
 SemanticAnalyzer::result_type
@@ -507,7 +526,11 @@ SemanticAnalyzer::CompiledDeclaration
 
     function.m_label            = m_tempMap.newLabel();
     function.m_declerationLevel = m_functionLevels.back();
-    function.m_bodyLevel = m_translator.newLevel(function.m_label, formals);
+    if (!dec.staticLink) {
+      function.m_staticLink = translator::StaticLink::NONE;
+    }
+    function.m_bodyLevel =
+      m_translator.newLevel(function.m_label, formals, dec.staticLink);
     addToEnv(dec.name, function);
   }
 
@@ -523,12 +546,26 @@ SemanticAnalyzer::CompiledDeclaration
     m_functionLevels.push_back(funcType->m_bodyLevel);
 
     auto formals = m_translator.formals(funcType->m_bodyLevel);
+    // skip the static link
+    auto const first = dec.staticLink ? 1 : 0;
+    std::vector<translator::Expression> copies;
     for (size_t i = 0; i < dec.params.size(); ++i) {
-      addToEnv(dec.params[i].name,
-               VariableType{funcType->m_parameterTypes[i], formals[i + 1]});
+      VariableType param{funcType->m_parameterTypes[i], formals[i + first],
+                         registerCopy(dec.params[i].escapes,
+                                      dec.params[i].assigned)};
+      if (param.m_copy) {
+        copies.push_back(m_translator.translateVarDecleration(
+          m_translator.translateVar(m_functionLevels, *param.m_copy),
+          m_translator.translateVar(m_functionLevels, param.m_access)));
+      }
+      addToEnv(dec.params[i].name, param);
     }
 
     auto compiled = compileExpression(dec.body);
+    if (!copies.empty()) {
+      compiled.m_translated =
+        m_translator.translateLet(copies, {compiled.m_translated});
+    }
 
     m_functionLevels.pop_back();
     m_environments.pop_back();
@@ -575,12 +612,26 @@ SemanticAnalyzer::CompiledDeclaration
 
   var.m_access =
     m_translator.allocateLocal(m_functionLevels.back(), dec.escapes);
+  var.m_copy = registerCopy(dec.escapes, dec.assigned);
 
   addToEnv(dec.name, var);
 
-  return m_translator.translateVarDecleration(
-    m_translator.translateVar(m_functionLevels, var.m_access),
-    compiled.m_translated);
+  auto access = m_translator.translateVar(m_functionLevels, var.m_access);
+  if (var.m_copy) {
+    return m_translator.translateVarDecleration(
+      access, m_translator.translateVar(m_functionLevels, *var.m_copy),
+      compiled.m_translated);
+  }
+
+  return m_translator.translateVarDecleration(access, compiled.m_translated);
+}
+
+boost::optional<translator::VariableAccess>
+  SemanticAnalyzer::registerCopy(bool escapes, bool assigned) {
+  if (!escapes || assigned) {
+    return {};
+  }
+  return m_translator.allocateLocal(m_functionLevels.back(), false);
 }
 
 SemanticAnalyzer::CompiledDeclaration
@@ -724,9 +775,14 @@ SemanticAnalyzer::Environment SemanticAnalyzer::defaultEnvironment() {
   auto addStandardFunction =
     [this, &defaultEnv](const std::string &name, const NamedType &resultType,
                         const std::vector<NamedType> &paramTypes = {}) {
-      defaultEnv.m_valueMap[name] =
-        FunctionType{resultType, paramTypes, m_tempMap.namedLabel(name),
-                     m_translator.outermost()};
+      FunctionType function{resultType, paramTypes,
+                            m_tempMap.namedLabel(name),
+                            m_translator.outermost()};
+      if (m_lambdaLifting) {
+        // the library doesn't use its static link
+        function.m_staticLink = translator::StaticLink::IGNORED;
+      }
+      defaultEnv.m_valueMap[name] = function;
     };
 
   addStandardFunction("print", s_voidType, {s_stringType});
@@ -756,6 +812,16 @@ SemanticAnalyzer::OptionalValue
   return {};
 }
 
+bool SemanticAnalyzer::isPointer(const NamedType &type) const {
+  if (hasType<RecordType>(type) || hasType<ArrayType>(type)) {
+    return true;
+  }
+
+  // recursive types are only resolved by name
+  auto const actual = findType(type.m_name);
+  return actual && (hasType<RecordType>(*actual) || hasType<ArrayType>(*actual));
+}
+
 SemanticAnalyzer::OptionalType
   SemanticAnalyzer::findType(std::string name) const {
   for (auto it = m_environments.rbegin(); it != m_environments.rend(); ++it) {
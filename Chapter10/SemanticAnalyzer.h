@@ -21,12 +21,19 @@ public:
   template <typename ErrorHandler, typename Annotation>
   SemanticAnalyzer(ErrorHandler &errorHandler, Annotation &annotation,
                    temp::Map &tempMap,
-                   frame::CallingConvention &callingConvention) :
+                   frame::CallingConvention &callingConvention,
+                   bool lambdaLifting                        = false,
+                   translator::NonLocalAccess nonLocalAccess =
+                     translator::NonLocalAccess::STATIC_LINKS,
+                   translator::Allocation allocation =
+                     translator::Allocation::MALLOC) :
       m_errorHandler{
         [&errorHandler, &annotation](size_t id, const std::string &what) {
           errorHandler("Error", what, annotation.iteratorFromId(id));
         }},
-      m_translator{tempMap, callingConvention}, m_tempMap{tempMap} {
+      m_translator{tempMap, callingConvention, nonLocalAccess, allocation},
+      m_tempMap{tempMap},
+      m_lambdaLifting{lambdaLifting} {
     m_environments.push_back(defaultEnvironment());
   }
 
@@ -70,19 +77,30 @@ private:
     return equalTypes(lhs.m_type, rhs.m_type);
   }
 
+  // whether values of type point to records or arrays
+  bool isPointer(const NamedType &type) const;
+
   size_t id(const ast::Expression &expression) const;
 
   struct VariableType {
     NamedType m_type;
     translator::VariableAccess m_access;
+    // read by the declaring function instead of m_access
+    boost::optional<translator::VariableAccess> m_copy;
   };
 
+  // an escaping variable which is never assigned can also be kept in a
+  // register, as nested functions only read its frame slot
+  boost::optional<translator::VariableAccess> registerCopy(bool escapes,
+                                                           bool assigned);
+
   struct FunctionType {
     NamedType m_resultType;
     std::vector<NamedType> m_parameterTypes;
     temp::Label m_label;
     translator::Level m_declerationLevel;
     translator::Level m_bodyLevel;
+    translator::StaticLink m_staticLink = translator::StaticLink::FRAME;
   };
 
   using ValueType = boost::variant<VariableType, FunctionType>;
@@ -120,6 +138,9 @@ private:
 
   translator::Translator m_translator;
   temp::Map &m_tempMap;
+  // library functions get a null static link, so calling them doesn't need
+  // the frames of enclosing functions
+  bool m_lambdaLifting;
 
   struct Environment {
     TypeMap m_typeMap;
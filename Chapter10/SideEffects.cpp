@@ -0,0 +1,141 @@
+#include "SideEffects.h"
+#include "variantMatch.h"
+#include <algorithm>
+
+namespace tiger {
+
+using helpers::hasType;
+using helpers::match;
+
+namespace {
+
+// whether predicate holds for exp or any of its sub expressions
+template <typename Predicate>
+bool any(const ir::Expression &exp, Predicate &&predicate) {
+  if (predicate(exp)) {
+    return true;
+  }
+
+  return match(exp)(
+    [&](const ir::BinaryOperation &binOperation) {
+      return any(binOperation.left, predicate)
+             || any(binOperation.right, predicate);
+    },
+    [&](const ir::MemoryAccess &memAccess) {
+      return any(memAccess.address, predicate);
+    },
+    [&](const ir::Call &call) {
+      return any(call.fun, predicate)
+             || std::any_of(call.args.begin(), call.args.end(),
+                            [&](const ir::Expression &arg) {
+                              return any(arg, predicate);
+                            });
+    },
+    [&](const ir::ExpressionSequence &expSequence) {
+      return any(expSequence.exp, predicate);
+    },
+    [](const auto & /*default*/) { return false; });
+}
+
+bool hasCall(const ir::Expression &exp) {
+  return any(exp, [](const ir::Expression &e) { return hasType<ir::Call>(e); });
+}
+
+bool hasSequence(const ir::Expression &exp) {
+  return any(exp, [](const ir::Expression &e) {
+    return hasType<ir::ExpressionSequence>(e);
+  });
+}
+
+} // namespace
+
+SideEffects::SideEffects(const temp::Register &framePointer) :
+    m_framePointer{framePointer} {}
+
+bool SideEffects::kills(const ir::Statement &stm,
+                        const ir::Expression &exp) const {
+  // effects of evaluating an expression which is part of stm
+  auto const evaluationKills = [&](const ir::Expression &evaluated) {
+    // statements nested in expressions are not analysed
+    return hasSequence(evaluated) || (hasCall(evaluated) && callKills(exp));
+  };
+
+  return match(stm)(
+    [&](const ir::Sequence &sequence) {
+      return std::any_of(
+        sequence.statements.begin(), sequence.statements.end(),
+        [&](const ir::Statement &statement) { return kills(statement, exp); });
+    },
+    [&](const ir::Move &move) {
+      if (evaluationKills(move.src)) {
+        return true;
+      }
+      return match(move.dst)(
+        [&](const temp::Register &reg) {
+          return any(exp, [&reg](const ir::Expression &e) {
+            auto const r = boost::get<temp::Register>(&e);
+            return r && *r == reg;
+          });
+        },
+        [&](const ir::MemoryAccess &store) {
+          return evaluationKills(store.address)
+                 || any(exp, [&](const ir::Expression &e) {
+                      auto const load = boost::get<ir::MemoryAccess>(&e);
+                      return load && mayAlias(store.address, load->address);
+                    });
+        },
+        [](const auto & /*default*/) { return true; });
+    },
+    [&](const ir::ExpressionStatement &expStatement) {
+      return evaluationKills(expStatement.exp);
+    },
+    [&](const ir::Jump &jump) { return evaluationKills(jump.exp); },
+    [&](const ir::ConditionalJump &cjump) {
+      return evaluationKills(cjump.left) || evaluationKills(cjump.right);
+    },
+    [](const auto & /*default*/) { return false; });
+}
+
+bool SideEffects::mayAlias(const ir::Expression &left,
+                           const ir::Expression &right) const {
+  // frame slots are only accessed through the frame pointer, so they can
+  // only alias themselves
+  auto const leftOffset  = frameOffset(left);
+  auto const rightOffset = frameOffset(right);
+  if (leftOffset && rightOffset) {
+    return *leftOffset == *rightOffset;
+  }
+  return !leftOffset && !rightOffset;
+}
+
+bool SideEffects::callKills(const ir::Expression &exp) const {
+  // calls may write to any memory and clobber the machine registers
+  return any(exp, [this](const ir::Expression &e) {
+    auto const reg = boost::get<temp::Register>(&e);
+    return hasType<ir::MemoryAccess>(e)
+           || (reg && temp::isMachineRegister(*reg) && *reg != m_framePointer);
+  });
+}
+
+boost::optional<int>
+  SideEffects::frameOffset(const ir::Expression &address) const {
+  return match(address)(
+    [this](const temp::Register &reg) -> boost::optional<int> {
+      if (reg == m_framePointer) {
+        return 0;
+      }
+      return {};
+    },
+    [this](const ir::BinaryOperation &binOperation) -> boost::optional<int> {
+      auto const reg    = boost::get<temp::Register>(&binOperation.left);
+      auto const offset = boost::get<int>(&binOperation.right);
+      if (binOperation.op == ir::BinOp::PLUS && reg && *reg == m_framePointer
+          && offset) {
+        return *offset;
+      }
+      return {};
+    },
+    [](const auto & /*default*/) -> boost::optional<int> { return {}; });
+}
+
+} // namespace tiger
@@ -0,0 +1,28 @@
+#pragma once
+#include "Tree.h"
+
+namespace tiger {
+
+// conservative analysis of the effects executing IR statements has on the
+// values of IR expressions
+class SideEffects {
+public:
+  SideEffects(const temp::Register &framePointer);
+
+  // whether executing stm may change the value of exp
+  bool kills(const ir::Statement &stm, const ir::Expression &exp) const;
+
+  // whether the two addresses may point to the same memory location
+  bool mayAlias(const ir::Expression &left, const ir::Expression &right) const;
+
+private:
+  // whether a call may change the value of exp
+  bool callKills(const ir::Expression &exp) const;
+
+  // the offset of address from the frame pointer, if it points to the frame
+  boost::optional<int> frameOffset(const ir::Expression &address) const;
+
+  temp::Register m_framePointer;
+};
+
+} // namespace tiger
@@ -0,0 +1,426 @@
+#include "Simplifier.h"
+#include "variantMatch.h"
+#include <algorithm>
+#include <boost/optional.hpp>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace tiger {
+
+using helpers::match;
+
+namespace {
+
+// the largest shift count every machine encodes as an immediate
+constexpr int MAX_IMMEDIATE_SHIFT = 8;
+
+bool isCommutative(ir::BinOp op) {
+  switch (op) {
+    case ir::BinOp::PLUS:
+    case ir::BinOp::MUL:
+    case ir::BinOp::AND:
+    case ir::BinOp::OR:
+    case ir::BinOp::XOR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // namespace
+
+ir::Statements Simplifier::simplify(ir::Statements &&statements) const {
+  ir::Statements simplified;
+  simplified.reserve(statements.size());
+  for (const auto &statement : statements) {
+    auto res = simplifyStatement(statement);
+    if (res) {
+      simplified.push_back(std::move(*res));
+    }
+  }
+
+  return removeRedundantJumps(removeUnreachable(std::move(simplified)));
+}
+
+boost::optional<int> Simplifier::evaluate(ir::BinOp op, int left, int right) {
+  // do the arithmetic on unsigned values to get wrap around instead of
+  // undefined behaviour on overflow
+  auto const l          = static_cast<unsigned>(left);
+  auto const r          = static_cast<unsigned>(right);
+  auto const validShift = right >= 0
+                          && right < std::numeric_limits<unsigned>::digits;
+  switch (op) {
+    case ir::BinOp::PLUS:
+      return static_cast<int>(l + r);
+    case ir::BinOp::MINUS:
+      return static_cast<int>(l - r);
+    case ir::BinOp::MUL:
+      return static_cast<int>(l * r);
+    case ir::BinOp::DIV:
+      if (right == 0
+          || (left == std::numeric_limits<int>::min() && right == -1)) {
+        // leave it to run time
+        return {};
+      }
+      return left / right;
+    case ir::BinOp::AND:
+      return left & right;
+    case ir::BinOp::OR:
+      return left | right;
+    case ir::BinOp::XOR:
+      return left ^ right;
+    case ir::BinOp::LSHIFT:
+      if (!validShift) {
+        return {};
+      }
+      return static_cast<int>(l << right);
+    case ir::BinOp::RSHIFT:
+      if (!validShift) {
+        return {};
+      }
+      return static_cast<int>(l >> right);
+    case ir::BinOp::ARSHIFT:
+      if (!validShift) {
+        return {};
+      }
+      return left < 0 ? ~(~left >> right) : left >> right;
+    default:
+      assert(false && "Unknown BinOp");
+      return {};
+  }
+}
+
+bool Simplifier::evaluate(ir::RelOp op, int left, int right) {
+  auto const l = static_cast<unsigned>(left);
+  auto const r = static_cast<unsigned>(right);
+  switch (op) {
+    default:
+      assert(false && "Unknown RelOp");
+    case ir::RelOp::EQ:
+      return left == right;
+    case ir::RelOp::NE:
+      return left != right;
+    case ir::RelOp::LT:
+      return left < right;
+    case ir::RelOp::GT:
+      return left > right;
+    case ir::RelOp::LE:
+      return left <= right;
+    case ir::RelOp::GE:
+      return left >= right;
+    case ir::RelOp::ULT:
+      return l < r;
+    case ir::RelOp::ULE:
+      return l <= r;
+    case ir::RelOp::UGT:
+      return l > r;
+    case ir::RelOp::UGE:
+      return l >= r;
+  }
+}
+
+boost::optional<int> Simplifier::log2(int value) {
+  if (value <= 0 || (value & (value - 1)) != 0) {
+    return {};
+  }
+
+  int res = 0;
+  while (value >>= 1) {
+    ++res;
+  }
+  return res;
+}
+
+bool Simplifier::isPure(const ir::Expression &exp) {
+  return match(exp)(
+    [](const ir::BinaryOperation &binOperation) {
+      return isPure(binOperation.left) && isPure(binOperation.right);
+    },
+    [](const ir::MemoryAccess &memAccess) { return isPure(memAccess.address); },
+    [](const ir::ExpressionSequence &) { return false; },
+    [](const ir::Call &) { return false; },
+    [](const auto & /*default*/) { return true; });
+}
+
+ir::Expression Simplifier::simplifyExpression(const ir::Expression &exp) const {
+  return match(exp)(
+    [this](const ir::BinaryOperation &binOperation) {
+      return simplifyBinaryOperation(binOperation.op,
+                                     simplifyExpression(binOperation.left),
+                                     simplifyExpression(binOperation.right));
+    },
+    [this](const ir::MemoryAccess &memAccess) -> ir::Expression {
+      return ir::MemoryAccess{simplifyExpression(memAccess.address)};
+    },
+    [this](const ir::Call &call) -> ir::Expression {
+      ir::Call res{call.fun, {}};
+      res.args.reserve(call.args.size());
+      for (const auto &arg : call.args) {
+        res.args.push_back(simplifyExpression(arg));
+      }
+      return res;
+    },
+    [](const auto &exp) -> ir::Expression { return exp; });
+}
+
+ir::Expression Simplifier::simplifyBinaryOperation(ir::BinOp op,
+                                                   ir::Expression left,
+                                                   ir::Expression right) const {
+  if (isCommutative(op) && helpers::hasType<int>(left)
+      && !helpers::hasType<int>(right)) {
+    // constants go to the right, where the patterns expect them
+    std::swap(left, right);
+  }
+
+  auto const rightConst = boost::get<int>(&right);
+  if (!rightConst) {
+    return ir::BinaryOperation{op, left, right};
+  }
+
+  auto const constant  = *rightConst;
+  auto const leftConst = boost::get<int>(&left);
+  if (leftConst) {
+    auto folded = evaluate(op, *leftConst, constant);
+    if (folded) {
+      return *folded;
+    }
+  }
+
+  switch (op) {
+    case ir::BinOp::PLUS: {
+      if (constant == 0) {
+        return left;
+      }
+      // (x + c1) + c2 == x + (c1 + c2)
+      auto const inner = boost::get<ir::BinaryOperation>(&left);
+      if (inner && inner->op == ir::BinOp::PLUS) {
+        auto const innerConst = boost::get<int>(&inner->right);
+        if (innerConst) {
+          return simplifyBinaryOperation(
+            ir::BinOp::PLUS, inner->left,
+            *evaluate(ir::BinOp::PLUS, *innerConst, constant));
+        }
+      }
+      break;
+    }
+    case ir::BinOp::MINUS:
+      if (constant == 0) {
+        return left;
+      }
+      if (constant != std::numeric_limits<int>::min()) {
+        return simplifyBinaryOperation(ir::BinOp::PLUS, left, -constant);
+      }
+      break;
+    case ir::BinOp::MUL: {
+      if (constant == 0 && isPure(left)) {
+        return 0;
+      }
+      auto const shift = log2(constant);
+      if (shift && *shift <= MAX_IMMEDIATE_SHIFT) {
+        return simplifyBinaryOperation(ir::BinOp::LSHIFT, left, *shift);
+      }
+      break;
+    }
+    case ir::BinOp::DIV:
+      if (constant == 1) {
+        return left;
+      }
+      break;
+    case ir::BinOp::AND:
+      if (constant == 0 && isPure(left)) {
+        return 0;
+      }
+      if (constant == -1) {
+        return left;
+      }
+      break;
+    case ir::BinOp::OR:
+    case ir::BinOp::XOR:
+    case ir::BinOp::LSHIFT:
+    case ir::BinOp::RSHIFT:
+    case ir::BinOp::ARSHIFT:
+      if (constant == 0) {
+        return left;
+      }
+      break;
+    default:
+      break;
+  }
+
+  return ir::BinaryOperation{op, left, right};
+}
+
+boost::optional<ir::Statement>
+  Simplifier::simplifyStatement(const ir::Statement &stm) const {
+  using Ret = boost::optional<ir::Statement>;
+  return match(stm)(
+    [this](const ir::Move &move) -> Ret {
+      auto src = simplifyExpression(move.src);
+      auto dst = match(move.dst)(
+        [this](const ir::MemoryAccess &memAccess) -> ir::Expression {
+          return ir::MemoryAccess{simplifyExpression(memAccess.address)};
+        },
+        [](const auto &dst) -> ir::Expression { return dst; });
+      auto const srcReg = boost::get<temp::Register>(&src);
+      auto const dstReg = boost::get<temp::Register>(&dst);
+      if (srcReg && dstReg && *srcReg == *dstReg) {
+        return {};
+      }
+      return ir::Statement{ir::Move{src, dst}};
+    },
+    [this](const ir::ExpressionStatement &expStatement) -> Ret {
+      auto exp = simplifyExpression(expStatement.exp);
+      if (isPure(exp)) {
+        return {};
+      }
+      return ir::Statement{ir::ExpressionStatement{exp}};
+    },
+    [this](const ir::ConditionalJump &cjump) -> Ret {
+      auto left         = simplifyExpression(cjump.left);
+      auto right        = simplifyExpression(cjump.right);
+      auto const lConst = boost::get<int>(&left);
+      auto const rConst = boost::get<int>(&right);
+      if (lConst && rConst) {
+        auto const &target = evaluate(cjump.op, *lConst, *rConst)
+                               ? *cjump.trueDest
+                               : *cjump.falseDest;
+        return ir::Statement{ir::Jump{target}};
+      }
+      if (*cjump.trueDest == *cjump.falseDest && isPure(left)
+          && isPure(right)) {
+        return ir::Statement{ir::Jump{*cjump.trueDest}};
+      }
+      return ir::Statement{ir::ConditionalJump{
+        cjump.op, left, right, *cjump.trueDest, *cjump.falseDest}};
+    },
+    [](const auto &stm) -> Ret { return ir::Statement{stm}; });
+}
+
+ir::Statements
+  Simplifier::removeUnreachable(ir::Statements &&statements) const {
+  // a block starts at the function entry, at a label or after a jump
+  struct Block {
+    size_t m_first, m_last;
+  };
+  std::vector<Block> blocks;
+  std::unordered_map<temp::Label, size_t> labelBlocks;
+  for (size_t i = 0; i < statements.size(); ++i) {
+    auto const label = boost::get<temp::Label>(&statements[i]);
+    if (i == 0 || label || ir::isJump(statements[i - 1])) {
+      if (!blocks.empty()) {
+        blocks.back().m_last = i;
+      }
+      blocks.push_back({i, statements.size()});
+    }
+    if (label) {
+      labelBlocks[*label] = blocks.size() - 1;
+    }
+  }
+
+  std::vector<bool> reachable(blocks.size(), false);
+  std::vector<size_t> worklist;
+  auto const reach = [&](size_t block) {
+    if (!reachable[block]) {
+      reachable[block] = true;
+      worklist.push_back(block);
+    }
+  };
+  auto const reachLabel = [&](const temp::Label &label) {
+    auto it = labelBlocks.find(label);
+    if (it != labelBlocks.end()) {
+      reach(it->second);
+    }
+  };
+
+  if (!blocks.empty()) {
+    reach(0);
+  }
+
+  while (!worklist.empty()) {
+    auto const block = worklist.back();
+    worklist.pop_back();
+    match(statements[blocks[block].m_last - 1])(
+      [&](const ir::Jump &jump) {
+        if (jump.jumps.empty()) {
+          // unknown target, any label may be reached
+          for (const auto &labelBlock : labelBlocks) {
+            reach(labelBlock.second);
+          }
+        }
+        for (const auto &label : jump.jumps) {
+          reachLabel(label);
+        }
+      },
+      [&](const ir::ConditionalJump &cjump) {
+        reachLabel(*cjump.trueDest);
+        reachLabel(*cjump.falseDest);
+      },
+      [&](const auto & /*default*/) {
+        if (block + 1 < blocks.size()) {
+          reach(block + 1);
+        }
+      });
+  }
+
+  ir::Statements res;
+  res.reserve(statements.size());
+  for (size_t block = 0; block < blocks.size(); ++block) {
+    if (reachable[block]) {
+      std::move(statements.begin() + blocks[block].m_first,
+                statements.begin() + blocks[block].m_last,
+                std::back_inserter(res));
+    }
+  }
+  return res;
+}
+
+ir::Statements
+  Simplifier::removeRedundantJumps(ir::Statements &&statements) const {
+  ir::Statements res;
+  res.reserve(statements.size());
+  for (auto &statement : statements) {
+    if (!res.empty()) {
+      auto const label = boost::get<temp::Label>(&statement);
+      auto const jump  = boost::get<ir::Jump>(&res.back());
+      if (label && jump && jump->jumps.size() == 1
+          && jump->jumps.front() == *label) {
+        // fall through instead
+        res.pop_back();
+      }
+    }
+    res.push_back(std::move(statement));
+  }
+
+  std::unordered_set<temp::Label> targets;
+  for (const auto &statement : res) {
+    auto const computedJump = match(statement)(
+      [&targets](const ir::Jump &jump) {
+        targets.insert(jump.jumps.begin(), jump.jumps.end());
+        return jump.jumps.empty();
+      },
+      [&targets](const ir::ConditionalJump &cjump) {
+        targets.insert(*cjump.trueDest);
+        targets.insert(*cjump.falseDest);
+        return false;
+      },
+      [](const auto & /*default*/) { return false; });
+    if (computedJump) {
+      // every label is a possible target
+      return res;
+    }
+  }
+
+  // the first label is the function name, which is called from outside
+  auto const unused = [&targets](const ir::Statement &statement) {
+    auto const label = boost::get<temp::Label>(&statement);
+    return label && targets.count(*label) == 0;
+  };
+  if (!res.empty()) {
+    res.erase(std::remove_if(std::next(res.begin()), res.end(), unused),
+              res.end());
+  }
+  return res;
+}
+
+} // namespace tiger
@@ -0,0 +1,40 @@
+#pragma once
+#include "Tree.h"
+#include <boost/optional/optional_fwd.hpp>
+
+namespace tiger {
+
+// folds constants, applies algebraic identities and removes dead code from
+// canonical IR
+class Simplifier {
+public:
+  ir::Statements simplify(ir::Statements &&statements) const;
+
+  ir::Expression simplifyExpression(const ir::Expression &exp) const;
+
+  // evaluates op on constant operands, if possible
+  static boost::optional<int> evaluate(ir::BinOp op, int left, int right);
+  static bool evaluate(ir::RelOp op, int left, int right);
+
+  // returns k if value == 2^k
+  static boost::optional<int> log2(int value);
+
+  // whether evaluating exp has no side effects
+  static bool isPure(const ir::Expression &exp);
+
+private:
+  boost::optional<ir::Statement>
+    simplifyStatement(const ir::Statement &stm) const;
+
+  ir::Expression simplifyBinaryOperation(ir::BinOp op, ir::Expression left,
+                                         ir::Expression right) const;
+
+  // removes blocks that cannot be reached from the function entry
+  ir::Statements removeUnreachable(ir::Statements &&statements) const;
+
+  // removes jumps to the label immediately following them and labels no one
+  // jumps to
+  ir::Statements removeRedundantJumps(ir::Statements &&statements) const;
+};
+
+} // namespace tiger
@@ -0,0 +1,453 @@
+#include "SsaBuilder.h"
+#include "CanonicalLoops.h"
+#include "variantMatch.h"
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <unordered_set>
+
+namespace tiger {
+
+using helpers::hasType;
+
+namespace {
+
+// the temp written by stm
+boost::optional<temp::Register> definition(const ir::Statement &stm) {
+  if (auto const move = boost::get<ir::Move>(&stm)) {
+    auto const reg = boost::get<temp::Register>(&move->dst);
+    if (reg && !temp::isMachineRegister(*reg)) {
+      return *reg;
+    }
+  }
+  return {};
+}
+
+template <typename F> void forEachUse(const ir::Statement &stm, F &&f) {
+  ir::replaceUses(stm, [&f](const temp::Register &reg) -> ir::Expression {
+    if (!temp::isMachineRegister(reg)) {
+      f(reg);
+    }
+    return reg;
+  });
+}
+
+bool reads(const ir::Expression &exp, const temp::Register &reg) {
+  auto res = false;
+  ir::replaceUses(exp, [&](const temp::Register &used) -> ir::Expression {
+    res |= used == reg;
+    return used;
+  });
+  return res;
+}
+
+LoopAnalyser::Successors successors(const SsaForm &ssa) {
+  LoopAnalyser::Successors res;
+  res.reserve(ssa.m_blocks.size());
+  for (const auto &block : ssa.m_blocks) {
+    res.push_back(block.m_successors);
+  }
+  return res;
+}
+
+size_t predecessorIndex(const SsaForm &ssa, size_t block, size_t successor) {
+  auto const &predecessors =
+    ssa.m_blocks[ssa.m_blocks[block].m_successors[successor]].m_predecessors;
+  auto const it =
+    std::find_if(predecessors.begin(), predecessors.end(),
+                 [&](const SsaForm::Predecessor &predecessor) {
+                   return predecessor.m_block == block
+                          && predecessor.m_successor == successor;
+                 });
+  assert(it != predecessors.end() && "missing predecessor");
+  return static_cast<size_t>(it - predecessors.begin());
+}
+
+} // namespace
+
+void SsaForm::removeEdge(size_t block, size_t successor) {
+  auto &successors = m_blocks[block].m_successors;
+  auto &target     = m_blocks[successors[successor]];
+  auto const index = predecessorIndex(*this, block, successor);
+  target.m_predecessors.erase(target.m_predecessors.begin() + index);
+  for (auto &phi : target.m_phis) {
+    phi.m_args.erase(phi.m_args.begin() + index);
+  }
+  successors.erase(successors.begin() + successor);
+
+  // the following edges move back
+  for (auto k = successor; k < successors.size(); ++k) {
+    for (auto &predecessor : m_blocks[successors[k]].m_predecessors) {
+      if (predecessor.m_block == block && predecessor.m_successor == k + 1) {
+        predecessor.m_successor = k;
+        break;
+      }
+    }
+  }
+}
+
+void SsaForm::removeBlocks(const std::vector<bool> &removed) {
+  std::vector<size_t> indices(m_blocks.size());
+  size_t kept = 0;
+  for (size_t b = 0; b < m_blocks.size(); ++b) {
+    if (removed[b]) {
+      while (!m_blocks[b].m_successors.empty()) {
+        removeEdge(b, m_blocks[b].m_successors.size() - 1);
+      }
+    } else {
+      indices[b] = kept++;
+    }
+  }
+
+  std::vector<Block> blocks;
+  blocks.reserve(kept);
+  for (size_t b = 0; b < m_blocks.size(); ++b) {
+    if (removed[b]) {
+      continue;
+    }
+    auto &block = m_blocks[b];
+    for (auto &successor : block.m_successors) {
+      successor = indices[successor];
+    }
+    for (auto &predecessor : block.m_predecessors) {
+      assert(!removed[predecessor.m_block] && "removed block is a predecessor");
+      predecessor.m_block = indices[predecessor.m_block];
+    }
+    blocks.push_back(std::move(block));
+  }
+  m_blocks = std::move(blocks);
+}
+
+SsaBuilder::SsaBuilder(temp::Map &tempMap) : m_tempMap{tempMap} {}
+
+SsaForm SsaBuilder::build(ir::Statements &&statements) const {
+  SsaForm res;
+  if (statements.empty()) {
+    return res;
+  }
+
+  auto const blocks     = CanonicalLoops::basicBlocks(statements);
+  auto const successors = CanonicalLoops::successors(statements, blocks);
+  LoopAnalyser const reachability{successors};
+
+  std::vector<size_t> indices(blocks.size());
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    if (!reachability.isReachable(i)) {
+      continue;
+    }
+    indices[i] = res.m_blocks.size();
+    SsaForm::Block block;
+    block.m_statements.assign(
+      std::make_move_iterator(statements.begin() + blocks[i].m_first),
+      std::make_move_iterator(statements.begin() + blocks[i].m_last));
+    res.m_blocks.push_back(std::move(block));
+  }
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    if (reachability.isReachable(i)) {
+      for (auto successor : successors[i]) {
+        res.m_blocks[indices[i]].m_successors.push_back(indices[successor]);
+      }
+    }
+  }
+  for (size_t b = 0; b < res.m_blocks.size(); ++b) {
+    auto const &blockSuccessors = res.m_blocks[b].m_successors;
+    for (size_t k = 0; k < blockSuccessors.size(); ++k) {
+      res.m_blocks[blockSuccessors[k]].m_predecessors.push_back({b, k});
+    }
+  }
+  assert(res.m_blocks.front().m_predecessors.empty()
+         && "the entry cannot be jumped to");
+
+  placePhis(res);
+  rename(res);
+  return res;
+}
+
+void SsaBuilder::placePhis(SsaForm &ssa) const {
+  auto &blocks    = ssa.m_blocks;
+  auto const size = blocks.size();
+
+  // temps read before being written and temps written in each block
+  std::vector<std::unordered_set<temp::Register>> liveIns(size),
+    definitions(size);
+  std::map<temp::Register, std::vector<size_t>> definitionSites;
+  for (size_t b = 0; b < size; ++b) {
+    for (const auto &stm : blocks[b].m_statements) {
+      forEachUse(stm, [&](const temp::Register &reg) {
+        if (!definitions[b].count(reg)) {
+          liveIns[b].insert(reg);
+        }
+      });
+      if (auto const reg = definition(stm)) {
+        if (definitions[b].insert(*reg).second) {
+          definitionSites[*reg].push_back(b);
+        }
+      }
+    }
+  }
+
+  for (auto changed = true; changed;) {
+    changed = false;
+    for (auto b = size; b-- > 0;) {
+      for (auto successor : blocks[b].m_successors) {
+        for (const auto &reg : liveIns[successor]) {
+          if (!definitions[b].count(reg) && liveIns[b].insert(reg).second) {
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+
+  // the dominance frontier of a block holds the blocks it doesn't strictly
+  // dominate but dominates one of their predecessors
+  LoopAnalyser const dominators{successors(ssa)};
+  std::vector<std::vector<size_t>> frontiers(size);
+  for (size_t b = 0; b < size; ++b) {
+    if (blocks[b].m_predecessors.size() < 2) {
+      continue;
+    }
+    auto const immediateDominator = *dominators.immediateDominator(b);
+    for (const auto &predecessor : blocks[b].m_predecessors) {
+      for (auto runner = predecessor.m_block; runner != immediateDominator;
+           runner      = *dominators.immediateDominator(runner)) {
+        if (frontiers[runner].empty() || frontiers[runner].back() != b) {
+          frontiers[runner].push_back(b);
+        }
+      }
+    }
+  }
+
+  // a temp written in a block needs a phi in the iterated dominance frontier
+  // of the block, where it's live
+  for (const auto &sites : definitionSites) {
+    auto const &reg = sites.first;
+    std::unordered_set<size_t> phis;
+    std::unordered_set<size_t> queued(sites.second.begin(), sites.second.end());
+    auto worklist = sites.second;
+    while (!worklist.empty()) {
+      auto const b = worklist.back();
+      worklist.pop_back();
+      for (auto frontier : frontiers[b]) {
+        if (!liveIns[frontier].count(reg) || !phis.insert(frontier).second) {
+          continue;
+        }
+        blocks[frontier].m_phis.push_back(
+          {reg, std::vector<ir::Expression>(
+                  blocks[frontier].m_predecessors.size(), reg)});
+        if (queued.insert(frontier).second) {
+          worklist.push_back(frontier);
+        }
+      }
+    }
+  }
+}
+
+void SsaBuilder::rename(SsaForm &ssa) const {
+  auto &blocks = ssa.m_blocks;
+  LoopAnalyser const dominators{successors(ssa)};
+
+  // the versions of each temp in the dominator tree path being walked
+  std::unordered_map<temp::Register, temp::Registers> versions;
+  auto const current = [&versions](const temp::Register &reg) {
+    auto const it = versions.find(reg);
+    return it == versions.end() || it->second.empty() ? reg
+                                                      : it->second.back();
+  };
+  auto const mapping = [&current](const temp::Register &reg) -> ir::Expression {
+    return current(reg);
+  };
+
+  struct Visit {
+    size_t m_block;
+    bool m_entered;
+    // the temps which got a new version in the block
+    temp::Registers m_defined;
+  };
+
+  // definitions dominate their uses, so walking the dominator tree sees
+  // every definition before its uses, except for those of phis
+  std::vector<Visit> stack{{0, false, {}}};
+  while (!stack.empty()) {
+    if (stack.back().m_entered) {
+      for (const auto &reg : stack.back().m_defined) {
+        versions[reg].pop_back();
+      }
+      stack.pop_back();
+      continue;
+    }
+
+    auto const b           = stack.back().m_block;
+    stack.back().m_entered = true;
+    auto &defined          = stack.back().m_defined;
+    auto const newVersion  = [&](const temp::Register &reg) {
+      auto const version = m_tempMap.newTemp();
+      versions[reg].push_back(version);
+      ssa.m_originals.emplace(version, reg);
+      defined.push_back(reg);
+      return version;
+    };
+
+    auto &block = blocks[b];
+    for (auto &phi : block.m_phis) {
+      phi.m_dst = newVersion(phi.m_dst);
+    }
+    for (auto &stm : block.m_statements) {
+      stm = ir::replaceUses(stm, mapping);
+      if (auto const reg = definition(stm)) {
+        boost::get<ir::Move>(stm).dst = newVersion(*reg);
+      }
+    }
+    for (size_t k = 0; k < block.m_successors.size(); ++k) {
+      auto const index = predecessorIndex(ssa, b, k);
+      for (auto &phi : blocks[block.m_successors[k]].m_phis) {
+        // still holds the original temp
+        phi.m_args[index] =
+          current(boost::get<temp::Register>(phi.m_args[index]));
+      }
+    }
+
+    for (auto child : dominators.dominatorChildren(b)) {
+      stack.push_back({child, false, {}});
+    }
+  }
+}
+
+ir::Statements SsaBuilder::destruct(SsaForm &&ssa) const {
+  auto const original = [&ssa](const temp::Register &reg) -> ir::Expression {
+    auto const it = ssa.m_originals.find(reg);
+    return it == ssa.m_originals.end() ? reg : it->second;
+  };
+  auto const restore = [&original](const ir::Statement &stm) {
+    auto res = ir::replaceUses(stm, original);
+    if (auto const move = boost::get<ir::Move>(&res)) {
+      if (auto const reg = boost::get<temp::Register>(&move->dst)) {
+        move->dst = original(*reg);
+      }
+    }
+    return res;
+  };
+
+  ir::Statements res;
+  auto const &blocks = ssa.m_blocks;
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    auto const &block = blocks[b];
+    std::vector<Copies> copies;
+    for (size_t k = 0; k < block.m_successors.size(); ++k) {
+      copies.push_back(edgeCopies(ssa, b, k, original));
+    }
+
+    auto const &statements = block.m_statements;
+    auto const last        = restore(statements.back());
+    auto const endsWithJump =
+      hasType<ir::Jump>(last) || hasType<ir::ConditionalJump>(last);
+    std::transform(statements.begin(),
+                   endsWithJump ? statements.end() - 1 : statements.end(),
+                   std::back_inserter(res), restore);
+
+    auto const cjump = boost::get<ir::ConditionalJump>(&last);
+    if (!cjump) {
+      for (auto &edge : copies) {
+        assert((copies.size() == 1 || edge.empty())
+               && "copies on a jump with several targets");
+        sequentialize(std::move(edge), res);
+      }
+      if (endsWithJump) {
+        res.push_back(last);
+      }
+      continue;
+    }
+
+    auto &trueCopies       = copies[0];
+    auto &falseCopies      = copies[1];
+    auto const &trueDest   = *cjump->trueDest;
+    auto const &falseDest  = *cjump->falseDest;
+    auto const falseIsNext = block.m_successors[1] == b + 1;
+    if (trueCopies.empty() && falseCopies.empty()) {
+      res.push_back(last);
+    } else if (trueCopies.empty()) {
+      // the copies get a block of their own, after the conditional jump
+      auto const falseLabel = m_tempMap.newLabel();
+      res.emplace_back(ir::ConditionalJump{cjump->op, cjump->left, cjump->right,
+                                           trueDest, falseLabel});
+      res.emplace_back(falseLabel);
+      sequentialize(std::move(falseCopies), res);
+      if (!falseIsNext) {
+        res.emplace_back(ir::Jump{falseDest});
+      }
+    } else if (falseCopies.empty()) {
+      // negating the condition keeps the original false label after the
+      // block of the true edge
+      auto const trueLabel = m_tempMap.newLabel();
+      res.emplace_back(ir::ConditionalJump{ir::notRel(cjump->op), cjump->left,
+                                           cjump->right, falseDest,
+                                           trueLabel});
+      res.emplace_back(trueLabel);
+      sequentialize(std::move(trueCopies), res);
+      res.emplace_back(ir::Jump{trueDest});
+    } else {
+      auto const trueLabel  = m_tempMap.newLabel();
+      auto const falseLabel = m_tempMap.newLabel();
+      res.emplace_back(ir::ConditionalJump{cjump->op, cjump->left, cjump->right,
+                                           trueLabel, falseLabel});
+      res.emplace_back(falseLabel);
+      sequentialize(std::move(falseCopies), res);
+      res.emplace_back(ir::Jump{falseDest});
+      res.emplace_back(trueLabel);
+      sequentialize(std::move(trueCopies), res);
+      res.emplace_back(ir::Jump{trueDest});
+    }
+  }
+
+  return res;
+}
+
+SsaBuilder::Copies
+  SsaBuilder::edgeCopies(const SsaForm &ssa, size_t block, size_t successor,
+                         const ir::RegisterMapping &original) const {
+  auto const &target =
+    ssa.m_blocks[ssa.m_blocks[block].m_successors[successor]];
+  auto const index = predecessorIndex(ssa, block, successor);
+  Copies res;
+  for (const auto &phi : target.m_phis) {
+    auto const dst = original(phi.m_dst);
+    auto src       = ir::replaceUses(phi.m_args[index], original);
+    if (!ir::equal(src, dst)) {
+      res.push_back({std::move(src), dst});
+    }
+  }
+  return res;
+}
+
+void SsaBuilder::sequentialize(Copies &&copies,
+                               ir::Statements &statements) const {
+  while (!copies.empty()) {
+    // a copy can be done once no other copy reads its destination
+    auto const ready =
+      std::find_if(copies.begin(), copies.end(), [&](const ir::Move &copy) {
+        auto const &dst = boost::get<temp::Register>(copy.dst);
+        return std::none_of(copies.begin(), copies.end(),
+                            [&](const ir::Move &other) {
+                              return &other != &copy && reads(other.src, dst);
+                            });
+      });
+    if (ready != copies.end()) {
+      statements.emplace_back(std::move(*ready));
+      copies.erase(ready);
+      continue;
+    }
+
+    // the copies form a cycle, which is broken by saving one destination
+    auto const dst   = boost::get<temp::Register>(copies.front().dst);
+    auto const saved = m_tempMap.newTemp();
+    statements.emplace_back(ir::Move{dst, saved});
+    for (auto &copy : copies) {
+      copy.src = ir::replaceUses(
+        copy.src, [&](const temp::Register &reg) -> ir::Expression {
+          return reg == dst ? saved : reg;
+        });
+    }
+  }
+}
+
+} // namespace tiger
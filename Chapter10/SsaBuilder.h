@@ -0,0 +1,77 @@
+#pragma once
+#include "Tree.h"
+#include <unordered_map>
+
+namespace tiger {
+
+// static single assignment form of canonical IR, where every temp is written
+// by a single statement. The phis at the start of a block select the value of
+// a temp according to the predecessor control came from
+struct SsaForm {
+  struct Phi {
+    temp::Register m_dst;
+    // one per predecessor
+    std::vector<ir::Expression> m_args;
+  };
+
+  struct Predecessor {
+    size_t m_block;
+    // index of the edge among the successors of m_block
+    size_t m_successor;
+  };
+
+  struct Block {
+    std::vector<Phi> m_phis;
+    ir::Statements m_statements;
+    // jump targets in order, or the next block when falling through
+    std::vector<size_t> m_successors;
+    std::vector<Predecessor> m_predecessors;
+  };
+
+  // removes the edge to the successor'th successor of block, together with
+  // the phi arguments for it. The jump at the end of block is left unchanged
+  void removeEdge(size_t block, size_t successor);
+
+  // removes the marked blocks and the edges leaving them. No edge from a block
+  // which is kept may lead to a removed block
+  void removeBlocks(const std::vector<bool> &removed);
+
+  // blocks in the original order, the first one is the entry
+  std::vector<Block> m_blocks;
+  // the temp each renamed temp stands for
+  std::unordered_map<temp::Register, temp::Register> m_originals;
+};
+
+// translates canonical IR to SSA form and back
+class SsaBuilder {
+public:
+  explicit SsaBuilder(temp::Map &tempMap);
+
+  // unreachable blocks are removed. A phi is placed only where its temp is
+  // live, and machine registers are not renamed
+  SsaForm build(ir::Statements &&statements) const;
+
+  // every renamed temp gets its original temp back, and a phi argument which
+  // is not a version of the phi's temp is copied on the incoming edge. For
+  // this to work, transformations of the SSA form must not make the live
+  // ranges of versions of the same temp overlap
+  ir::Statements destruct(SsaForm &&ssa) const;
+
+private:
+  using Copies = std::vector<ir::Move>;
+
+  void placePhis(SsaForm &ssa) const;
+
+  void rename(SsaForm &ssa) const;
+
+  // the moves implementing the phis of the successor'th edge of block
+  Copies edgeCopies(const SsaForm &ssa, size_t block, size_t successor,
+                    const ir::RegisterMapping &original) const;
+
+  // emits copies which happen in parallel as a sequence of moves
+  void sequentialize(Copies &&copies, ir::Statements &statements) const;
+
+  temp::Map &m_tempMap;
+};
+
+} // namespace tiger
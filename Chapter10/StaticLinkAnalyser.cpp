@@ -0,0 +1,145 @@
+#include "StaticLinkAnalyser.h"
+#include "variantMatch.h"
+#include <algorithm>
+
+namespace tiger {
+
+void StaticLinkAnalyser::analyse(ast::Expression &exp) {
+  m_environments.emplace_back();
+  traverse(exp);
+  m_environments.pop_back();
+  resolve();
+}
+
+void StaticLinkAnalyser::traverse(ast::Expression &exp) {
+  helpers::match(exp)([this](auto &exp) { this->traverse(exp); });
+}
+
+void StaticLinkAnalyser::traverse(ast::VarExpression &exp) {
+  auto const value = find(exp.first.name);
+  if (value && value->m_function == NO_FUNCTION && m_current != NO_FUNCTION) {
+    auto &reach = m_functions[m_current].m_reach;
+    reach       = std::min(reach, value->m_depth);
+  }
+
+  for (auto &r : exp.rest) {
+    helpers::match(r)([this](ast::Subscript &s) { traverse(s.exp); },
+                      [](auto & /*default*/) {});
+  }
+}
+
+void StaticLinkAnalyser::traverse(ast::CallExpression &exp) {
+  // library functions are not found and don't need any frame
+  auto const value = find(exp.func.name);
+  if (value && value->m_function != NO_FUNCTION && m_current != NO_FUNCTION) {
+    m_functions[m_current].m_callees.push_back(value->m_function);
+  }
+
+  traverse(exp.args);
+}
+
+void StaticLinkAnalyser::traverse(ast::LetExpression &exp) {
+  m_environments.emplace_back();
+
+  for (auto &dec : exp.decs) {
+    helpers::match(dec)(
+      [&](ast::FunctionDeclarations &decs) { traverse(decs); },
+      [&](ast::VarDeclaration &dec) {
+        // the initializer doesn't see the variable
+        traverse(dec.init);
+        declareVariable(dec.name.name);
+      },
+      [&](auto & /*default*/) {});
+  }
+
+  traverse(exp.body);
+
+  m_environments.pop_back();
+}
+
+void StaticLinkAnalyser::traverse(ast::ForExpression &exp) {
+  traverse(exp.lo);
+  traverse(exp.hi);
+
+  m_environments.emplace_back();
+  declareVariable(exp.var.name);
+  traverse(exp.body);
+  m_environments.pop_back();
+}
+
+void StaticLinkAnalyser::traverse(ast::FunctionDeclarations &decs) {
+  // functions in the same declaration group may call each other
+  auto const first = m_functions.size();
+  for (auto &dec : decs) {
+    m_environments.back()[dec.name.name] =
+      Value{m_depth, m_functions.size()};
+    m_functions.push_back(
+      Function{dec, m_depth + 1, m_depth + 1, m_current, {}});
+  }
+
+  auto const parent = m_current;
+  ++m_depth;
+  for (size_t i = 0; i < decs.size(); ++i) {
+    m_current = first + i;
+    m_environments.emplace_back();
+    for (const auto &param : decs[i].params) {
+      declareVariable(param.name.name);
+    }
+    traverse(decs[i].body);
+    m_environments.pop_back();
+  }
+  --m_depth;
+  m_current = parent;
+}
+
+void StaticLinkAnalyser::resolve() {
+  auto const staticLink = [](const Function &function) {
+    return function.m_reach < function.m_depth;
+  };
+
+  // a function needs the frame its callees are declared in, and its nested
+  // functions may need frames beyond its own
+  for (auto changed = true; changed;) {
+    changed = false;
+    for (auto &function : m_functions) {
+      auto reach = function.m_reach;
+      for (auto callee : function.m_callees) {
+        if (staticLink(m_functions[callee])) {
+          reach = std::min(reach, m_functions[callee].m_depth - 1);
+        }
+      }
+      if (function.m_parent != NO_FUNCTION) {
+        auto &parent = m_functions[function.m_parent];
+        if (reach < parent.m_reach) {
+          parent.m_reach = reach;
+          changed        = true;
+        }
+      }
+      if (reach < function.m_reach) {
+        function.m_reach = reach;
+        changed          = true;
+      }
+    }
+  }
+
+  for (auto &function : m_functions) {
+    function.m_declaration.staticLink = staticLink(function);
+  }
+}
+
+const StaticLinkAnalyser::Value *
+  StaticLinkAnalyser::find(const std::string &name) const {
+  for (auto it = m_environments.rbegin(); it != m_environments.rend(); ++it) {
+    auto found = it->find(name);
+    if (found != it->end()) {
+      return &found->second;
+    }
+  }
+  return nullptr;
+}
+
+void StaticLinkAnalyser::declareVariable(const std::string &name) {
+  m_environments.back()[name] = Value{m_depth, NO_FUNCTION};
+}
+
+} // namespace tiger
@@ -0,0 +1,89 @@
+#pragma once
+#include "AbstractSyntaxTree.h"
+#include <boost/fusion/include/for_each.hpp>
+#include <boost/fusion/include/is_sequence.hpp>
+#include <unordered_map>
+
+namespace tiger {
+// finds functions which never use the frames of enclosing functions, neither
+// directly nor through the functions they call or declare. These don't need a
+// static link and are effectively lifted to the top level
+class StaticLinkAnalyser {
+public:
+  void analyse(ast::Expression &exp);
+
+private:
+  void traverse(ast::Expression &exp);
+  void traverse(ast::VarExpression &exp);
+  void traverse(ast::CallExpression &exp);
+  void traverse(ast::LetExpression &exp);
+  void traverse(ast::ForExpression &exp);
+  void traverse(ast::FunctionDeclarations &decs);
+  template <typename T> void traverse(std::vector<T> &v);
+  template <typename T> void traverse(boost::optional<T> &o);
+  template <typename T>
+  std::enable_if_t<boost::fusion::traits::is_sequence<T>::value>
+    traverse(T &t);
+  template <typename T>
+  std::enable_if_t<!boost::fusion::traits::is_sequence<T>::value>
+    traverse(T &t);
+
+  // marks the functions whose frame chain is needed, once all the uses are
+  // known
+  void resolve();
+
+  static constexpr size_t NO_FUNCTION = static_cast<size_t>(-1);
+
+  struct Function {
+    ast::FunctionDeclaration &m_declaration;
+    // nesting depth of the body, the main program is at depth 0
+    size_t m_depth;
+    // the shallowest depth whose frame is needed
+    size_t m_reach;
+    // the enclosing function
+    size_t m_parent;
+    std::vector<size_t> m_callees;
+  };
+
+  struct Value {
+    // nesting depth of the declaration
+    size_t m_depth;
+    // index into m_functions, NO_FUNCTION for variables
+    size_t m_function;
+  };
+
+  using Environment = std::unordered_map<std::string, Value>;
+
+  const Value *find(const std::string &name) const;
+
+  void declareVariable(const std::string &name);
+
+  // the function whose body is analysed
+  size_t m_current = NO_FUNCTION;
+  size_t m_depth   = 0;
+  std::vector<Function> m_functions;
+  std::vector<Environment> m_environments;
+};
+
+template <typename T> void StaticLinkAnalyser::traverse(std::vector<T> &v) {
+  std::for_each(v.begin(), v.end(),
+                [this](auto &element) { this->traverse(element); });
+}
+
+template <typename T>
+std::enable_if_t<boost::fusion::traits::is_sequence<T>::value>
+  StaticLinkAnalyser::traverse(T &t) {
+  boost::fusion::for_each(t, [this](auto &exp) { this->traverse(exp); });
+}
+
+template <typename T>
+std::enable_if_t<!boost::fusion::traits::is_sequence<T>::value>
+  StaticLinkAnalyser::traverse(T & /* t */) {}
+
+template <typename T> void StaticLinkAnalyser::traverse(boost::optional<T> &o) {
+  if (o) {
+    traverse(*o);
+  }
+}
+
+} // namespace tiger
@@ -0,0 +1,296 @@
+#include "StrengthReduction.h"
+#include "Simplifier.h"
+#include "variantMatch.h"
+#include <algorithm>
+#include <boost/optional.hpp>
+
+namespace tiger {
+
+using helpers::match;
+
+namespace {
+
+// returns c if stm is reg := reg + c
+boost::optional<int> inductionStep(const ir::Statement &stm,
+                                   const temp::Register &reg) {
+  auto const move = boost::get<ir::Move>(&stm);
+  if (!move) {
+    return {};
+  }
+  auto const binOperation = boost::get<ir::BinaryOperation>(&move->src);
+  if (!binOperation) {
+    return {};
+  }
+  auto const isReg = [&reg](const ir::Expression &exp) {
+    auto const other = boost::get<temp::Register>(&exp);
+    return other && *other == reg;
+  };
+  auto const left  = boost::get<int>(&binOperation->left);
+  auto const right = boost::get<int>(&binOperation->right);
+  switch (binOperation->op) {
+    case ir::BinOp::PLUS:
+      if (right && isReg(binOperation->left)) {
+        return *right;
+      }
+      if (left && isReg(binOperation->right)) {
+        return *left;
+      }
+      return {};
+    case ir::BinOp::MINUS:
+      if (right && isReg(binOperation->left)) {
+        return Simplifier::evaluate(ir::BinOp::MINUS, 0, *right);
+      }
+      return {};
+    default:
+      return {};
+  }
+}
+
+} // namespace
+
+StrengthReduction::StrengthReduction(temp::Map &tempMap,
+                                     const temp::Register &framePointer) :
+    m_tempMap{tempMap},
+    m_framePointer{framePointer} {}
+
+ir::Statements StrengthReduction::reduce(ir::Statements &&statements) const {
+  // reducing changes the blocks, so the loops are analysed again until there
+  // is nothing left to reduce
+  for (auto reduced = true; reduced;) {
+    reduced = false;
+    CanonicalLoops canonicalLoops{statements};
+    auto const &loops = canonicalLoops.loops();
+    // inner loops first, so that the initializations they add may be reduced
+    // in the enclosing loops
+    for (auto it = loops.rbegin(); it != loops.rend() && !reduced; ++it) {
+      reduced = reduceLoop(statements, canonicalLoops, *it);
+    }
+  }
+
+  // the remaining multiplications by powers of 2 become shifts
+  return Simplifier{}.simplify(std::move(statements));
+}
+
+bool StrengthReduction::reduceLoop(ir::Statements &statements,
+                                   const CanonicalLoops &canonicalLoops,
+                                   const LoopAnalyser::Loop &loop) const {
+  auto const headerLabel = canonicalLoops.headerLabel(loop);
+  if (!headerLabel) {
+    return false;
+  }
+
+  auto inLoop = canonicalLoops.statementsOf(loop);
+  Context context;
+  // the statements defining each register
+  std::vector<std::pair<temp::Register, size_t>> definitions;
+  for (size_t i = 0; i < statements.size(); ++i) {
+    if (!inLoop[i]) {
+      continue;
+    }
+    if (auto const move = boost::get<ir::Move>(&statements[i])) {
+      if (auto const reg = boost::get<temp::Register>(&move->dst)) {
+        definitions.emplace_back(*reg, i);
+      }
+    }
+  }
+  std::sort(definitions.begin(), definitions.end());
+  for (auto it = definitions.begin(); it != definitions.end();) {
+    auto const reg = it->first;
+    auto const end =
+      std::find_if(it, definitions.end(),
+                   [&reg](const auto &def) { return def.first != reg; });
+    context.m_definitions.push_back(reg);
+    if (end - it == 1 && !temp::isMachineRegister(reg)) {
+      if (auto const step = inductionStep(statements[it->second], reg)) {
+        context.m_inductions.push_back({reg, *step, it->second});
+      }
+    }
+    it = end;
+  }
+
+  if (context.m_inductions.empty()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < statements.size(); ++i) {
+    if (inLoop[i]) {
+      statements[i] = rewrite(statements[i], context);
+    }
+  }
+
+  if (context.m_derived.empty()) {
+    return false;
+  }
+
+  // derived temps are incremented right after their induction variable
+  ir::Statements updated;
+  std::vector<bool> updatedInLoop;
+  updated.reserve(statements.size() + context.m_derived.size());
+  for (size_t i = 0; i < statements.size(); ++i) {
+    updated.push_back(std::move(statements[i]));
+    updatedInLoop.push_back(inLoop[i]);
+    auto const induction = std::find_if(
+      context.m_inductions.begin(), context.m_inductions.end(),
+      [i](const Induction &induction) { return induction.m_update == i; });
+    if (induction == context.m_inductions.end()) {
+      continue;
+    }
+    for (const auto &derived : context.m_derived) {
+      if (derived.m_induction == induction->m_register) {
+        updated.emplace_back(ir::Move{
+          ir::BinaryOperation{ir::BinOp::PLUS, derived.m_temp, derived.m_step},
+          derived.m_temp});
+        updatedInLoop.push_back(true);
+      }
+    }
+  }
+  statements = std::move(updated);
+
+  ir::Statements preheader;
+  for (auto &derived : context.m_derived) {
+    preheader.emplace_back(
+      ir::Move{std::move(derived.m_expression), derived.m_temp});
+  }
+  CanonicalLoops::insertPreheader(statements, updatedInLoop, *headerLabel,
+                                  std::move(preheader), m_tempMap);
+  return true;
+}
+
+ir::Statement StrengthReduction::rewrite(const ir::Statement &stm,
+                                         Context &context) const {
+  return match(stm)(
+    [&](const ir::Move &move) -> ir::Statement {
+      auto src = rewrite(move.src, context);
+      return match(move.dst)(
+        [&](const ir::MemoryAccess &memAccess) -> ir::Statement {
+          auto address = rewrite(memAccess.address, context);
+          return ir::Move{src, ir::MemoryAccess{address}};
+        },
+        [&](const auto &dst) -> ir::Statement {
+          return ir::Move{src, dst};
+        });
+    },
+    [&](const ir::ExpressionStatement &expStatement) -> ir::Statement {
+      return ir::ExpressionStatement{rewrite(expStatement.exp, context)};
+    },
+    [&](const ir::ConditionalJump &cjump) -> ir::Statement {
+      return ir::ConditionalJump{cjump.op, rewrite(cjump.left, context),
+                                 rewrite(cjump.right, context),
+                                 *cjump.trueDest, *cjump.falseDest};
+    },
+    [](const auto &stm) -> ir::Statement { return stm; });
+}
+
+ir::Expression StrengthReduction::rewrite(const ir::Expression &exp,
+                                          Context &context) const {
+  boost::optional<std::pair<Induction, int>> reduced;
+  if (auto const binOperation = boost::get<ir::BinaryOperation>(&exp)) {
+    reduced = scaled(exp, context);
+    if (!reduced && binOperation->op == ir::BinOp::PLUS) {
+      // base + i * c, as in array accesses, is a single derived temp
+      auto const leftScaled  = scaled(binOperation->left, context);
+      auto const rightScaled = scaled(binOperation->right, context);
+      if (leftScaled && isInvariant(binOperation->right, context)) {
+        reduced = leftScaled;
+      } else if (rightScaled && isInvariant(binOperation->left, context)) {
+        reduced = rightScaled;
+      }
+    }
+  }
+
+  if (reduced) {
+    auto const found = std::find_if(
+      context.m_derived.begin(), context.m_derived.end(),
+      [&exp](const Derived &derived) {
+        return ir::equal(derived.m_expression, exp);
+      });
+    if (found != context.m_derived.end()) {
+      return found->m_temp;
+    }
+    auto const step = Simplifier::evaluate(ir::BinOp::MUL,
+                                           reduced->first.m_step,
+                                           reduced->second);
+    if (step) {
+      auto const t = m_tempMap.newTemp();
+      context.m_derived.push_back(
+        {exp, t, reduced->first.m_register, *step});
+      return t;
+    }
+  }
+
+  return match(exp)(
+    [&](const ir::BinaryOperation &binOperation) -> ir::Expression {
+      return ir::BinaryOperation{binOperation.op,
+                                 rewrite(binOperation.left, context),
+                                 rewrite(binOperation.right, context)};
+    },
+    [&](const ir::MemoryAccess &memAccess) -> ir::Expression {
+      return ir::MemoryAccess{rewrite(memAccess.address, context)};
+    },
+    [&](const ir::Call &call) -> ir::Expression {
+      ir::Call res{call.fun, {}};
+      res.args.reserve(call.args.size());
+      for (const auto &arg : call.args) {
+        res.args.push_back(rewrite(arg, context));
+      }
+      return res;
+    },
+    [](const auto &exp) -> ir::Expression { return exp; });
+}
+
+boost::optional<std::pair<StrengthReduction::Induction, int>>
+  StrengthReduction::scaled(const ir::Expression &exp,
+                            const Context &context) const {
+  auto const binOperation = boost::get<ir::BinaryOperation>(&exp);
+  if (!binOperation) {
+    return {};
+  }
+
+  auto const induction =
+    [&context](const ir::Expression &exp) -> const Induction * {
+    auto const reg = boost::get<temp::Register>(&exp);
+    if (!reg) {
+      return nullptr;
+    }
+    auto const it = std::find_if(
+      context.m_inductions.begin(), context.m_inductions.end(),
+      [reg](const Induction &induction) {
+        return induction.m_register == *reg;
+      });
+    return it == context.m_inductions.end() ? nullptr : &*it;
+  };
+
+  auto const left  = induction(binOperation->left);
+  auto const right = induction(binOperation->right);
+  auto const leftConstant  = boost::get<int>(&binOperation->left);
+  auto const rightConstant = boost::get<int>(&binOperation->right);
+  switch (binOperation->op) {
+    case ir::BinOp::MUL:
+      if (left && rightConstant) {
+        return std::make_pair(*left, *rightConstant);
+      }
+      if (right && leftConstant) {
+        return std::make_pair(*right, *leftConstant);
+      }
+      return {};
+    case ir::BinOp::LSHIFT:
+      if (left && rightConstant && *rightConstant >= 0
+          && *rightConstant < 31) {
+        return std::make_pair(*left, 1 << *rightConstant);
+      }
+      return {};
+    default:
+      return {};
+  }
+}
+
+bool StrengthReduction::isInvariant(const ir::Expression &exp,
+                                    const Context &context) const {
+  auto const reg = boost::get<temp::Register>(&exp);
+  return reg
+         && !std::binary_search(context.m_definitions.begin(),
+                                context.m_definitions.end(), *reg)
+         && (!temp::isMachineRegister(*reg) || *reg == m_framePointer);
+}
+
+} // namespace tiger
@@ -0,0 +1,62 @@
+#pragma once
+#include "CanonicalLoops.h"
+#include "Tree.h"
+
+namespace tiger {
+
+// induction variable optimization of canonical IR: a temp which is changed
+// inside a loop only by adding a constant to it is an induction variable.
+// Multiplying it by a constant, possibly adding a loop invariant base as array
+// accesses do, is replaced by a temp which is computed before the loop and
+// incremented along with the induction variable. The result is simplified, so
+// other multiplications by small powers of 2 are replaced by shifts
+class StrengthReduction {
+public:
+  StrengthReduction(temp::Map &tempMap, const temp::Register &framePointer);
+
+  ir::Statements reduce(ir::Statements &&statements) const;
+
+private:
+  struct Induction {
+    temp::Register m_register;
+    int m_step;
+    // the statement updating the induction variable
+    size_t m_update;
+  };
+
+  struct Derived {
+    ir::Expression m_expression;
+    temp::Register m_temp;
+    temp::Register m_induction;
+    int m_step;
+  };
+
+  struct Context {
+    std::vector<Induction> m_inductions;
+    // sorted registers written inside the loop
+    temp::Registers m_definitions;
+    std::vector<Derived> m_derived;
+  };
+
+  // reduces the multiplications of a single loop, returns whether anything
+  // was reduced
+  bool reduceLoop(ir::Statements &statements,
+                  const CanonicalLoops &canonicalLoops,
+                  const LoopAnalyser::Loop &loop) const;
+
+  ir::Statement rewrite(const ir::Statement &stm, Context &context) const;
+
+  ir::Expression rewrite(const ir::Expression &exp, Context &context) const;
+
+  // if exp multiplies an induction variable by a constant, returns them
+  boost::optional<std::pair<Induction, int>>
+    scaled(const ir::Expression &exp, const Context &context) const;
+
+  // whether exp is a register which doesn't change inside the loop
+  bool isInvariant(const ir::Expression &exp, const Context &context) const;
+
+  temp::Map &m_tempMap;
+  temp::Register m_framePointer;
+};
+
+} // namespace tiger
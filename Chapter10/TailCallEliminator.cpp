@@ -0,0 +1,275 @@
+#include "TailCallEliminator.h"
+#include "CallingConvention.h"
+#include "Simplifier.h"
+#include "variantMatch.h"
+#include <algorithm>
+#include <boost/optional.hpp>
+#include <iterator>
+#include <unordered_set>
+
+namespace tiger {
+
+using helpers::match;
+
+namespace {
+
+struct CallSite {
+  ir::Call m_call;
+  // the register receiving the result
+  boost::optional<temp::Register> m_result;
+};
+
+// calls appear in canonical IR either as MOVE(CALL, t) or as EXP(CALL)
+boost::optional<CallSite> callSite(const ir::Statement &stm) {
+  return match(stm)(
+    [](const ir::Move &move) -> boost::optional<CallSite> {
+      auto const call = boost::get<ir::Call>(&move.src);
+      auto const dst  = boost::get<temp::Register>(&move.dst);
+      if (call && dst) {
+        return CallSite{*call, *dst};
+      }
+      return {};
+    },
+    [](const ir::ExpressionStatement &expStatement)
+      -> boost::optional<CallSite> {
+      if (auto const call = boost::get<ir::Call>(&expStatement.exp)) {
+        return CallSite{*call, boost::none};
+      }
+      return {};
+    },
+    [](const auto & /*default*/) -> boost::optional<CallSite> { return {}; });
+}
+
+// whether every value returned by the function is the same constant, as in
+// functions without a result
+bool returnsConstant(const ir::Statements &statements,
+                     const temp::Register &returnValue) {
+  boost::optional<int> returned;
+  for (const auto &stm : statements) {
+    auto const move = boost::get<ir::Move>(&stm);
+    if (!move || !ir::equal(move->dst, returnValue)) {
+      continue;
+    }
+    auto const value = boost::get<int>(&move->src);
+    if (!value || (returned && *returned != *value)) {
+      return false;
+    }
+    returned = *value;
+  }
+  return returned.has_value();
+}
+
+// the temps which may hold the frame pointer
+struct FrameTemps {
+  std::unordered_set<temp::Register> m_temps;
+  // the frame pointer was stored in memory
+  bool m_stored = false;
+};
+
+bool pointsToFrame(const ir::Expression &exp, const FrameTemps &frameTemps,
+                   const temp::Register &framePointer) {
+  return match(exp)(
+    [&](const temp::Register &reg) {
+      return reg == framePointer || frameTemps.m_temps.count(reg) != 0;
+    },
+    [&](const ir::BinaryOperation &binOperation) {
+      return pointsToFrame(binOperation.left, frameTemps, framePointer)
+             || pointsToFrame(binOperation.right, frameTemps, framePointer);
+    },
+    [&](const ir::MemoryAccess &) { return frameTemps.m_stored; },
+    [](const auto & /*default*/) { return false; });
+}
+
+FrameTemps frameTemps(const ir::Statements &statements,
+                      const temp::Register &framePointer) {
+  FrameTemps res;
+  for (auto changed = true; changed;) {
+    changed = false;
+    for (const auto &stm : statements) {
+      auto const move = boost::get<ir::Move>(&stm);
+      if (!move || !pointsToFrame(move->src, res, framePointer)) {
+        continue;
+      }
+      match(move->dst)(
+        [&](const temp::Register &reg) {
+          if (!temp::isMachineRegister(reg)) {
+            changed |= res.m_temps.insert(reg).second;
+          }
+        },
+        [&](const ir::MemoryAccess &) {
+          changed |= !res.m_stored;
+          res.m_stored = true;
+        },
+        [](const auto & /*default*/) {});
+    }
+  }
+  return res;
+}
+
+} // namespace
+
+TailCallEliminator::TailCallEliminator(
+  temp::Map &tempMap, const frame::CallingConvention &callingConvention) :
+    m_tempMap{tempMap},
+    m_callingConvention{callingConvention} {}
+
+ir::Statements
+  TailCallEliminator::eliminate(ir::Statements &&statements,
+                                const frame::Frame &frame) const {
+  auto const &formals           = frame.formals();
+  auto const &argumentRegisters = m_callingConvention.argumentRegisters();
+  auto const framePointer       = m_callingConvention.framePointer();
+
+  // the function label is followed by the parameter moves, the loop starts
+  // right after them
+  auto const loopStart = formals.size() + 1;
+  auto canLoop         = statements.size() > loopStart;
+  for (size_t i = 0; canLoop && i < formals.size(); ++i) {
+    auto const move = boost::get<ir::Move>(&statements[i + 1]);
+    canLoop         = move
+              && ir::equal(move->dst, m_callingConvention.accessFrame(
+                                        formals[i], framePointer));
+  }
+
+  Labels labels;
+  for (size_t i = 0; i < statements.size(); ++i) {
+    if (auto const label = boost::get<temp::Label>(&statements[i])) {
+      labels.emplace(*label, i);
+    }
+  }
+
+  auto const constantReturn =
+    returnsConstant(statements, m_callingConvention.returnValue());
+  auto const pointers = frameTemps(statements, framePointer);
+
+  ir::Statements res;
+  res.reserve(statements.size());
+  boost::optional<temp::Label> loopLabel;
+  for (size_t i = 0; i < statements.size(); ++i) {
+    auto const site   = callSite(statements[i]);
+    auto const callee = site ? boost::get<temp::Label>(&site->m_call.fun)
+                             : nullptr;
+    if (!callee) {
+      res.push_back(statements[i]);
+      continue;
+    }
+
+    const auto &args = site->m_call.args;
+    if (*callee == frame.name()) {
+      if (!canLoop || args.size() != formals.size()
+          || !returns(statements, i + 1, site->m_result, labels,
+                      constantReturn)) {
+        res.push_back(statements[i]);
+        continue;
+      }
+
+      // the arguments may read the formals, so they're all evaluated before
+      // the formals are assigned
+      ir::Statements assignments;
+      for (size_t j = 0; j < args.size(); ++j) {
+        auto const formal =
+          m_callingConvention.accessFrame(formals[j], framePointer);
+        // e.g. the static link
+        if (ir::equal(args[j], formal)) {
+          continue;
+        }
+        auto const t = m_tempMap.newTemp();
+        res.emplace_back(ir::Move{args[j], t});
+        assignments.emplace_back(ir::Move{t, formal});
+      }
+      std::move(assignments.begin(), assignments.end(),
+                std::back_inserter(res));
+      if (!loopLabel) {
+        loopLabel = m_tempMap.newLabel();
+      }
+      res.emplace_back(ir::Jump{*loopLabel});
+      continue;
+    }
+
+    // machines passing every argument on the stack can't jump to a sibling
+    auto const inRegisters = !argumentRegisters.empty()
+                             && args.size() <= argumentRegisters.size()
+                             && std::none_of(args.begin(), args.end(),
+                                             [&](const ir::Expression &arg) {
+                                               return pointsToFrame(
+                                                 arg, pointers, framePointer);
+                                             });
+    if (!inRegisters
+        || !returns(statements, i + 1, site->m_result, labels, false)) {
+      res.push_back(statements[i]);
+      continue;
+    }
+
+    // the callee will return the result to our caller
+    for (size_t j = 0; j < args.size(); ++j) {
+      res.emplace_back(ir::Move{args[j], argumentRegisters[j]});
+    }
+    res.emplace_back(ir::Jump{*callee});
+  }
+
+  if (loopLabel) {
+    res.insert(res.begin() + static_cast<std::ptrdiff_t>(loopStart),
+               *loopLabel);
+  }
+
+  return res;
+}
+
+bool TailCallEliminator::returns(const ir::Statements &statements,
+                                 size_t position,
+                                 const boost::optional<temp::Register> &result,
+                                 const Labels &labels,
+                                 bool constantReturn) const {
+  auto const returnValue = m_callingConvention.returnValue();
+  std::unordered_set<temp::Register> holding;
+  if (result) {
+    holding.insert(*result);
+  }
+  auto returnAssigned = false;
+
+  // bounds the walk in case of a loop without side effects
+  for (size_t steps = 0; steps <= statements.size(); ++steps) {
+    if (position == statements.size()) {
+      return holding.count(returnValue) != 0
+             || (constantReturn && returnAssigned);
+    }
+
+    auto const proceed = match(statements[position++])(
+      [](const temp::Label &) { return true; },
+      [&](const ir::Jump &jump) {
+        if (jump.jumps.size() != 1) {
+          return false;
+        }
+        auto const it = labels.find(jump.jumps.front());
+        if (it == labels.end()) {
+          return false;
+        }
+        position = it->second;
+        return true;
+      },
+      [&](const ir::Move &move) {
+        // temps set here are dead once the function exits
+        auto const dst = boost::get<temp::Register>(&move.dst);
+        if (!dst || (temp::isMachineRegister(*dst) && *dst != returnValue)
+            || !Simplifier::isPure(move.src)) {
+          return false;
+        }
+        auto const src = boost::get<temp::Register>(&move.src);
+        if (src && holding.count(*src) != 0) {
+          holding.insert(*dst);
+        } else {
+          holding.erase(*dst);
+        }
+        returnAssigned |= *dst == returnValue;
+        return true;
+      },
+      [](const auto & /*default*/) { return false; });
+    if (!proceed) {
+      return false;
+    }
+  }
+
+  return false;
+}
+
+} // namespace tiger
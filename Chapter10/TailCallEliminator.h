@@ -0,0 +1,42 @@
+#pragma once
+#include "Frame.h"
+#include "Tree.h"
+#include <boost/optional/optional_fwd.hpp>
+#include <unordered_map>
+
+namespace tiger {
+
+namespace frame {
+class CallingConvention;
+}
+
+// compiles calls in tail position of canonical IR as jumps. A function calling
+// itself assigns the arguments to its formals and jumps back past the
+// parameter moves, turning the recursion into a loop. Other tail calls pass
+// their arguments in registers and jump to the callee, which reuses the frame
+// and returns directly to our caller. This is only done when all the arguments
+// fit in argument registers and none of them points into the reused frame
+class TailCallEliminator {
+public:
+  TailCallEliminator(temp::Map &tempMap,
+                     const frame::CallingConvention &callingConvention);
+
+  ir::Statements eliminate(ir::Statements &&statements,
+                           const frame::Frame &frame) const;
+
+private:
+  using Labels = std::unordered_map<temp::Label, size_t>;
+
+  // whether the statements executed from position until the function exits
+  // only pass result on to the return value register. When constantReturn is
+  // set the function always returns the same constant, so it's enough that
+  // the return value register is assigned on the way
+  bool returns(const ir::Statements &statements, size_t position,
+               const boost::optional<temp::Register> &result,
+               const Labels &labels, bool constantReturn) const;
+
+  temp::Map &m_tempMap;
+  const frame::CallingConvention &m_callingConvention;
+};
+
+} // namespace tiger
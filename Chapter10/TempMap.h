@@ -13,8 +13,6 @@ namespace temp {
 
 using PredefinedRegisters = std::unordered_map<Register, std::string>;
 
-constexpr auto MIN_TEMP = 100;
-
 // A Map is just a table whose keys are Temp_temps and whose bindings
 // are strings. However, one mapping can be layered over another; if σ3 =
 // layer(σ1, σ2), this means that look(σ3, t) will first try look(σ1, t), and if
@@ -15,6 +15,13 @@ struct Register : type_safe::strong_typedef<Register, int>,
 
 using Registers = std::vector<temp::Register>;
 
+constexpr auto MIN_TEMP = 100;
+
+// registers below MIN_TEMP are the machine's, the rest are temps
+inline bool isMachineRegister(const Register &reg) {
+  return type_safe::get(reg) < MIN_TEMP;
+}
+
 } // namespace temp
 } // namespace tiger
 
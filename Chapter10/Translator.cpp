@@ -1,6 +1,7 @@
 #include "Translator.h"
 #include "CallingConvention.h"
 #include "variantMatch.h"
+#include <algorithm>
 #include <boost/dynamic_bitset.hpp>
 #include <cassert>
 
@@ -9,21 +10,27 @@ namespace tiger {
 namespace translator {
 
 Translator::Translator(temp::Map &tempMap,
-                       frame::CallingConvention &callingConvention) :
+                       frame::CallingConvention &callingConvention,
+                       NonLocalAccess nonLocalAccess, Allocation allocation) :
     m_tempMap(tempMap),
-    m_callingConvention(callingConvention),
+    m_callingConvention(callingConvention), m_nonLocalAccess(nonLocalAccess),
+    m_allocation(allocation),
     m_wordSize(m_callingConvention.wordSize()),
     m_outermost(newLevel(temp::Label{"start"}, frame::BoolList{})) {}
 
 Level Translator::outermost() const { return m_outermost; }
 
-Level Translator::newLevel(temp::Label label, const frame::BoolList &formals) {
-  // add static link
+Level Translator::newLevel(temp::Label label, const frame::BoolList &formals,
+                           bool staticLink) {
   frame::BoolList withStaticLink = formals;
-  withStaticLink.resize(withStaticLink.size() + 1);
-  (withStaticLink <<= 1).set(0, true);
+  if (staticLink) {
+    // add static link
+    withStaticLink.resize(withStaticLink.size() + 1);
+    (withStaticLink <<= 1).set(0, true);
+  }
   m_frames.emplace_back(
     m_callingConvention.createFrame(m_tempMap, label, withStaticLink));
+  m_staticLinks.push_back(staticLink);
   return m_frames.size() - 1;
 }
 
@@ -181,14 +188,23 @@ Expression Translator::translateString(const std::string &value) {
   return ir::Expression{lab};
 }
 
-Expression Translator::translateRecord(const std::vector<Expression> &fields) {
+Expression Translator::translateRecord(const std::vector<Expression> &fields,
+                                       const std::vector<bool> &pointers) {
   auto r = m_tempMap.newTemp();
   ir::Sequence res;
-  res.statements.emplace_back(
-    ir::Move{m_callingConvention.externalCall(
-               m_tempMap.namedLabel("malloc"),
-               {ir::Expression{static_cast<int>(m_wordSize * fields.size())}}),
-             r});
+  if (m_allocation == Allocation::COLLECTED) {
+    res.statements.emplace_back(
+      ir::Move{m_callingConvention.externalCall(
+                 m_tempMap.namedLabel("allocRecord"),
+                 {ir::Expression{recordDescriptor(pointers)}}),
+               r});
+  } else {
+    res.statements.emplace_back(ir::Move{
+      m_callingConvention.externalCall(
+        m_tempMap.namedLabel("malloc"),
+        {ir::Expression{static_cast<int>(m_wordSize * fields.size())}}),
+      r});
+  }
   for (const auto &field : fields) {
     auto address = ir::BinaryOperation{
       ir::BinOp::PLUS, r,
@@ -202,8 +218,19 @@ Expression Translator::translateRecord(const std::vector<Expression> &fields) {
 }
 
 Expression Translator::translateArray(const Expression &size,
-                                      const Expression &value) {
+                                      const Expression &value,
+                                      bool pointers) {
   auto r = m_tempMap.newTemp();
+  if (m_allocation == Allocation::COLLECTED) {
+    // the collected heap fills the array itself
+    return ir::ExpressionSequence{
+      ir::Move{m_callingConvention.externalCall(
+                 m_tempMap.namedLabel("allocArray"),
+                 {toExpression(size), toExpression(value), pointers ? 1 : 0}),
+               r},
+      r};
+  }
+
   ir::Sequence res{ir::Move{m_callingConvention.externalCall(
                               m_tempMap.namedLabel("malloc"),
                               {ir::BinaryOperation{ir::BinOp::MUL, m_wordSize,
@@ -215,6 +242,22 @@ Expression Translator::translateArray(const Expression &size,
   return ir::ExpressionSequence{res, r};
 }
 
+temp::Label Translator::recordDescriptor(const std::vector<bool> &pointers) {
+  std::string descriptor;
+  for (auto pointer : pointers) {
+    descriptor += pointer ? 'p' : 'n';
+  }
+
+  auto const existing = m_descriptors.find(descriptor);
+  if (existing != m_descriptors.end()) {
+    return existing->second;
+  }
+  auto const label = m_tempMap.newLabel();
+  m_fragments.emplace_back(StringFragment{label, descriptor});
+  m_descriptors.emplace(descriptor, label);
+  return label;
+}
+
 temp::Label Translator::loopDone() { return m_tempMap.newLabel(); }
 
 Expression Translator::translateWhileLoop(const Expression &test,
@@ -236,11 +279,10 @@ Expression Translator::translateBreak(const temp::Label &loopDone) {
   return ir::Jump{loopDone};
 }
 
-Expression Translator::translateForLoop(const Expression &var,
-                                        const Expression &from,
-                                        const Expression &to,
-                                        const Expression &body,
-                                        const temp::Label &loopDone) {
+Expression Translator::translateForLoop(
+  const Expression &var, const Expression &from, const Expression &to,
+  const Expression &body, const temp::Label &loopDone,
+  const boost::optional<Expression> &frameSlot) {
   auto limit     = m_tempMap.newTemp();
   auto loopStart = m_tempMap.newLabel();
 
@@ -249,12 +291,19 @@ Expression Translator::translateForLoop(const Expression &var,
   helpers::assertTypes<ir::Expression, temp::Register, ir::MemoryAccess>(
     counter);
 
+  auto loopBody = toStatement(body);
+  if (frameSlot) {
+    auto slot = toExpression(*frameSlot);
+    helpers::assertTypes<ir::Expression, ir::MemoryAccess>(slot);
+    loopBody = ir::Sequence{ir::Move{counter, slot}, loopBody};
+  }
+
   return ir::Sequence{
     ir::Move{toExpression(from), counter},
     ir::Move{toExpression(to), limit},
     ir::ConditionalJump{ir::RelOp::GT, counter, limit, loopDone, loopStart},
     loopStart,
-    toStatement(body),
+    loopBody,
     ir::Move{ir::BinaryOperation{ir::BinOp::PLUS, counter, 1}, counter},
     ir::ConditionalJump{ir::RelOp::LT, counter, limit, loopStart, loopDone},
     loopDone};
@@ -263,12 +312,21 @@ Expression Translator::translateForLoop(const Expression &var,
 Expression Translator::translateCall(const std::vector<Level> &nestingLevels,
                                      const temp::Label &functionLabel,
                                      Level functionLevel,
-                                     const std::vector<Expression> &arguments) {
-  auto staticLink =
-    m_callingConvention.accessFrame(m_frames[functionLevel]->formals().front(),
-                                    framePointer(nestingLevels, functionLevel));
-  std::vector<ir::Expression> argExpressions{staticLink};
+                                     const std::vector<Expression> &arguments,
+                                     StaticLink staticLink) {
+  std::vector<ir::Expression> argExpressions;
   argExpressions.reserve(arguments.size() + 1);
+  switch (staticLink) {
+    case StaticLink::FRAME:
+      // the function reaches outer frames from the one it is declared in
+      argExpressions.push_back(framePointer(nestingLevels, functionLevel));
+      break;
+    case StaticLink::IGNORED:
+      argExpressions.emplace_back(0);
+      break;
+    case StaticLink::NONE:
+      break;
+  }
   std::transform(arguments.begin(), arguments.end(),
                  std::back_inserter(argExpressions),
                  [this](const Expression &arg) { return toExpression(arg); });
@@ -282,6 +340,17 @@ Expression Translator::translateVarDecleration(const Expression &access,
   return ir::Move{toExpression(init), var};
 }
 
+Expression Translator::translateVarDecleration(const Expression &access,
+                                               const Expression &copy,
+                                               const Expression &init) {
+  auto var     = toExpression(access);
+  auto copyVar = toExpression(copy);
+  helpers::assertTypes<ir::Expression, ir::MemoryAccess>(var);
+  helpers::assertTypes<ir::Expression, temp::Register>(copyVar);
+  return ir::Sequence{ir::Move{toExpression(init), copyVar},
+                      ir::Move{copyVar, var}};
+}
+
 Expression Translator::translateLet(const std::vector<Expression> &declarations,
                                     const std::vector<Expression> &body) {
   ir::ExpressionSequence res;
@@ -305,11 +374,16 @@ Expression Translator::translateLet(const std::vector<Expression> &declarations,
 
 void Translator::translateFunction(Level level, const temp::Label &label,
                                    const Expression &body) {
-  auto &frame        = m_frames[level];
+  auto &frame = m_frames[level];
+  auto result = toExpression(body);
+  if (m_displays.count(level) != 0) {
+    result = ir::ExpressionSequence{copyDisplay(level), result};
+  }
   auto augmentedBody = ir::Sequence{
     label, frame->procEntryExit1(
-             ir::Move{toExpression(body), m_callingConvention.returnValue()})};
-  m_fragments.emplace_back(FunctionFragment{augmentedBody, frame});
+             ir::Move{result, m_callingConvention.returnValue()})};
+  m_fragments.emplace_back(
+    FunctionFragment{augmentedBody, frame, m_staticLinks[level]});
 }
 
 Expression Translator::translateAssignment(const Expression &var,
@@ -330,10 +404,20 @@ void Translator::doPatch(const PatchList &patchList, const temp::Label &label) {
 
 ir::Expression Translator::framePointer(const std::vector<Level> &nestingLevels,
                                         Level level) {
+  if (m_nonLocalAccess == NonLocalAccess::DISPLAY) {
+    auto const it =
+      std::find(nestingLevels.rbegin(), nestingLevels.rend(), level);
+    assert(it != nestingLevels.rend() && "variable access level not found");
+    return displayedFrame(nestingLevels,
+                          static_cast<size_t>(nestingLevels.rend() - it) - 1);
+  }
+
   // strip off static links until deceleration level is reached
   auto levelIt       = nestingLevels.rbegin();
   ir::Expression res = m_callingConvention.framePointer();
   for (; levelIt != nestingLevels.rend() && *levelIt != level; ++levelIt) {
+    assert(m_staticLinks[*levelIt]
+           && "a function without a static link can't reach outer frames");
     const auto &frame = *m_frames[*levelIt];
     auto staticLink   = frame.formals().front();
     res               = m_callingConvention.accessFrame(staticLink, res);
@@ -342,5 +426,68 @@ ir::Expression Translator::framePointer(const std::vector<Level> &nestingLevels,
   return res;
 }
 
+ir::Expression
+  Translator::displayedFrame(const std::vector<Level> &nestingLevels,
+                             size_t depth) {
+  auto const current      = nestingLevels.size() - 1;
+  auto const framePointer = m_callingConvention.framePointer();
+  if (depth == current) {
+    return framePointer;
+  }
+
+  auto const level = nestingLevels[current];
+  assert(m_staticLinks[level]
+         && "a function without a static link can't reach outer frames");
+  if (depth + 1 == current) {
+    return m_callingConvention.accessFrame(m_frames[level]->formals().front(),
+                                           framePointer);
+  }
+
+  return m_callingConvention.accessFrame(
+    displaySlot(nestingLevels, current, depth), framePointer);
+}
+
+frame::VariableAccess
+  Translator::displaySlot(const std::vector<Level> &nestingLevels,
+                          size_t current, size_t depth) {
+  auto const level = nestingLevels[current];
+  auto &display    = m_displays[level];
+  display.m_parent = nestingLevels[current - 1];
+  display.m_depth  = current;
+  auto const found = display.m_slots.find(depth);
+  if (found != display.m_slots.end()) {
+    return found->second;
+  }
+
+  // the parent's static link is copied directly, anything further must be in
+  // the parent's display
+  if (depth + 2 < current) {
+    displaySlot(nestingLevels, current - 1, depth);
+  }
+  auto const slot = m_frames[level]->allocateLocal(true);
+  display.m_slots.emplace(depth, slot);
+  return slot;
+}
+
+ir::Statement Translator::copyDisplay(Level level) const {
+  auto const &display     = m_displays.at(level);
+  auto const framePointer = m_callingConvention.framePointer();
+  auto const staticLink   = m_callingConvention.accessFrame(
+    m_frames[level]->formals().front(), framePointer);
+  auto const &parentFrame = *m_frames[display.m_parent];
+
+  ir::Sequence res;
+  for (const auto &slot : display.m_slots) {
+    auto const source = slot.first + 2 == display.m_depth
+                          ? parentFrame.formals().front()
+                          : m_displays.at(display.m_parent).m_slots.at(
+                              slot.first);
+    res.statements.emplace_back(
+      ir::Move{m_callingConvention.accessFrame(source, staticLink),
+               m_callingConvention.accessFrame(slot.second, framePointer)});
+  }
+  return res;
+}
+
 } // namespace translator
 } // namespace tiger
@@ -3,6 +3,8 @@
 #include "Frame.h"
 #include "Tree.h"
 #include <boost/optional.hpp>
+#include <map>
+#include <unordered_map>
 
 namespace tiger {
 
@@ -23,6 +25,33 @@ using Expression = boost::variant<ir::Expression, ir::Statement, Condition>;
 
 using Level = size_t;
 
+// the static link passed to a called function
+enum class StaticLink {
+  // the frame of the level the function is declared in
+  FRAME,
+  // the function doesn't have one
+  NONE,
+  // the function ignores it, so no frame is looked up
+  IGNORED
+};
+
+// how the frames of enclosing functions are reached
+enum class NonLocalAccess {
+  // following the static links, a load per nesting level
+  STATIC_LINKS,
+  // each frame keeps the frame pointers of the enclosing levels it needs, so
+  // any of them is a single load away
+  DISPLAY
+};
+
+// how records and arrays are allocated
+enum class Allocation {
+  // by malloc, never freed
+  MALLOC,
+  // from the garbage collected heap, with descriptors of their pointers
+  COLLECTED
+};
+
 struct VariableAccess {
   Level level;
   frame::VariableAccess frameAccess;
@@ -30,10 +59,13 @@ struct VariableAccess {
 
 class Translator {
 public:
-  Translator(temp::Map &tempMap, frame::CallingConvention &callingConvention);
+  Translator(temp::Map &tempMap, frame::CallingConvention &callingConvention,
+             NonLocalAccess nonLocalAccess = NonLocalAccess::STATIC_LINKS,
+             Allocation allocation         = Allocation::MALLOC);
 
   Level outermost() const;
-  Level newLevel(temp::Label label, const frame::BoolList &formals);
+  Level newLevel(temp::Label label, const frame::BoolList &formals,
+                 bool staticLink = true);
   std::vector<VariableAccess> formals(Level level);
   VariableAccess allocateLocal(Level level, bool escapes);
 
@@ -64,9 +96,12 @@ public:
 
   Expression translateString(const std::string &value);
 
-  Expression translateRecord(const std::vector<Expression> &fields);
+  // pointers tells which fields point to records or arrays
+  Expression translateRecord(const std::vector<Expression> &fields,
+                             const std::vector<bool> &pointers);
 
-  Expression translateArray(const Expression &size, const Expression &value);
+  Expression translateArray(const Expression &size, const Expression &value,
+                            bool pointers);
 
   temp::Label loopDone();
 
@@ -75,18 +110,28 @@ public:
 
   Expression translateBreak(const temp::Label &loopDone);
 
-  Expression translateForLoop(const Expression &var, const Expression &from,
-                              const Expression &to, const Expression &body,
-                              const temp::Label &loopDone);
+  // an escaping counter is kept in var and copied to its frame slot before
+  // each iteration
+  Expression
+    translateForLoop(const Expression &var, const Expression &from,
+                     const Expression &to, const Expression &body,
+                     const temp::Label &loopDone,
+                     const boost::optional<Expression> &frameSlot = {});
 
   Expression translateCall(const std::vector<Level> &nestingLevels,
                            const temp::Label &functionLabel,
                            Level functionLevel,
-                           const std::vector<Expression> &arguments);
+                           const std::vector<Expression> &arguments,
+                           StaticLink staticLink = StaticLink::FRAME);
 
   Expression translateVarDecleration(const Expression &access,
                                      const Expression &init);
 
+  // initializes both an escaping variable and its copy in a register
+  Expression translateVarDecleration(const Expression &access,
+                                     const Expression &copy,
+                                     const Expression &init);
+
   Expression translateLet(const std::vector<Expression> &declarations,
                           const std::vector<Expression> &body);
 
@@ -105,10 +150,41 @@ private:
   ir::Expression framePointer(const std::vector<Level> &nestingLevels,
                               Level level);
 
+  // the frame pointer of nestingLevels[depth] using the displays
+  ir::Expression displayedFrame(const std::vector<Level> &nestingLevels,
+                                size_t depth);
+
+  // the slot of nestingLevels[current] keeping the frame pointer of
+  // nestingLevels[depth], allocated on first use
+  frame::VariableAccess displaySlot(const std::vector<Level> &nestingLevels,
+                                    size_t current, size_t depth);
+
+  // the label of a string describing a record with pointers, as the
+  // runtime's allocRecord expects
+  temp::Label recordDescriptor(const std::vector<bool> &pointers);
+
+  // copies the display of level from the display of its parent
+  ir::Statement copyDisplay(Level level) const;
+
+  struct Display {
+    Level m_parent;
+    // nesting depth of the level
+    size_t m_depth;
+    // by the depth of the level whose frame pointer they keep
+    std::map<size_t, frame::VariableAccess> m_slots;
+  };
+
   temp::Map &m_tempMap;
   frame::CallingConvention &m_callingConvention;
+  NonLocalAccess m_nonLocalAccess;
+  Allocation m_allocation;
   std::vector<std::shared_ptr<frame::Frame>> m_frames;
+  // whether the frame of each level has a static link
+  std::vector<bool> m_staticLinks;
+  std::unordered_map<Level, Display> m_displays;
   FragmentList m_fragments;
+  // by their string
+  std::unordered_map<std::string, temp::Label> m_descriptors;
   const int m_wordSize;
   Level m_outermost;
 };
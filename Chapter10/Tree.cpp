@@ -250,5 +250,80 @@ RelOp commute(RelOp op) {
   }
 }
 
+bool isJump(const Statement &stm) {
+  return helpers::hasType<Jump>(stm) || helpers::hasType<ConditionalJump>(stm);
+}
+
+bool equal(const Expression &left, const Expression &right) {
+  return helpers::match(left, right)(
+    [](int l, int r) { return l == r; },
+    [](const temp::Label &l, const temp::Label &r) { return l == r; },
+    [](const temp::Register &l, const temp::Register &r) { return l == r; },
+    [](const BinaryOperation &l, const BinaryOperation &r) {
+      return l.op == r.op && equal(l.left, r.left) && equal(l.right, r.right);
+    },
+    [](const MemoryAccess &l, const MemoryAccess &r) {
+      return equal(l.address, r.address);
+    },
+    [](const auto &, const auto &) { return false; });
+}
+
+Expression replaceUses(const Expression &exp, const RegisterMapping &mapping) {
+  return helpers::match(exp)(
+    [&](const temp::Register &reg) { return mapping(reg); },
+    [&](const BinaryOperation &binOperation) -> Expression {
+      return BinaryOperation{binOperation.op,
+                             replaceUses(binOperation.left, mapping),
+                             replaceUses(binOperation.right, mapping)};
+    },
+    [&](const MemoryAccess &memAccess) -> Expression {
+      return MemoryAccess{replaceUses(memAccess.address, mapping)};
+    },
+    [&](const ExpressionSequence &expSequence) -> Expression {
+      return ExpressionSequence{replaceUses(expSequence.stm, mapping),
+                                replaceUses(expSequence.exp, mapping)};
+    },
+    [&](const Call &call) -> Expression {
+      Call res{replaceUses(call.fun, mapping), {}};
+      res.args.reserve(call.args.size());
+      for (const auto &arg : call.args) {
+        res.args.push_back(replaceUses(arg, mapping));
+      }
+      return res;
+    },
+    [](const auto &exp) -> Expression { return exp; });
+}
+
+Statement replaceUses(const Statement &stm, const RegisterMapping &mapping) {
+  return helpers::match(stm)(
+    [&](const Sequence &sequence) -> Statement {
+      Statements statements;
+      statements.reserve(sequence.statements.size());
+      for (const auto &stm : sequence.statements) {
+        statements.push_back(replaceUses(stm, mapping));
+      }
+      return Sequence{std::move(statements)};
+    },
+    [&](const Move &move) -> Statement {
+      return helpers::match(move.dst)(
+        [&](const MemoryAccess &memAccess) -> Statement {
+          return Move{replaceUses(move.src, mapping),
+                      MemoryAccess{replaceUses(memAccess.address, mapping)}};
+        },
+        [&](const auto &dst) -> Statement {
+          return Move{replaceUses(move.src, mapping), dst};
+        });
+    },
+    [&](const ExpressionStatement &expStatement) -> Statement {
+      return ExpressionStatement{replaceUses(expStatement.exp, mapping)};
+    },
+    [&](const ConditionalJump &cjump) -> Statement {
+      return ConditionalJump{cjump.op, replaceUses(cjump.left, mapping),
+                             replaceUses(cjump.right, mapping),
+                             *cjump.trueDest, *cjump.falseDest};
+    },
+    [](const auto &stm) -> Statement { return stm; });
+}
+
 } // namespace ir
 } // namespace tiger
@@ -3,6 +3,7 @@
 #include "variantMatch.h"
 #include <boost/optional.hpp>
 #include <boost/variant/recursive_variant.hpp>
+#include <functional>
 #include <iosfwd>
 #include <vector>
 
@@ -151,6 +152,18 @@ RelOp notRel(RelOp op);
 /* a op b    ==    b commute(op) a       */
 RelOp commute(RelOp op);
 
+/* whether a statement is a jump or a conditional jump */
+bool isJump(const Statement &stm);
+
+/* structural equality of expressions without statements or calls */
+bool equal(const Expression &left, const Expression &right);
+
+/* replaces the registers read by an expression or a statement, a register
+ * written by a move is not replaced */
+using RegisterMapping = std::function<Expression(const temp::Register &)>;
+Expression replaceUses(const Expression &exp, const RegisterMapping &mapping);
+Statement replaceUses(const Statement &stm, const RegisterMapping &mapping);
+
 } // namespace ir
 
 } // namespace tiger
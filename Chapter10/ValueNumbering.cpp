@@ -0,0 +1,227 @@
+#include "ValueNumbering.h"
+#include "Simplifier.h"
+#include "variantMatch.h"
+#include <algorithm>
+#include <boost/optional.hpp>
+
+namespace tiger {
+
+using helpers::hasType;
+using helpers::match;
+
+namespace {
+
+int occurrences(const ir::Expression &exp, const ir::Expression &of) {
+  if (ir::equal(exp, of)) {
+    return 1;
+  }
+
+  return match(exp)(
+    [&](const ir::BinaryOperation &binOperation) {
+      return occurrences(binOperation.left, of)
+             + occurrences(binOperation.right, of);
+    },
+    [&](const ir::MemoryAccess &memAccess) {
+      return occurrences(memAccess.address, of);
+    },
+    [&](const ir::Call &call) {
+      int res = occurrences(call.fun, of);
+      for (const auto &arg : call.args) {
+        res += occurrences(arg, of);
+      }
+      return res;
+    },
+    [](const auto & /*default*/) { return 0; });
+}
+
+// number of times of is evaluated when stm is executed
+int occurrences(const ir::Statement &stm, const ir::Expression &of) {
+  return match(stm)(
+    [&](const ir::Move &move) {
+      return occurrences(move.src, of)
+             + match(move.dst)(
+                 [&](const ir::MemoryAccess &memAccess) {
+                   return occurrences(memAccess.address, of);
+                 },
+                 [](const auto & /*default*/) { return 0; });
+    },
+    [&](const ir::ExpressionStatement &expStatement) {
+      return occurrences(expStatement.exp, of);
+    },
+    [&](const ir::Jump &jump) { return occurrences(jump.exp, of); },
+    [&](const ir::ConditionalJump &cjump) {
+      return occurrences(cjump.left, of) + occurrences(cjump.right, of);
+    },
+    [](const auto & /*default*/) { return 0; });
+}
+
+} // namespace
+
+ValueNumbering::ValueNumbering(temp::Map &tempMap,
+                               const temp::Register &framePointer) :
+    m_tempMap{tempMap},
+    m_sideEffects{framePointer} {}
+
+ir::Statements ValueNumbering::eliminate(ir::Statements &&statements) const {
+  ir::Statements res;
+  res.reserve(statements.size());
+  AvailableExpressions available;
+  ir::Statements moves;
+
+  for (auto it = statements.cbegin(); it != statements.cend(); ++it) {
+    if (hasType<temp::Label>(*it)) {
+      // a new basic block starts
+      available.clear();
+    }
+
+    Context context{it, statements.cend(), available, moves};
+    boost::optional<Available> defined;
+    auto rewritten = match(*it)(
+      [&](const ir::Move &move) -> ir::Statement {
+        return match(move.dst)(
+          [&](const temp::Register &reg) -> ir::Statement {
+            auto found = std::find_if(
+              available.begin(), available.end(), [&](const Available &a) {
+                return ir::equal(a.m_expression, move.src);
+              });
+            if (temp::isMachineRegister(reg) || !isCandidate(move.src)
+                || found != available.end()) {
+              return ir::Move{rewrite(move.src, context, nullptr, 0), reg};
+            }
+            // reg will hold the value of move.src, no need for a new temp
+            defined = Available{move.src, reg};
+            return ir::Move{
+              rewrite(move.src, context, &move.src, uses(move.src, context)),
+              reg};
+          },
+          [&](const ir::MemoryAccess &memAccess) -> ir::Statement {
+            auto src = rewrite(move.src, context, nullptr, 0);
+            return ir::Move{
+              src, ir::MemoryAccess{
+                     rewrite(memAccess.address, context, nullptr, 0)}};
+          },
+          [&](const auto &dst) -> ir::Statement {
+            return ir::Move{rewrite(move.src, context, nullptr, 0), dst};
+          });
+      },
+      [&](const ir::ExpressionStatement &expStatement) -> ir::Statement {
+        return ir::ExpressionStatement{
+          rewrite(expStatement.exp, context, nullptr, 0)};
+      },
+      [&](const ir::ConditionalJump &cjump) -> ir::Statement {
+        return ir::ConditionalJump{
+          cjump.op, rewrite(cjump.left, context, nullptr, 0),
+          rewrite(cjump.right, context, nullptr, 0), *cjump.trueDest,
+          *cjump.falseDest};
+      },
+      [](const auto &stm) -> ir::Statement { return stm; });
+
+    std::move(moves.begin(), moves.end(), std::back_inserter(res));
+    moves.clear();
+    res.push_back(std::move(rewritten));
+
+    if (ir::isJump(*it)) {
+      available.clear();
+      continue;
+    }
+
+    auto const killed = [&](const Available &a) {
+      return m_sideEffects.kills(*it, a.m_expression)
+             || m_sideEffects.kills(*it, a.m_temp);
+    };
+    available.erase(std::remove_if(available.begin(), available.end(), killed),
+                    available.end());
+    if (defined && !m_sideEffects.kills(*it, defined->m_expression)) {
+      available.push_back(std::move(*defined));
+    }
+  }
+
+  return res;
+}
+
+ir::Expression ValueNumbering::rewrite(const ir::Expression &exp,
+                                       Context &context,
+                                       const ir::Expression *ancestor,
+                                       int ancestorUses) const {
+  auto const candidate = isCandidate(exp);
+  auto materialize     = false;
+  if (candidate && ancestor != &exp) {
+    auto found = std::find_if(
+      context.m_available.begin(), context.m_available.end(),
+      [&exp](const Available &a) { return ir::equal(a.m_expression, exp); });
+    if (found != context.m_available.end()) {
+      return found->m_temp;
+    }
+
+    auto expUses = uses(exp, context);
+    if (ancestor) {
+      // evaluations inside the materialized ancestor happen only once
+      expUses -= (ancestorUses - 1) * occurrences(*ancestor, exp);
+    }
+    materialize = expUses >= 2;
+    if (materialize) {
+      ancestor     = &exp;
+      ancestorUses = expUses;
+    }
+  }
+
+  auto rewritten = match(exp)(
+    [&](const ir::BinaryOperation &binOperation) -> ir::Expression {
+      return ir::BinaryOperation{
+        binOperation.op,
+        rewrite(binOperation.left, context, ancestor, ancestorUses),
+        rewrite(binOperation.right, context, ancestor, ancestorUses)};
+    },
+    [&](const ir::MemoryAccess &memAccess) -> ir::Expression {
+      return ir::MemoryAccess{
+        rewrite(memAccess.address, context, ancestor, ancestorUses)};
+    },
+    [&](const ir::Call &call) -> ir::Expression {
+      ir::Call res{call.fun, {}};
+      res.args.reserve(call.args.size());
+      for (const auto &arg : call.args) {
+        res.args.push_back(rewrite(arg, context, ancestor, ancestorUses));
+      }
+      return res;
+    },
+    [](const auto &exp) -> ir::Expression { return exp; });
+
+  if (!materialize) {
+    return rewritten;
+  }
+
+  auto t = m_tempMap.newTemp();
+  context.m_moves.emplace_back(ir::Move{rewritten, t});
+  context.m_available.push_back({exp, t});
+  return t;
+}
+
+int ValueNumbering::uses(const ir::Expression &exp,
+                         const Context &context) const {
+  int res = 0;
+  for (auto it = context.m_current; it != context.m_last; ++it) {
+    if (it != context.m_current && hasType<temp::Label>(*it)) {
+      break;
+    }
+    res += occurrences(*it, exp);
+    if (ir::isJump(*it) || m_sideEffects.kills(*it, exp)) {
+      break;
+    }
+  }
+  return res;
+}
+
+bool ValueNumbering::isCandidate(const ir::Expression &exp) const {
+  return match(exp)(
+    [&](const ir::BinaryOperation &binOperation) {
+      // register + constant is folded into the addressing mode
+      auto const addressing = binOperation.op == ir::BinOp::PLUS
+                              && hasType<temp::Register>(binOperation.left)
+                              && hasType<int>(binOperation.right);
+      return !addressing && Simplifier::isPure(exp);
+    },
+    [&](const ir::MemoryAccess &) { return Simplifier::isPure(exp); },
+    [](const auto & /*default*/) { return false; });
+}
+
+} // namespace tiger
@@ -0,0 +1,44 @@
+#pragma once
+#include "SideEffects.h"
+#include "Tree.h"
+
+namespace tiger {
+
+// local value numbering: pure expressions that are computed more than once
+// inside a basic block are computed once into a temporary, which is then
+// reused until a statement invalidates it
+class ValueNumbering {
+public:
+  ValueNumbering(temp::Map &tempMap, const temp::Register &framePointer);
+
+  ir::Statements eliminate(ir::Statements &&statements) const;
+
+private:
+  struct Available {
+    ir::Expression m_expression;
+    temp::Register m_temp;
+  };
+
+  using AvailableExpressions = std::vector<Available>;
+
+  struct Context {
+    ir::Statements::const_iterator m_current, m_last;
+    AvailableExpressions &m_available;
+    ir::Statements &m_moves;
+  };
+
+  ir::Expression rewrite(const ir::Expression &exp, Context &context,
+                         const ir::Expression *materializedAncestor,
+                         int ancestorUses) const;
+
+  // number of times exp is evaluated from the current statement until the
+  // end of the block or until its value changes
+  int uses(const ir::Expression &exp, const Context &context) const;
+
+  bool isCandidate(const ir::Expression &exp) const;
+
+  temp::Map &m_tempMap;
+  SideEffects m_sideEffects;
+};
+
+} // namespace tiger
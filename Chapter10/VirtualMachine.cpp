@@ -0,0 +1,376 @@
+#include "VirtualMachine.h"
+#include "warning_suppress.h"
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef __GNUC__
+#define DIRECT_THREADING
+#endif
+
+namespace tiger {
+
+using bytecode::FixedRegister;
+using bytecode::Opcode;
+using bytecode::RuntimeFunction;
+
+namespace {
+using Word = VirtualMachine::Word;
+using Slot = std::int64_t;
+using Unsigned = std::uint64_t;
+
+// records are never allocated at addresses below it, so an access based
+// there is through nil
+constexpr Unsigned NIL_PAGE = 4096;
+
+struct Activation {
+  Word *m_registers;
+  // where the frame starts and ends
+  Word *m_base;
+  Word *m_top;
+  const Slot *m_return;
+  // the register receiving the result, or -1
+  Slot m_result;
+};
+
+// the frames are the roots of the collected heap while the program runs
+class Roots {
+public:
+  Roots(Heap &heap, const Word *stack, Word *const &top) : m_heap(heap) {
+    m_heap.setRoots([stack, &top] { return std::make_pair(stack, top); });
+  }
+
+  Roots(const Roots &) = delete;
+  Roots &operator=(const Roots &) = delete;
+
+  ~Roots() { m_heap.setRoots({}); }
+
+private:
+  Heap &m_heap;
+};
+
+// arithmetic wraps around, as it does natively
+Word add(Word lhs, Word rhs) {
+  return static_cast<Word>(static_cast<Unsigned>(lhs)
+                           + static_cast<Unsigned>(rhs));
+}
+
+Word subtract(Word lhs, Word rhs) {
+  return static_cast<Word>(static_cast<Unsigned>(lhs)
+                           - static_cast<Unsigned>(rhs));
+}
+
+Word multiply(Word lhs, Word rhs) {
+  return static_cast<Word>(static_cast<Unsigned>(lhs)
+                           * static_cast<Unsigned>(rhs));
+}
+
+Word divide(Word lhs, Word rhs) {
+  if (rhs == 0) {
+    throw std::logic_error{"Division by zero"};
+  }
+  return lhs / rhs;
+}
+
+Word *memory(Word base, Slot offset) {
+  if (static_cast<Unsigned>(base) < NIL_PAGE) {
+    throw std::logic_error{"Nil dereference"};
+  }
+  return reinterpret_cast<Word *>(add(base, offset));
+}
+} // namespace
+
+VirtualMachine::VirtualMachine(bytecode::Program program, size_t stackWords) :
+    m_program{std::move(program)}, m_stack{new Word[stackWords]()},
+    m_stackWords{stackWords} {}
+
+GCC_DIAG_OFF(pedantic)
+CLANG_DIAG_OFF(gnu-label-as-value)
+VirtualMachine::Word VirtualMachine::run(Runtime &runtime) {
+  auto code = m_program.m_code;
+
+#ifdef DIRECT_THREADING
+  static void *const handlers[] = {
+    &&CONST_,      &&STRING_,       &&MOVE_,      &&ADD_,  &&SUB_,
+    &&MUL_,        &&DIV_,          &&AND_,       &&OR_,   &&SHL_,
+    &&SHR_,        &&SAR_,          &&XOR_,       &&ADDI_, &&LOAD_,
+    &&STORE_,      &&JUMP_,         &&JEQ_,       &&JNE_,  &&JLT_,
+    &&JGT_,        &&JLE_,          &&JGE_,       &&JULT_, &&JULE_,
+    &&JUGT_,       &&JUGE_,         &&CALL_,      &&CALL_RUNTIME_,
+    &&TAIL_CALL_,  &&RETURN_};
+  static_assert(sizeof(handlers) / sizeof(handlers[0])
+                  == static_cast<size_t>(Opcode::OPCODES),
+                "every opcode needs a handler");
+
+  for (size_t position = 0; position < code.size();) {
+    auto const opcode = static_cast<Opcode>(code[position]);
+    auto size         = 1 + bytecode::operands(opcode);
+    if (opcode == Opcode::CALL || opcode == Opcode::CALL_RUNTIME) {
+      size += static_cast<size_t>(code[position + 3]);
+    }
+    code[position] =
+      reinterpret_cast<Slot>(handlers[static_cast<size_t>(opcode)]);
+    position += size;
+  }
+
+#define INSTRUCTION(opcode) opcode##_:
+#define NEXT() goto *reinterpret_cast<void *>(*pc)
+#else
+#define INSTRUCTION(opcode) case Opcode::opcode:
+#define NEXT() goto dispatch
+#endif
+
+  std::vector<Word> strings;
+  strings.reserve(m_program.m_constants.size());
+  for (const auto &string : m_program.m_constants) {
+    strings.push_back(reinterpret_cast<Word>(string.c_str()));
+  }
+
+  auto const &functions        = m_program.m_functions;
+  auto const argumentRegisters = m_program.m_argumentRegisters;
+  std::vector<Word> tailArguments(argumentRegisters);
+  std::vector<Activation> activations;
+  auto const stackEnd = m_stack.get() + m_stackWords;
+  Word *base          = m_stack.get();
+  Word *top           = base;
+  const Slot *pc      = nullptr;
+  Roots const roots{runtime.heap(), m_stack.get(), top};
+
+  // the arguments are written from the frame pointer it returns
+  auto const frameOf = [&](const bytecode::Function &function, Word *start,
+                           size_t count) {
+    auto const frame = start + function.m_locals;
+    if (frame + count + function.m_registers > stackEnd) {
+      throw std::logic_error{"Stack overflow"};
+    }
+    return frame;
+  };
+
+  auto const enter = [&](const bytecode::Function &function, Word *frame,
+                         size_t count) {
+    auto const registers = frame + count;
+    top                  = registers + function.m_registers;
+    registers[FixedRegister::FRAME_POINTER] = reinterpret_cast<Word>(frame);
+    registers[FixedRegister::STACK_POINTER] = reinterpret_cast<Word>(frame);
+    registers[FixedRegister::RETURN_VALUE]  = 0;
+    std::copy_n(frame, std::min(count, argumentRegisters),
+                registers + FixedRegister::FIRST_ARGUMENT);
+    pc = code.data() + function.m_entry;
+    return registers;
+  };
+
+  // main gets an empty static link, like the runtime's main passes
+  auto const &main = functions[m_program.m_main];
+  auto const frame = frameOf(main, base, 1);
+  frame[0]         = 0;
+  Word *r          = enter(main, frame, 1);
+
+#ifdef DIRECT_THREADING
+  NEXT();
+#else
+dispatch:
+  switch (static_cast<Opcode>(*pc)) {
+#endif
+
+  INSTRUCTION(CONST) {
+    r[pc[1]] = pc[2];
+    pc += 3;
+    NEXT();
+  }
+
+  INSTRUCTION(STRING) {
+    r[pc[1]] = strings[static_cast<size_t>(pc[2])];
+    pc += 3;
+    NEXT();
+  }
+
+  INSTRUCTION(MOVE) {
+    r[pc[1]] = r[pc[2]];
+    pc += 3;
+    NEXT();
+  }
+
+#define BINARY(opcode, expression)                                           \
+  INSTRUCTION(opcode) {                                                      \
+    auto const lhs = r[pc[2]];                                               \
+    auto const rhs = r[pc[3]];                                               \
+    r[pc[1]]       = (expression);                                           \
+    pc += 4;                                                                 \
+    NEXT();                                                                  \
+  }
+
+  BINARY(ADD, add(lhs, rhs))
+  BINARY(SUB, subtract(lhs, rhs))
+  BINARY(MUL, multiply(lhs, rhs))
+  BINARY(DIV, divide(lhs, rhs))
+  BINARY(AND, lhs & rhs)
+  BINARY(OR, lhs | rhs)
+  BINARY(SHL, static_cast<Word>(static_cast<Unsigned>(lhs) << (rhs & 63)))
+  BINARY(SHR, static_cast<Word>(static_cast<Unsigned>(lhs) >> (rhs & 63)))
+  BINARY(SAR, lhs >> (rhs & 63))
+  BINARY(XOR, lhs ^ rhs)
+#undef BINARY
+
+  INSTRUCTION(ADDI) {
+    r[pc[1]] = add(r[pc[2]], pc[3]);
+    pc += 4;
+    NEXT();
+  }
+
+  INSTRUCTION(LOAD) {
+    r[pc[1]] = *memory(r[pc[2]], pc[3]);
+    pc += 4;
+    NEXT();
+  }
+
+  INSTRUCTION(STORE) {
+    *memory(r[pc[1]], pc[2]) = r[pc[3]];
+    pc += 4;
+    NEXT();
+  }
+
+  INSTRUCTION(JUMP) {
+    pc = code.data() + pc[1];
+    NEXT();
+  }
+
+#define JUMP_IF(opcode, type, comparison)                                     \
+  INSTRUCTION(opcode) {                                                       \
+    pc = static_cast<type>(r[pc[1]]) comparison static_cast<type>(r[pc[2]])   \
+           ? code.data() + pc[3]                                              \
+           : pc + 4;                                                          \
+    NEXT();                                                                   \
+  }
+
+  JUMP_IF(JEQ, Word, ==)
+  JUMP_IF(JNE, Word, !=)
+  JUMP_IF(JLT, Word, <)
+  JUMP_IF(JGT, Word, >)
+  JUMP_IF(JLE, Word, <=)
+  JUMP_IF(JGE, Word, >=)
+  JUMP_IF(JULT, Unsigned, <)
+  JUMP_IF(JULE, Unsigned, <=)
+  JUMP_IF(JUGT, Unsigned, >)
+  JUMP_IF(JUGE, Unsigned, >=)
+#undef JUMP_IF
+
+  INSTRUCTION(CALL) {
+    auto const &function = functions[static_cast<size_t>(pc[1])];
+    auto const count     = static_cast<size_t>(pc[3]);
+    auto const frame     = frameOf(function, top, count);
+    for (size_t i = 0; i < count; ++i) {
+      frame[i] = r[pc[4 + i]];
+    }
+    activations.push_back(Activation{r, base, top, pc + 4 + count, pc[2]});
+    base = top;
+    r    = enter(function, frame, count);
+    NEXT();
+  }
+
+  INSTRUCTION(CALL_RUNTIME) {
+    auto const count = pc[3];
+    auto const value = callRuntime(
+      runtime, static_cast<RuntimeFunction>(pc[1]), pc + 4, count, r);
+    if (runtime.exitStatus()) {
+      return *runtime.exitStatus();
+    }
+    if (pc[2] >= 0) {
+      r[pc[2]] = value;
+    }
+    pc += 4 + count;
+    NEXT();
+  }
+
+  INSTRUCTION(TAIL_CALL) {
+    // the arguments are in registers and the callee replaces the frame
+    auto const &function = functions[static_cast<size_t>(pc[1])];
+    std::copy_n(r + FixedRegister::FIRST_ARGUMENT, argumentRegisters,
+                tailArguments.begin());
+    auto const frame = frameOf(function, base, argumentRegisters);
+    std::copy(tailArguments.begin(), tailArguments.end(), frame);
+    r = enter(function, frame, argumentRegisters);
+    NEXT();
+  }
+
+  INSTRUCTION(RETURN) {
+    auto const value = r[FixedRegister::RETURN_VALUE];
+    if (activations.empty()) {
+      return value;
+    }
+    auto const &activation = activations.back();
+    r    = activation.m_registers;
+    base = activation.m_base;
+    top  = activation.m_top;
+    pc   = activation.m_return;
+    if (activation.m_result >= 0) {
+      r[activation.m_result] = value;
+    }
+    activations.pop_back();
+    NEXT();
+  }
+
+#ifndef DIRECT_THREADING
+    default:
+      break;
+  }
+  throw std::logic_error{"Unknown opcode"};
+#endif
+
+#undef INSTRUCTION
+#undef NEXT
+}
+CLANG_DIAG_ON(gnu-label-as-value)
+GCC_DIAG_ON(pedantic)
+
+VirtualMachine::Word VirtualMachine::callRuntime(Runtime &runtime,
+                                                 RuntimeFunction function,
+                                                 const Slot *arguments,
+                                                 Slot count,
+                                                 const Word *registers) {
+  auto const argument = [&](Slot i) {
+    if (i >= count) {
+      throw std::logic_error{"Too few arguments to a runtime function"};
+    }
+    return registers[arguments[i]];
+  };
+
+  switch (function) {
+    case RuntimeFunction::MALLOC:
+      return runtime.malloc(argument(0));
+    case RuntimeFunction::INIT_ARRAY:
+      runtime.initArray(argument(0), argument(1));
+      return 0;
+    case RuntimeFunction::ALLOC_RECORD:
+      return runtime.allocRecord(argument(0));
+    case RuntimeFunction::ALLOC_ARRAY:
+      return runtime.allocArray(argument(0), argument(1), argument(2));
+    case RuntimeFunction::STRING_COMPARE:
+      return runtime.stringCompare(argument(0), argument(1));
+    // the library's functions get a static link first
+    case RuntimeFunction::PRINT:
+      runtime.print(argument(1));
+      return 0;
+    case RuntimeFunction::FLUSH:
+      runtime.flush();
+      return 0;
+    case RuntimeFunction::GETCHAR:
+      return runtime.getchar();
+    case RuntimeFunction::ORD:
+      return runtime.ord(argument(1));
+    case RuntimeFunction::CHR:
+      return runtime.chr(argument(1));
+    case RuntimeFunction::SIZE:
+      return runtime.size(argument(1));
+    case RuntimeFunction::SUBSTRING:
+      return runtime.substring(argument(1), argument(2), argument(3));
+    case RuntimeFunction::CONCAT:
+      return runtime.concat(argument(1), argument(2));
+    case RuntimeFunction::NOT:
+      return runtime.not_(argument(1));
+    case RuntimeFunction::EXIT:
+      runtime.exit(argument(1));
+      return 0;
+  }
+  throw std::logic_error{"Unknown runtime function"};
+}
+
+} // namespace tiger
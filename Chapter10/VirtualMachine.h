@@ -0,0 +1,37 @@
+#pragma once
+#include "Bytecode.h"
+#include "Runtime.h"
+#include <memory>
+
+namespace tiger {
+
+// runs bytecode with direct threading: every opcode is replaced by the
+// address of the code handling it, which jumps straight to the handler of
+// the next instruction. compilers without computed goto dispatch with a
+// switch instead. memory is the process's, as for native programs, with the
+// frames on a stack of fixed size
+class VirtualMachine {
+public:
+  using Word = Runtime::Word;
+
+  static constexpr size_t DEFAULT_STACK_WORDS = 1 << 22;
+
+  explicit VirtualMachine(bytecode::Program program,
+                          size_t stackWords = DEFAULT_STACK_WORDS);
+
+  // calls main with runtime as the library. returns the status passed to
+  // exit or else main's value
+  Word run(Runtime &runtime);
+
+private:
+  using Slot = std::int64_t;
+
+  Word callRuntime(Runtime &runtime, bytecode::RuntimeFunction function,
+                   const Slot *arguments, Slot count, const Word *registers);
+
+  bytecode::Program m_program;
+  std::unique_ptr<Word[]> m_stack;
+  size_t m_stackWords;
+};
+
+} // namespace tiger
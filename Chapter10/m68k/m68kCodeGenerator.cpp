@@ -33,6 +33,10 @@ CodeGenerator::CodeGenerator(frame::CallingConvention &callingConvention) :
                 {{InstructionType::MOVE, "MOVE `s0, `d0", {0, 2}}, {InstructionType::OPERATION, "SUB `s0, `d0", {1, 2}, {2}}}},
             Pattern{ir::BinaryOperation{ir::BinOp::DIV, exp(), exp()}, 
                 {{InstructionType::MOVE, "MOVE `s0, `d0", {0, 2}}, {InstructionType::OPERATION, "DIVS.L `s0, `d0", {1, 2}, {2}}}},
+            Pattern{ir::BinaryOperation{ir::BinOp::LSHIFT, exp(), imm()}, 
+                {{InstructionType::MOVE, "MOVE `s0, `d0", {0, 2}}, {InstructionType::OPERATION, "LSL.L #`i0, `d0", {1, 2}, {2}}}},
+            Pattern{ir::BinaryOperation{ir::BinOp::LSHIFT, exp(), exp()}, 
+                {{InstructionType::MOVE, "MOVE `s0, `d0", {0, 2}}, {InstructionType::OPERATION, "LSL.L `s0, `d0", {1, 2}, {2}}}},
             Pattern{ir::ConditionalJump{ir::RelOp::EQ, exp(), exp(), label(), label()},
                 {{InstructionType::OPERATION, "SUB `s0, `d0", {0, 1}, {1}}, {InstructionType::JUMP, "BEQ `l0", {2, 3}}}},
             Pattern{ir::ConditionalJump{ir::RelOp::NE, exp(), exp(), label(), label()},
@@ -47,9 +51,11 @@ CodeGenerator::CodeGenerator(frame::CallingConvention &callingConvention) :
                 {{InstructionType::OPERATION, "SUB `s0, `d0", {0, 1}, {1}}, {InstructionType::JUMP, "BGE `l0", {2, 3}}}},
             Pattern{ir::Move{reg(), reg()}, {{InstructionType::MOVE, "MOVE `s0, `d0", {0, 1}}}},
             Pattern{ir::Move{exp(), reg()}, {{InstructionType::MOVE, "MOVE `s0, `d0", {0, 1}}}},
+            Pattern{ir::Move{label(), ir::MemoryAccess{exp()}},
+                {{InstructionType::OPERATION, "MOVE #`l0, `d0", {0, 2}}, {InstructionType::OPERATION, "MOVE `s0, (`s1)", {2, 1}}}},
+            Pattern{ir::Move{exp(), ir::MemoryAccess{exp()}}, {{InstructionType::OPERATION, "MOVE `s0, (`s1)", {0, 1}}}},
             Pattern{ir::Move{imm(), exp()}, {{InstructionType::OPERATION, "MOVE #`i0, `d0", {0, 1}}}},
             Pattern{ir::Move{label(), exp()}, {{InstructionType::OPERATION, "MOVE #`l0, `d0", {0, 1}}}},
-            Pattern{ir::Move{exp(), ir::MemoryAccess{exp()}}, {{InstructionType::OPERATION, "MOVE `s0, (`s1)", {0, 1}}}},
             Pattern{ir::Move{exp(), exp()}, {{InstructionType::MOVE, "MOVE `s0, `d0", {0, 1}}}},
             Pattern{ir::MemoryAccess{exp()}, {{InstructionType::OPERATION, "MOVE (`s0), `d0", {0, 1}}}},
             Pattern{ir::Expression{imm()}, {{InstructionType::OPERATION, "MOVE #`i0, `d0", {0, 1}}}},
@@ -64,28 +70,33 @@ CodeGenerator::CodeGenerator(frame::CallingConvention &callingConvention) :
 Instructions CodeGenerator::translateString(const temp::Label &label,
                                             const std::string &string,
                                             temp::Map & /* tempMap */) {
-  return {Label{"`l0:", label}, Operation{{".string " + escape(string)}}};
+  static const Syntax labelSyntax{"`l0:"};
+  return {Label{labelSyntax, label}, Operation{{".string " + escape(string)}}};
 }
 
 Instructions
   CodeGenerator::translateArgs(const std::vector<ir::Expression> &args,
                                const temp::Map & /* tempMap */) const {
+  static const Syntax pushImmediate{"MOVE #`i0, +(`s0)"};
+  static const Syntax pushRegister{"MOVE `s0, +(`s1)"};
+  static const Syntax pushLabel{"MOVE #`l0, +(`s0)"};
+
   return args | ranges::view::transform([this](const ir::Expression &arg) {
            return helpers::match(arg)(
              [this](int i) {
-               return Operation{"MOVE #`i0, +(`s0)",
+               return Operation{pushImmediate,
                                 {},
                                 {m_callingConvention.stackPointer()},
                                 {},
                                 {i}};
              },
              [this](const temp::Register &reg) {
-               return Operation{"MOVE `s0, +(`s1)",
+               return Operation{pushRegister,
                                 {},
                                 {reg, m_callingConvention.stackPointer()}};
              },
              [this](const temp::Label &label) {
-               return Operation{"MOVE #`l0, +(`s0)",
+               return Operation{pushLabel,
                                 {},
                                 {m_callingConvention.stackPointer()},
                                 {label}};
@@ -0,0 +1,42 @@
+#include "Arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace tiger {
+
+namespace {
+constexpr size_t ALIGNMENT = sizeof(std::int64_t);
+} // namespace
+
+void *Arena::allocate(size_t bytes) {
+  bytes = std::max((bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1), ALIGNMENT);
+  if (bytes > static_cast<size_t>(m_end - m_next)) {
+    // large blocks get a chunk of their own, keeping the current one
+    if (bytes > m_chunkSize / 4) {
+      return newChunk(bytes);
+    }
+    m_next      = newChunk(m_chunkSize);
+    m_end       = m_next + m_chunkSize;
+    m_chunkSize = std::min(m_chunkSize * 2, MAX_CHUNK);
+  }
+
+  auto const block = m_next;
+  m_next += bytes;
+  return block;
+}
+
+size_t Arena::reserved() const { return m_reserved; }
+
+char *Arena::newChunk(size_t bytes) {
+  // calloc gets fresh pages from the system already zeroed
+  auto const chunk = static_cast<char *>(std::calloc(bytes, 1));
+  if (!chunk) {
+    throw std::bad_alloc{};
+  }
+  m_chunks.emplace_back(chunk);
+  m_reserved += bytes;
+  return chunk;
+}
+
+} // namespace tiger
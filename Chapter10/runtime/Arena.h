@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace tiger {
+
+// hands out zeroed memory by bumping a pointer through large chunks, which
+// are all freed together with the arena. blocks are aligned to words
+class Arena {
+public:
+  static constexpr size_t MIN_CHUNK = 1 << 16;
+  static constexpr size_t MAX_CHUNK = 1 << 24;
+
+  void *allocate(size_t bytes);
+
+  // the bytes of all the chunks
+  size_t reserved() const;
+
+private:
+  struct Free {
+    void operator()(char *chunk) const { std::free(chunk); }
+  };
+
+  char *newChunk(size_t bytes);
+
+  std::vector<std::unique_ptr<char, Free>> m_chunks;
+  char *m_next       = nullptr;
+  char *m_end        = nullptr;
+  size_t m_chunkSize = MIN_CHUNK;
+  size_t m_reserved  = 0;
+};
+
+} // namespace tiger
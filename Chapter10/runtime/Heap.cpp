@@ -0,0 +1,193 @@
+#include "Heap.h"
+#include <algorithm>
+#include <cstring>
+
+namespace tiger {
+
+namespace {
+using Word = Heap::Word;
+
+constexpr Word KIND_BITS = 2;
+
+Word header(size_t size, Word kind) {
+  return static_cast<Word>(size) << KIND_BITS | kind;
+}
+
+size_t sizeOf(const Word *object) {
+  return static_cast<size_t>(object[0] >> KIND_BITS);
+}
+
+Word kindOf(const Word *object) {
+  return object[0] & ((Word{1} << KIND_BITS) - 1);
+}
+} // namespace
+
+Word *Heap::allocateRecord(const char *descriptor) {
+  return allocate(std::strlen(descriptor), RECORD,
+                  reinterpret_cast<Word>(descriptor), 0);
+}
+
+Word *Heap::allocateArray(size_t size, Word init, bool pointers) {
+  auto const array =
+    allocate(size, pointers ? POINTER_ARRAY : ARRAY, 0, pointers ? init : 0);
+  // the block is zeroed already
+  if (init != 0) {
+    std::fill_n(array, size, init);
+  }
+  return array;
+}
+
+void Heap::setRoots(Roots roots) { m_roots = std::move(roots); }
+
+void Heap::collect() { collect(0); }
+
+size_t Heap::collections() const { return m_collections; }
+
+size_t Heap::usedWords() const { return m_used; }
+
+Word *Heap::allocate(size_t size, Kind kind, Word extra, Word root) {
+  auto const words = HEADER_WORDS + size;
+  if (m_roots && m_used + words > m_threshold) {
+    collect(root);
+  }
+
+  auto const object = bump(words);
+  object[0]         = header(size, kind);
+  object[1]         = extra;
+  return object + HEADER_WORDS;
+}
+
+void Heap::collect(Word root) {
+  ++m_collections;
+  Blocks fromSpace;
+  fromSpace.swap(m_blocks);
+  m_current = nullptr;
+  m_copies.clear();
+  m_used = 0;
+
+  auto const pin = [&fromSpace](Word word) {
+    if (auto const block = find(fromSpace, word)) {
+      block->m_pinned = true;
+    }
+  };
+  pin(root);
+  if (m_roots) {
+    auto const roots = m_roots();
+    std::for_each(roots.first, roots.second, pin);
+  }
+
+  // pinned blocks stay where they are and their objects are scanned like the
+  // copied ones
+  for (auto it = fromSpace.begin(); it != fromSpace.end();) {
+    auto const next = std::next(it);
+    if (it->second.m_pinned) {
+      auto &block     = m_blocks.insert(fromSpace.extract(it)).position->second;
+      block.m_pinned  = false;
+      block.m_scanned = 0;
+      m_used += block.m_top;
+      m_copies.push_back(&block);
+    }
+    it = next;
+  }
+
+  // copying appends to the blocks, possibly to one scanned already, so scan
+  // until nothing is left
+  for (auto scanned = false; !scanned;) {
+    scanned = true;
+    for (size_t i = 0; i < m_copies.size(); ++i) {
+      auto &block = *m_copies[i];
+      while (block.m_scanned < block.m_top) {
+        auto const object = block.m_words.get() + block.m_scanned;
+        block.m_scanned += HEADER_WORDS + sizeOf(object);
+        scan(object, fromSpace);
+        scanned = false;
+      }
+    }
+  }
+
+  m_copies.clear();
+  m_threshold = std::max(MIN_THRESHOLD, 2 * m_used);
+}
+
+Word *Heap::bump(size_t words) {
+  m_used += words;
+  // large objects get a block of their own
+  if (words > BLOCK_WORDS / 4) {
+    auto &block  = newBlock(words);
+    block.m_top  = words;
+    return block.m_words.get();
+  }
+
+  if (!m_current || m_current->m_top + words > m_current->m_size) {
+    m_current = &newBlock(BLOCK_WORDS);
+  }
+  auto const object = m_current->m_words.get() + m_current->m_top;
+  m_current->m_top += words;
+  return object;
+}
+
+Heap::Block &Heap::newBlock(size_t size) {
+  std::unique_ptr<Word[]> words{new Word[size]()};
+  auto const start = words.get();
+  auto &block =
+    m_blocks.emplace(start, Block{std::move(words), size, 0, 0, false})
+      .first->second;
+  m_copies.push_back(&block);
+  return block;
+}
+
+Heap::Block *Heap::find(Blocks &blocks, Word address) {
+  auto const pointer = reinterpret_cast<const Word *>(address);
+  auto block         = blocks.upper_bound(pointer);
+  if (block == blocks.begin()) {
+    return nullptr;
+  }
+  --block;
+  // a pointer just past the last object still belongs to the block
+  if (std::less<const Word *>{}(block->first + block->second.m_top,
+                                pointer)) {
+    return nullptr;
+  }
+  return &block->second;
+}
+
+void Heap::scan(Word *object, Blocks &fromSpace) {
+  auto const fields = object + HEADER_WORDS;
+  auto const size   = sizeOf(object);
+  switch (kindOf(object)) {
+    case RECORD: {
+      auto const descriptor = reinterpret_cast<const char *>(object[1]);
+      for (size_t i = 0; i < size; ++i) {
+        if (descriptor[i] == 'p') {
+          forward(fields[i], fromSpace);
+        }
+      }
+      break;
+    }
+    case POINTER_ARRAY:
+      for (size_t i = 0; i < size; ++i) {
+        forward(fields[i], fromSpace);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void Heap::forward(Word &field, Blocks &fromSpace) {
+  if (field == 0 || !find(fromSpace, field)) {
+    return;
+  }
+
+  auto const object = reinterpret_cast<Word *>(field) - HEADER_WORDS;
+  if (kindOf(object) != FORWARDED) {
+    auto const words = HEADER_WORDS + sizeOf(object);
+    auto const copy  = bump(words);
+    std::copy_n(object, words, copy);
+    object[0] = header(0, FORWARDED);
+    object[1] = reinterpret_cast<Word>(copy + HEADER_WORDS);
+  }
+  field = object[1];
+}
+
+} // namespace tiger
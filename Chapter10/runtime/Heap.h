@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace tiger {
+
+// a garbage collected heap of records and arrays, which are allocated by
+// bumping a pointer through blocks. a collection copies the reachable objects
+// to new blocks, Cheney style, following the pointers their descriptors give.
+// the program's frames aren't described, so they are scanned conservatively:
+// a word pointing into a block pins it, and the block survives in place with
+// all its objects, as in Bartlett's mostly copying collector
+class Heap {
+public:
+  using Word = std::int64_t;
+  // the memory holding the program's frames
+  using Roots = std::function<std::pair<const Word *, const Word *>()>;
+
+  static constexpr size_t BLOCK_WORDS = 1 << 13;
+  // collections start once this many words are used
+  static constexpr size_t MIN_THRESHOLD = 1 << 18;
+
+  // a zeroed record whose fields are described by descriptor, a character
+  // per field which is 'p' for fields pointing to records or arrays
+  Word *allocateRecord(const char *descriptor);
+
+  // an array of size elements set to init, which are pointers to records or
+  // arrays if pointers is set
+  Word *allocateArray(size_t size, Word init, bool pointers);
+
+  // without roots, nothing is ever collected
+  void setRoots(Roots roots);
+
+  void collect();
+
+  size_t collections() const;
+
+  // the words in objects, which were live at the last collection or
+  // allocated since
+  size_t usedWords() const;
+
+private:
+  // the words before every object, its kind and size, then the record's
+  // descriptor or where a forwarded object was copied to
+  static constexpr size_t HEADER_WORDS = 2;
+
+  enum Kind : Word { RECORD, ARRAY, POINTER_ARRAY, FORWARDED };
+
+  struct Block {
+    std::unique_ptr<Word[]> m_words;
+    size_t m_size;
+    // the words allocated and scanned by the collection
+    size_t m_top;
+    size_t m_scanned;
+    bool m_pinned;
+  };
+
+  using Blocks = std::map<const Word *, Block>;
+
+  // an object of size words, collecting first if the heap is full. root is
+  // kept in place, as if the frames held it
+  Word *allocate(size_t size, Kind kind, Word extra, Word root);
+
+  void collect(Word root);
+
+  // room for words, without collecting
+  Word *bump(size_t words);
+
+  Block &newBlock(size_t size);
+
+  // the block of blocks holding address
+  static Block *find(Blocks &blocks, Word address);
+
+  // updates the pointer fields of object, copying their targets from
+  // fromSpace
+  void scan(Word *object, Blocks &fromSpace);
+
+  void forward(Word &field, Blocks &fromSpace);
+
+  Blocks m_blocks;
+  Block *m_current = nullptr;
+  // the blocks created by the collection, in order
+  std::vector<Block *> m_copies;
+  Roots m_roots;
+  size_t m_used        = 0;
+  size_t m_threshold   = MIN_THRESHOLD;
+  size_t m_collections = 0;
+};
+
+} // namespace tiger
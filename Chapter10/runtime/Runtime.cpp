@@ -0,0 +1,192 @@
+#include "Runtime.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace tiger {
+
+namespace {
+const char *toString(Runtime::Word string) {
+  return reinterpret_cast<const char *>(string);
+}
+
+Runtime::Word toWord(const char *string) {
+  return reinterpret_cast<Runtime::Word>(string);
+}
+
+// initArray only looks for the array among the latest blocks, the others are
+// records or arrays filled already
+constexpr size_t MAX_UNFILLED = 64;
+
+// output is written once this much is buffered
+constexpr size_t BUFFER_SIZE = 1 << 16;
+
+// the strings of a single character, which chr and getchar return
+const std::array<std::array<char, 2>, 256> &characters() {
+  static auto const characters = [] {
+    std::array<std::array<char, 2>, 256> characters{};
+    for (size_t i = 0; i < characters.size(); ++i) {
+      characters[i][0] = static_cast<char>(i);
+    }
+    return characters;
+  }();
+  return characters;
+}
+} // namespace
+
+Runtime::Runtime(std::istream &in, std::ostream &out) : m_in(in), m_out(out) {
+  m_output.reserve(BUFFER_SIZE);
+}
+
+Runtime::~Runtime() { write(); }
+
+Runtime::Word Runtime::malloc(Word size) {
+  auto const block = static_cast<Word *>(
+    m_arena.allocate(static_cast<size_t>(std::max<Word>(size, 0))));
+  if (m_unfilled.size() == MAX_UNFILLED) {
+    m_unfilled.pop_front();
+  }
+  m_unfilled.emplace_back(block, size);
+  return reinterpret_cast<Word>(block);
+}
+
+void Runtime::initArray(Word size, Word init) {
+  auto const array = std::find_if(
+    m_unfilled.rbegin(), m_unfilled.rend(), [size](const auto &block) {
+      return block.second == size * static_cast<Word>(sizeof(Word));
+    });
+  if (array == m_unfilled.rend()) {
+    return;
+  }
+
+  // the block is zeroed already
+  if (init != 0) {
+    std::fill_n(array->first, size, init);
+  }
+  // blocks allocated after the array belong to the initial value
+  m_unfilled.erase(std::prev(array.base()), m_unfilled.end());
+}
+
+Runtime::Word Runtime::allocRecord(Word descriptor) {
+  return reinterpret_cast<Word>(m_heap.allocateRecord(toString(descriptor)));
+}
+
+Runtime::Word Runtime::allocArray(Word size, Word init, Word pointers) {
+  return reinterpret_cast<Word>(m_heap.allocateArray(
+    static_cast<size_t>(std::max<Word>(size, 0)), init, pointers != 0));
+}
+
+Runtime::Word Runtime::stringCompare(Word lhs, Word rhs) const {
+  if (lhs == rhs) {
+    return 0;
+  }
+  return std::strcmp(toString(lhs), toString(rhs));
+}
+
+void Runtime::print(Word string) {
+  m_output += toString(string);
+  if (m_output.size() >= BUFFER_SIZE) {
+    write();
+  }
+}
+
+void Runtime::flush() {
+  write();
+  m_out.flush();
+}
+
+Runtime::Word Runtime::getchar() {
+  // whatever the program printed shows before it waits for input
+  write();
+  auto const c = m_in.get();
+  if (c == std::istream::traits_type::eof()) {
+    return toWord("");
+  }
+  return toWord(characters()[static_cast<unsigned char>(c)].data());
+}
+
+Runtime::Word Runtime::ord(Word string) const {
+  auto const c = static_cast<unsigned char>(*toString(string));
+  return c == '\0' ? -1 : c;
+}
+
+Runtime::Word Runtime::chr(Word i) {
+  if (i < 0 || i >= static_cast<Word>(characters().size())) {
+    m_output += "chr(" + std::to_string(i) + ") out of range\n";
+    exit(1);
+    return toWord("");
+  }
+  return toWord(characters()[static_cast<size_t>(i)].data());
+}
+
+Runtime::Word Runtime::size(Word string) const {
+  return static_cast<Word>(std::strlen(toString(string)));
+}
+
+Runtime::Word Runtime::substring(Word string, Word first, Word n) {
+  auto const length = size(string);
+  if (first < 0 || n < 0 || first + n > length) {
+    m_output += "substring([" + std::to_string(length) + "],"
+                + std::to_string(first) + "," + std::to_string(n)
+                + ") out of range\n";
+    exit(1);
+    return toWord("");
+  }
+
+  auto const start = toString(string) + first;
+  if (n == 0) {
+    return toWord("");
+  }
+  if (n == 1) {
+    return chr(static_cast<unsigned char>(*start));
+  }
+  // the null terminator of string ends its suffixes
+  if (first + n == length) {
+    return toWord(start);
+  }
+  auto const result = newString(static_cast<size_t>(n));
+  std::memcpy(result, start, static_cast<size_t>(n));
+  return toWord(result);
+}
+
+Runtime::Word Runtime::concat(Word lhs, Word rhs) {
+  if (*toString(lhs) == '\0') {
+    return rhs;
+  }
+  if (*toString(rhs) == '\0') {
+    return lhs;
+  }
+  auto const lhsLength = std::strlen(toString(lhs));
+  auto const rhsLength = std::strlen(toString(rhs));
+  auto const result    = newString(lhsLength + rhsLength);
+  std::memcpy(result, toString(lhs), lhsLength);
+  std::memcpy(result + lhsLength, toString(rhs), rhsLength);
+  return toWord(result);
+}
+
+Runtime::Word Runtime::not_(Word i) const { return i == 0 ? 1 : 0; }
+
+void Runtime::exit(Word status) {
+  flush();
+  m_exitStatus = status;
+}
+
+const boost::optional<Runtime::Word> &Runtime::exitStatus() const {
+  return m_exitStatus;
+}
+
+Heap &Runtime::heap() { return m_heap; }
+
+char *Runtime::newString(size_t length) {
+  // the arena's memory is zeroed, so the string is terminated
+  return static_cast<char *>(m_arena.allocate(length + 1));
+}
+
+void Runtime::write() {
+  if (!m_output.empty()) {
+    m_out.write(m_output.data(), static_cast<std::streamsize>(m_output.size()));
+    m_output.clear();
+  }
+}
+
+} // namespace tiger
@@ -0,0 +1,84 @@
+#pragma once
+#include "Arena.h"
+#include "Heap.h"
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace tiger {
+
+// the functions compiled programs call, working on the memory of the process
+// running them. values are 64 bit words, strings are pointers to null
+// terminated characters and every function of the standard library receives a
+// static link first, which it doesn't use. records, arrays and new strings are
+// allocated from an arena and output is buffered until it's flushed, the
+// program reads input or exits, or the runtime is destroyed
+class Runtime {
+public:
+  using Word = std::int64_t;
+
+  Runtime(std::istream &in, std::ostream &out);
+
+  ~Runtime();
+
+  // a zeroed block of size bytes, which lives as long as the runtime
+  Word malloc(Word size);
+
+  // arrays are allocated by malloc before calling initArray, which isn't
+  // given the array. it fills the latest block of size words which it hasn't
+  // filled yet
+  void initArray(Word size, Word init);
+
+  // a record from the collected heap, described as by Heap::allocateRecord
+  Word allocRecord(Word descriptor);
+
+  // an array from the collected heap, of size elements set to init, which
+  // are pointers if pointers isn't zero
+  Word allocArray(Word size, Word init, Word pointers);
+
+  // negative, zero or positive as lhs is less, equal or greater than rhs
+  Word stringCompare(Word lhs, Word rhs) const;
+
+  void print(Word string);
+  void flush();
+  Word getchar();
+  Word ord(Word string) const;
+  Word chr(Word i);
+  Word size(Word string) const;
+  // a suffix of string or a single character isn't copied
+  Word substring(Word string, Word first, Word n);
+  Word concat(Word lhs, Word rhs);
+  Word not_(Word i) const;
+
+  // ends the program, whose callers must stop running it
+  void exit(Word status);
+
+  // set once the program ended by calling exit or by a runtime error
+  const boost::optional<Word> &exitStatus() const;
+
+  // collects what allocRecord and allocArray allocated. the program's frames
+  // are scanned for roots, once they are set
+  Heap &heap();
+
+private:
+  // room for length characters and the null terminator, which lives as long
+  // as the runtime
+  char *newString(size_t length);
+
+  // writes the buffered output to the output stream
+  void write();
+
+  std::istream &m_in;
+  std::ostream &m_out;
+  Arena m_arena;
+  Heap m_heap;
+  // blocks which may be arrays, with their size in bytes
+  std::deque<std::pair<Word *, Word>> m_unfilled;
+  std::string m_output;
+  boost::optional<Word> m_exitStatus;
+};
+
+} // namespace tiger
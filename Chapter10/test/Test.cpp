@@ -2,6 +2,8 @@
 #include "CallingConvention.h"
 #include "FlowGraph.h"
 #include "warning_suppress.h"
+#include <algorithm>
+#include <sstream>
 MSC_DIAG_OFF(4459)
 #include "MachineRegistrar.h"
 MSC_DIAG_ON()
@@ -63,12 +65,61 @@ const temp::Registers &TestFixture::callDefinedRegisters() const {
 }
 
 tiger::CompileResults
-  TestFixture::checkedCompile(const std::string &string) const {
-  auto res = tiger::compile(arch, string);
+  TestFixture::checkedCompile(const std::string &string,
+                              const tiger::CompileOptions &options) const {
+  auto diagnosticOptions          = options;
+  diagnosticOptions.m_diagnostics = true;
+
+  auto res = tiger::compile(arch, string, diagnosticOptions);
   REQUIRE(res);
   return *res;
 }
 
+bool TestFixture::contains(const tiger::CompileResults &results,
+                           const std::string &str) const {
+  return results.m_assembly.find(str) != std::string::npos;
+}
+
+bool TestFixture::loopContains(const tiger::CompileResults &results,
+                               const std::string &str) const {
+  std::istringstream assembly{results.m_assembly};
+  std::string line;
+  for (const auto &depths : results.m_loopDepths) {
+    for (auto depth : depths) {
+      std::getline(assembly, line);
+      if (depth > 0 && line.find(str) != std::string::npos) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+std::ptrdiff_t
+  TestFixture::occurrences(const tiger::CompileResults &results,
+                           const std::string &str) const {
+  std::ptrdiff_t count = 0;
+  for (auto pos = results.m_assembly.find(str); pos != std::string::npos;
+       pos      = results.m_assembly.find(str, pos + str.size())) {
+    ++count;
+  }
+  return count;
+}
+
+std::ptrdiff_t TestFixture::moves(const tiger::CompileResults &results) const {
+  return occurrences(results, "isMove: true");
+}
+
+std::ptrdiff_t
+  TestFixture::memoryAccesses(const tiger::CompileResults &results) const {
+  return std::count(results.m_assembly.begin(), results.m_assembly.end(),
+                    arch == "m68k" ? '(' : '[');
+}
+
+std::string TestFixture::call() const {
+  return arch == "m68k" ? "JSR" : "call";
+}
+
 std::string TestFixture::binOp(ir::BinOp op) const {
   if (arch == "m68k") {
     switch (op) {
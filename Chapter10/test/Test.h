@@ -60,6 +60,15 @@ template <> struct is_reg<OptReg> : std::true_type {};
 
 extern std::string arch;
 
+// options enabling the given optimizations, e.g.
+// optionsWith(&tiger::CompileOptions::m_simplify)
+template <typename... Flags>
+tiger::CompileOptions optionsWith(Flags... flags) {
+  tiger::CompileOptions options;
+  (void)std::initializer_list<int>{(options.*flags = true, 0)...};
+  return options;
+}
+
 namespace tiger {
 class Machine;
 namespace frame {
@@ -131,7 +140,30 @@ protected:
 
   parser checkReg(OptReg &reg);
 
-  tiger::CompileResults checkedCompile(const std::string &string) const;
+  tiger::CompileResults
+    checkedCompile(const std::string &string,
+                   const tiger::CompileOptions &options = {}) const;
+
+  // whether the generated assembly contains str
+  bool contains(const tiger::CompileResults &results,
+                const std::string &str) const;
+
+  // whether an instruction inside a loop contains str
+  bool loopContains(const tiger::CompileResults &results,
+                    const std::string &str) const;
+
+  // how many times str appears in the generated assembly
+  std::ptrdiff_t occurrences(const tiger::CompileResults &results,
+                             const std::string &str) const;
+
+  // the moves the register allocator sees in the generated assembly
+  std::ptrdiff_t moves(const tiger::CompileResults &results) const;
+
+  // loads and stores in the generated assembly
+  std::ptrdiff_t memoryAccesses(const tiger::CompileResults &results) const;
+
+  // the mnemonic of a function call
+  std::string call() const;
 
   template <typename Rng, typename ElementChecker>
   parser checkRange(Rng &&rng, ElementChecker &&elementChecker) const;
@@ -213,6 +245,11 @@ protected:
                            const gsl::span<OptReg, 4> &temps,
                            const RegList &liveRegisters = {});
 
+  // stores value in a member, through its address
+  parser checkMemberInit(OptReg &base, int memberIndex, int value,
+                         const gsl::span<OptReg, 5> &temps,
+                         const RegList &liveRegisters = {});
+
   parser checkString(OptLabel &stringLabel);
 
   template <typename CheckTarget, typename... Args>
@@ -699,10 +736,12 @@ inline TestFixture::parser
 }
 
 inline TestFixture::parser
-  TestFixture::checkStaticLink(OptReg &staticLink, gsl::span<OptReg, 2> temps,
-                               const RegList &liveRegisters /*= {}*/) {
-  return checkStaticLinkImpl(staticLink, temps[0], temps[1], framePointer(),
-                             liveRegisters);
+  TestFixture::checkStaticLink(OptReg &staticLink,
+                               gsl::span<OptReg, 2> /*temps*/,
+                               const RegList & /*liveRegisters = {}*/) {
+  // functions declared in the calling frame get its frame pointer as is
+  staticLink = framePointer();
+  return x3::eps;
 }
 
 template <size_t N>
@@ -816,6 +855,20 @@ inline TestFixture::parser
   return r;
 }
 
+inline TestFixture::parser
+  TestFixture::checkMemberInit(OptReg &base, int memberIndex, int value,
+                               const gsl::span<OptReg, 5> &temps,
+                               const RegList &liveRegisters /*= {}*/) {
+  auto const liveRegistersAnd = this->liveRegistersAnd(liveRegisters);
+  auto const r = x3::rule<struct member_init>{"member init"} =
+    checkMove(temps[0], value, liveRegisters)
+    > checkMemberAddress(base, memberIndex, temps[1], temps.subspan<2>(),
+                         liveRegistersAnd(temps[0]))
+    > checkMove(checkMemoryAccess(checkReg(temps[1])), checkReg(temps[0]),
+                {temps[1], temps[0]}, {}, false, liveRegisters);
+  return r;
+}
+
 inline TestFixture::parser TestFixture::checkStringInit(OptLabel &stringLabel,
                                            const std::string &str,
                                            OptIndex &labelIndex) {
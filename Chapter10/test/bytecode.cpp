@@ -0,0 +1,248 @@
+#include "Program.h"
+#include "Runtime.h"
+#include "testsHelper.h"
+#include <boost/optional.hpp>
+#include <boost/optional/optional_io.hpp>
+#include <catch/catch.hpp>
+#include <chrono>
+#include <sstream>
+
+extern std::string arch;
+
+namespace {
+using Word = tiger::RunResult::value_type;
+
+// the value of the program, or nothing if it didn't run, and what it printed
+std::pair<tiger::RunResult, std::string>
+  runBytecode(const std::string &program, const std::string &input = {},
+              const tiger::CompileOptions &options = {}) {
+  std::istringstream in{input};
+  std::ostringstream out;
+  auto const result = tiger::runBytecode(arch, program, in, out, options);
+  return {result, out.str()};
+}
+} // namespace
+
+TEST_CASE("bytecode") {
+  // bytecode words are 64 bit
+  if (arch != "x64") {
+    CHECK_FALSE(runBytecode("1 + 2").first);
+    return;
+  }
+
+  SECTION("value") { CHECK(runBytecode("1 + 2 * 3").first == Word{7}); }
+
+  SECTION("recursion") {
+    auto const program = R"(
+let
+  function fact(n : int) : int = if n = 0 then 1 else n * fact(n - 1)
+in
+  fact(10)
+end
+)";
+    CHECK(runBytecode(program).first == Word{3628800});
+  }
+
+  SECTION("static links") {
+    auto const program = R"(
+let
+  var total := 0
+  function add(n : int) =
+    let
+      function addTo(m : int) = total := total + m
+    in
+      addTo(n)
+    end
+in
+  for i := 1 to 10 do add(i);
+  total
+end
+)";
+    CHECK(runBytecode(program).first == Word{55});
+  }
+
+  SECTION("stack arguments") {
+    auto const program = R"(
+let
+  function f(a : int, b : int, c : int, d : int, e : int, g : int) : int =
+    a - b + c - d + e * g
+in
+  f(1, 2, 3, 4, 5, 6)
+end
+)";
+    CHECK(runBytecode(program).first == Word{28});
+  }
+
+  SECTION("records and arrays") {
+    auto const program = R"(
+let
+  type arrtype = array of int
+  type list = {head : int, tail : list}
+  var arr := arrtype [10] of 3
+  var l := list{head = 1, tail = list{head = 2, tail = nil}}
+in
+  arr[2] := 5;
+  arr[2] + arr[9] + l.head + l.tail.head * 10
+end
+)";
+    CHECK(runBytecode(program).first == Word{29});
+  }
+
+  SECTION("strings") {
+    auto const program = R"(
+let
+  var s := concat("abc", "def")
+in
+  print(substring(s, 2, 3));
+  print(chr(ord("A") + size(s)));
+  print(getchar());
+  if s = "abcdef" & s < "abd" then 1 else 0
+end
+)";
+    auto const result = runBytecode(program, "x");
+    CHECK(result.first == Word{1});
+    CHECK(result.second == "cdeGx");
+  }
+
+  SECTION("exit") {
+    auto const result =
+      runBytecode(R"(print("before"); exit(3); print("after"); 0)");
+    CHECK(result.first == Word{3});
+    CHECK(result.second == "before");
+  }
+
+  SECTION("nil access") {
+    auto const program = R"(
+let
+  type list = {head : int, tail : list}
+  var l : list := nil
+in
+  l.head
+end
+)";
+    CHECK_FALSE(runBytecode(program).first);
+  }
+
+  SECTION("tail calls") {
+    tiger::CompileOptions options;
+    options.m_tailCalls = true;
+    auto const program  = R"(
+let
+  function count(n : int, acc : int) : int =
+    if n = 0 then acc else count(n - 1, acc + 1)
+in
+  count(1000000, 0)
+end
+)";
+    // deeper than the stack holds without reusing the frame
+    CHECK(runBytecode(program, {}, options).first == Word{1000000});
+  }
+
+  SECTION("garbage collection") {
+    tiger::CompileOptions options;
+    options.m_garbageCollection = true;
+    auto const program          = R"(
+let
+  type list = {head : int, tail : list}
+  type lists = array of list
+  function build(n : int) : list =
+    let
+      var l : list := nil
+    in
+      for i := 1 to n do l := list{head = i, tail = l};
+      l
+    end
+  function sum(l : list) : int =
+    let
+      var total := 0
+    in
+      while l <> nil do (total := total + l.head; l := l.tail);
+      total
+    end
+  var kept := lists [4] of nil
+  var total := 0
+in
+  for i := 0 to 3 do kept[i] := build(1000);
+  for i := 1 to 200 do total := total + sum(build(5000));
+  for i := 0 to 3 do total := total + sum(kept[i]);
+  total
+end
+)";
+    std::istringstream in;
+    std::ostringstream out;
+    tiger::Runtime runtime{in, out};
+    CHECK(tiger::runBytecode(arch, program, runtime, options)
+          == Word{200} * 12502500 + 4 * 500500);
+    // far more is allocated than the heap allows before collecting
+    auto const &heap = runtime.heap();
+    CHECK(heap.collections() > 0);
+    CHECK(heap.usedWords() < 2 * tiger::Heap::MIN_THRESHOLD);
+  }
+
+  SECTION("failure") { CHECK_FALSE(runBytecode("1 + nil").first); }
+}
+
+TEST_CASE("bytecode matches the interpreter") {
+  if (arch != "x64") {
+    return;
+  }
+
+  tiger::forEachTigerTest(
+    [&](const boost::filesystem::path &filepath, bool parseError,
+        bool compilationError) {
+      // the mutually recursive functions of these never return
+      auto const filename = filepath.filename().string();
+      if (parseError || compilationError || filename == "test6.tig"
+          || filename == "test7.tig") {
+        return;
+      }
+
+      SECTION(filename) {
+        std::istringstream in, bytecodeIn;
+        std::ostringstream out, bytecodeOut;
+        auto const expected =
+          tiger::interpretFile(arch, filepath.string(), in, out);
+        REQUIRE(expected);
+        auto const actual = tiger::runBytecodeFile(arch, filepath.string(),
+                                                   bytecodeIn, bytecodeOut);
+        CHECK(actual == expected->m_value);
+        CHECK(bytecodeOut.str() == out.str());
+      }
+    });
+}
+
+// run with [.benchmark] to compare the virtual machine with native code
+TEST_CASE("bytecode benchmark", "[.benchmark]") {
+  auto const program = R"(
+let
+  function fib(n : int) : int = if n < 2 then n else fib(n - 1) + fib(n - 2)
+  var sum := 0
+in
+  for i := 1 to 5000000 do sum := sum + i * 3 / 2;
+  sum + fib(27)
+end
+)";
+  auto const time = [&](auto &&run) {
+    std::istringstream in;
+    std::ostringstream out;
+    auto const start  = std::chrono::steady_clock::now();
+    auto const result = run(in, out);
+    auto const end    = std::chrono::steady_clock::now();
+    WARN(std::chrono::duration<double>(end - start).count() << "s");
+    return result;
+  };
+
+  WARN("bytecode");
+  auto const bytecode = time([&](std::istream &in, std::ostream &out) {
+    return tiger::runBytecode(arch, program, in, out);
+  });
+  REQUIRE(bytecode);
+
+  WARN("native");
+  auto const native = time([&](std::istream &in, std::ostream &out) {
+    return tiger::run(arch, program, in, out);
+  });
+  if (native) {
+    CHECK(native == bytecode);
+  }
+}
@@ -0,0 +1,37 @@
+#include "Test.h"
+
+TEST_CASE_METHOD(TestFixture, "coalesce") {
+  auto const options = optionsWith(&tiger::CompileOptions::m_coalesce);
+
+  SECTION("arithmetic") {
+    auto const program = R"(
+let
+  function f(a : int, b : int, c : int) : int = a * b + c
+in
+  f(1, 2, 3)
+end
+)";
+    auto const optimized = checkedCompile(program, options);
+    // x64 computes the result in the argument registers
+    CHECK(moves(optimized) == (arch == "m68k" ? 13 : 2));
+    if (arch == "x64") {
+      CHECK(contains(optimized, "imul RDX, R8"));
+      CHECK(contains(optimized, "add RDX, R9"));
+    }
+  }
+
+  SECTION("interfering") {
+    // a is still needed after b is computed from it, so the copy stays, as
+    // do the copies of the frame and stack pointers of m68k
+    auto const program = R"(
+let
+  var a := 1
+  var b := a
+in
+  b := b + 1;
+  a + b
+end
+)";
+    CHECK(moves(checkedCompile(program, options)) == (arch == "m68k" ? 3 : 1));
+  }
+}
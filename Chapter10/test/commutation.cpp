@@ -0,0 +1,52 @@
+#include "Test.h"
+
+TEST_CASE_METHOD(TestFixture, "commutation") {
+  auto const options = optionsWith(&tiger::CompileOptions::m_commutation);
+
+  SECTION("call arguments") {
+    // the first arguments don't have to be saved before calling g, saving
+    // three copies
+    auto const program = R"(
+let
+  function g() : int = 3
+  function f(a : int, b : int, c : int) : int = a + b + c
+  var x := 1
+  var y := 2
+in
+  f(x + 1, y + 2, g())
+end
+)";
+    auto const optimized = checkedCompile(program, options);
+    CHECK(moves(optimized) == (arch == "m68k" ? 21 : 14));
+  }
+
+  SECTION("expression sequence") {
+    // assigning b doesn't change a, so a isn't copied first
+    auto const program = R"(
+let
+  var a := 1
+  var b := 2
+in
+  a + (b := 3; b)
+end
+)";
+    auto const optimized = checkedCompile(program, options);
+    CHECK(moves(optimized) == (arch == "m68k" ? 4 : 2));
+  }
+
+  SECTION("escaping variable") {
+    // g may change a so it must be read before the call, as without
+    // commutation
+    auto const program = R"(
+let
+  var a := 1
+  function g() : int = (a := 2; 3)
+in
+  a + g()
+end
+)";
+    auto const optimized = checkedCompile(program, options);
+    CHECK(moves(optimized) == (arch == "m68k" ? 9 : 6));
+    CHECK(memoryAccesses(optimized) == (arch == "m68k" ? 9 : 6));
+  }
+}
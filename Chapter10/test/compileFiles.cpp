@@ -17,4 +17,34 @@ TEST_CASE("compile test files") {
         }
       }
     });
+}
+
+TEST_CASE("compile test files optimized") {
+  namespace fs = boost::filesystem;
+  tiger::CompileOptions options;
+  options.m_preciseEscapes      = true;
+  options.m_lambdaLifting       = true;
+  options.m_display             = true;
+  options.m_inline              = true;
+  options.m_tailCalls           = true;
+  options.m_simplify            = true;
+  options.m_constantPropagation = true;
+  options.m_loopInvariantMotion = true;
+  options.m_strengthReduction   = true;
+  options.m_valueNumbering      = true;
+  options.m_commutation         = true;
+  options.m_orderByNeed         = true;
+  options.m_deadCode            = true;
+  options.m_coalesce            = true;
+  tiger::forEachTigerTest(
+    [&options](const fs::path &filepath, bool parseError,
+               bool compilationError) {
+      SECTION(filepath.filename().string()) {
+        if (parseError || compilationError) {
+          REQUIRE_FALSE(tiger::compileFile(arch, filepath.string(), options));
+        } else {
+          REQUIRE(tiger::compileFile(arch, filepath.string(), options));
+        }
+      }
+    });
 }
\ No newline at end of file
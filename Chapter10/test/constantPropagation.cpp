@@ -0,0 +1,86 @@
+#include "Test.h"
+#include <algorithm>
+
+namespace {
+constexpr ir::RelOp relOps[] = {ir::RelOp::EQ, ir::RelOp::NE, ir::RelOp::LT,
+                                ir::RelOp::GT, ir::RelOp::LE, ir::RelOp::GE};
+} // namespace
+
+TEST_CASE_METHOD(TestFixture, "constant propagation") {
+  auto const options =
+    optionsWith(&tiger::CompileOptions::m_constantPropagation);
+
+  auto const hasConditionalJump = [this](const tiger::CompileResults &results) {
+    return std::any_of(std::begin(relOps), std::end(relOps),
+                       [&](ir::RelOp op) {
+                         return contains(results, conditionalJump(op) + ' ');
+                       });
+  };
+
+  SECTION("through variables") {
+    auto const program = R"(
+let
+  var x := 10
+  var y := 0
+in
+  if x > 5 then y := x * 2 else y := x - 1;
+  y
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK_FALSE(hasConditionalJump(results));
+    CHECK_FALSE(contains(results, binOp(ir::BinOp::MUL)));
+    CHECK_FALSE(contains(results, binOp(ir::BinOp::MINUS)));
+    // y is gone, 20 is returned directly
+    CHECK(contains(results, arch == "m68k" ? "MOVE #20, D0" : "mov RAX, 20"));
+  }
+
+  SECTION("merging branches") {
+    // both branches give y the same value
+    auto const program = R"(
+let
+  function f(c : int) : int =
+    let
+      var y := 0
+    in
+      if c then y := 7 else y := 7;
+      y * 3
+    end
+in
+  f(1)
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK_FALSE(contains(results, binOp(ir::BinOp::MUL)));
+    CHECK(contains(results, arch == "m68k" ? "#21," : ", 21;"));
+  }
+
+  SECTION("loop never entered") {
+    auto const program = R"(
+let
+  var a := 1
+  var b := 0
+in
+  while a = 0 do b := b + 5;
+  b
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK_FALSE(hasConditionalJump(results));
+    CHECK_FALSE(contains(results, arch == "m68k" ? "#5," : ", 5;"));
+  }
+
+  SECTION("loop counter") {
+    // x changes inside the loop
+    auto const program = R"(
+let
+  var x := 0
+in
+  while x < 10 do x := x + 1;
+  x
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK(hasConditionalJump(results));
+  }
+}
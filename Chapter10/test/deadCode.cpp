@@ -0,0 +1,48 @@
+#include "Test.h"
+
+TEST_CASE_METHOD(TestFixture, "dead code") {
+  auto const options = optionsWith(&tiger::CompileOptions::m_deadCode);
+
+  SECTION("unused variable") {
+    auto const program = R"(
+let
+  var a := 2
+  var b := a * 5
+in
+  a
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK_FALSE(contains(results, binOp(ir::BinOp::MUL)));
+    CHECK_FALSE(contains(results, arch == "m68k" ? "#5," : ", 5;"));
+  }
+
+  SECTION("unused condition") {
+    // the 0/1 moves materializing the condition are removed, only the prolog
+    // of m68k moves 0
+    auto const program = R"(
+let
+  var a := 2
+  var b := a > 1
+in
+  a
+end
+)";
+    auto const optimized = checkedCompile(program, options);
+    CHECK(occurrences(optimized, arch == "m68k" ? "MOVE #0, " : ", 0;")
+          == (arch == "m68k" ? 1 : 0));
+  }
+
+  SECTION("used variable") {
+    auto const program = R"(
+let
+  var a := 2
+  var b := a * 5
+in
+  b
+end
+)";
+    CHECK(contains(checkedCompile(program, options),
+                   binOp(ir::BinOp::MUL)));
+  }
+}
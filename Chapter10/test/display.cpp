@@ -0,0 +1,60 @@
+#include "Test.h"
+#include <sstream>
+
+TEST_CASE_METHOD(TestFixture, "display") {
+  auto const options = optionsWith(&tiger::CompileOptions::m_display);
+
+  SECTION("deep nesting") {
+    // f4 reaches n through its copy of the display instead of following
+    // four static links
+    auto const program = R"(
+let
+  var n := 1
+  function f1() : int =
+    let
+      function f2() : int =
+        let
+          function f3() : int =
+            let
+              function f4() : int = n + n + n + n + n
+            in
+              f4()
+            end
+        in
+          f3()
+        end
+    in
+      f2()
+    end
+in
+  f1()
+end
+)";
+    CHECK(memoryAccesses(checkedCompile(program, options))
+          == (arch == "m68k" ? 34 : 25));
+  }
+
+  SECTION("recursion") {
+    // once outer(n - 1) returns, inner reaches the frame of outer(n) again
+    auto const program = R"(
+let
+  var total := 0
+  function outer(n : int) : int =
+    let
+      function inner(k : int) : int =
+        if k = 0 then total else (total := total + n; inner(k - 1))
+    in
+      if n = 0 then total else (outer(n - 1); inner(n))
+    end
+in
+  outer(4)
+end
+)";
+    checkedCompile(program, options);
+    std::istringstream in;
+    std::ostringstream out;
+    auto const result = tiger::interpret(arch, program, in, out, options);
+    REQUIRE(result);
+    CHECK(result->m_value == 30);
+  }
+}
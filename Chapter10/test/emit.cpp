@@ -0,0 +1,45 @@
+#include "Test.h"
+#include <sstream>
+
+TEST_CASE_METHOD(TestFixture, "emit") {
+  SECTION("same instructions") {
+    auto const program = R"(
+let
+  function f(a : int, b : int) : int = a * b
+in
+  print("hello");
+  f(1, 2)
+end
+)";
+    std::ostringstream out;
+    REQUIRE(tiger::compile(arch, program, out));
+
+    // the streamed assembly has no annotations
+    std::istringstream annotated{checkedCompile(program).m_assembly};
+    std::istringstream streamed{out.str()};
+    std::string expected, actual;
+    while (std::getline(annotated, expected)) {
+      REQUIRE(std::getline(streamed, actual));
+      CHECK(actual == expected.substr(0, expected.find("; successors:")));
+    }
+    CHECK_FALSE(std::getline(streamed, actual));
+  }
+
+  SECTION("no diagnostics") {
+    auto const program = "let var a := 1 in a + 2 end";
+    auto const results = tiger::compile(arch, program);
+    REQUIRE(results);
+    CHECK(results->m_assembly.find("; successors:") == std::string::npos);
+    CHECK(results->m_interferenceGraphs.empty());
+    CHECK(results->m_loopDepths.empty());
+
+    std::ostringstream out;
+    REQUIRE(tiger::compile(arch, program, out));
+    CHECK(results->m_assembly == out.str());
+  }
+
+  SECTION("failure") {
+    std::ostringstream out;
+    CHECK_FALSE(tiger::compile(arch, "1 + nil", out));
+  }
+}
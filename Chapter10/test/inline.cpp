@@ -0,0 +1,76 @@
+#include "Test.h"
+
+TEST_CASE_METHOD(TestFixture, "inline") {
+  auto const options = optionsWith(&tiger::CompileOptions::m_inline);
+
+  SECTION("small function in loop") {
+    auto const program = R"(
+let
+  function square(x : int) : int = x * x
+  var s := 0
+in
+  for i := 0 to 10 do s := s + square(i);
+  s
+end
+)";
+    CHECK(contains(checkedCompile(program), call()));
+    CHECK_FALSE(contains(checkedCompile(program, options), call()));
+  }
+
+  SECTION("static link") {
+    // get reads n through its static link
+    auto const program = R"(
+let
+  var n := 5
+  function get() : int = n
+  function set(v : int) = n := v
+in
+  set(get() + 1);
+  get()
+end
+)";
+    CHECK_FALSE(contains(checkedCompile(program, options), call()));
+  }
+
+  SECTION("nested function") {
+    // g is inlined into f, whose frame it uses, so f is not inlined
+    auto const program = R"(
+let
+  function f(x : int) : int =
+    let
+      function g() : int = x
+    in
+      g()
+    end
+in
+  f(1)
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK(occurrences(results, call()) == 1);
+  }
+
+  SECTION("recursion") {
+    auto const program = R"(
+let
+  function fact(n : int) : int = if n = 0 then 1 else n * fact(n - 1)
+in
+  fact(5)
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK(occurrences(results, call()) == 2);
+  }
+
+  SECTION("several call sites") {
+    auto const program = R"(
+let
+  function max(a : int, b : int) : int = if a > b then a else b
+in
+  max(max(1, 2), max(3, 4))
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK_FALSE(contains(results, call()));
+  }
+}
@@ -0,0 +1,204 @@
+#include "Program.h"
+#include "testsHelper.h"
+#include <boost/optional.hpp>
+#include <boost/optional/optional_io.hpp>
+#include <catch/catch.hpp>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+extern std::string arch;
+
+namespace {
+struct Interpreted {
+  tiger::InterpretResult m_result;
+  std::string m_output;
+};
+
+Interpreted interpret(const std::string &program,
+                      const std::string &input             = {},
+                      const tiger::CompileOptions &options = {}) {
+  std::istringstream in{input};
+  std::ostringstream out;
+  auto const result = tiger::interpret(arch, program, in, out, options);
+  return {result, out.str()};
+}
+
+size_t statements(const std::string &program) {
+  auto const interpreted = interpret(program);
+  REQUIRE(interpreted.m_result);
+  return interpreted.m_result->m_statements;
+}
+} // namespace
+
+TEST_CASE("interpreter") {
+  SECTION("value") {
+    auto const interpreted = interpret("1 + 2 * 3");
+    REQUIRE(interpreted.m_result);
+    CHECK(interpreted.m_result->m_value == 7);
+    CHECK(interpreted.m_result->m_memoryAccesses == 0);
+    CHECK(interpreted.m_result->m_calls == 0);
+  }
+
+  SECTION("recursion") {
+    auto const program = R"(
+let
+  function fact(n : int) : int = if n = 0 then 1 else n * fact(n - 1)
+in
+  fact(10)
+end
+)";
+    auto const interpreted = interpret(program);
+    REQUIRE(interpreted.m_result);
+    CHECK(interpreted.m_result->m_value == 3628800);
+    CHECK(interpreted.m_result->m_calls == 11);
+  }
+
+  SECTION("stack arguments") {
+    auto const program = R"(
+let
+  function f(a : int, b : int, c : int, d : int, e : int, g : int) : int =
+    a - b + c - d + e * g
+in
+  f(1, 2, 3, 4, 5, 6)
+end
+)";
+    auto const interpreted = interpret(program);
+    REQUIRE(interpreted.m_result);
+    CHECK(interpreted.m_result->m_value == 28);
+  }
+
+  SECTION("escaping variable") {
+    auto const program = R"(
+let
+  var a := 1
+  function get() : int = a
+in
+  a := a + 1;
+  get()
+end
+)";
+    auto const interpreted = interpret(program);
+    REQUIRE(interpreted.m_result);
+    CHECK(interpreted.m_result->m_value == 2);
+    CHECK(interpreted.m_result->m_memoryAccesses > 0);
+  }
+
+  SECTION("records and arrays") {
+    auto const program = R"(
+let
+  type arrtype = array of int
+  type list = {head : int, tail : list}
+  var arr := arrtype [10] of 3
+  var l := list{head = 1, tail = list{head = 2, tail = nil}}
+in
+  arr[2] := 5;
+  arr[2] + arr[9] + l.head + l.tail.head * 10
+end
+)";
+    auto const interpreted = interpret(program);
+    REQUIRE(interpreted.m_result);
+    CHECK(interpreted.m_result->m_value == 29);
+  }
+
+  SECTION("strings") {
+    auto const program = R"(
+let
+  var s := concat("abc", "def")
+in
+  print(substring(s, 2, 3));
+  print(chr(ord("A") + size(s)));
+  print(getchar());
+  if s = "abcdef" & s < "abd" then 1 else 0
+end
+)";
+    auto const interpreted = interpret(program, "x");
+    REQUIRE(interpreted.m_result);
+    CHECK(interpreted.m_result->m_value == 1);
+    CHECK(interpreted.m_output == "cdeGx");
+  }
+
+  SECTION("exit") {
+    auto const interpreted =
+      interpret(R"(print("before"); exit(3); print("after"); 0)");
+    REQUIRE(interpreted.m_result);
+    CHECK(interpreted.m_result->m_value == 3);
+    CHECK(interpreted.m_output == "before");
+  }
+
+  SECTION("nil access") {
+    auto const program = R"(
+let
+  type list = {head : int, tail : list}
+  var l : list := nil
+in
+  l.head
+end
+)";
+    CHECK_FALSE(interpret(program).m_result);
+  }
+
+  SECTION("loop costs") {
+    auto const loop = [](int iterations) {
+      return "let var a := 0 in for i := 1 to " + std::to_string(iterations)
+             + " do a := a + i; a end";
+    };
+    auto const perIteration = statements(loop(20)) - statements(loop(10));
+    CHECK(perIteration > 0);
+    CHECK(statements(loop(30)) - statements(loop(20)) == perIteration);
+  }
+
+  SECTION("failure") { CHECK_FALSE(interpret("1 + nil").m_result); }
+}
+
+TEST_CASE("interpreted optimizations") {
+  tiger::CompileOptions optimizations;
+  optimizations.m_inline              = true;
+  optimizations.m_tailCalls           = true;
+  optimizations.m_simplify            = true;
+  optimizations.m_constantPropagation = true;
+  optimizations.m_loopInvariantMotion = true;
+  optimizations.m_strengthReduction   = true;
+  optimizations.m_valueNumbering      = true;
+  optimizations.m_commutation         = true;
+
+  // the ways of reaching outer frames, each with the optimizations
+  std::vector<std::pair<std::string, tiger::CompileOptions>> configurations{
+    {"static links", optimizations},
+    {"lambda lifting", optimizations},
+    {"display", optimizations},
+    {"precise escapes", optimizations}};
+  configurations[1].second.m_lambdaLifting  = true;
+  configurations[2].second.m_display        = true;
+  configurations[3].second.m_preciseEscapes = true;
+
+  tiger::forEachTigerTest(
+    [&](const boost::filesystem::path &filepath, bool parseError,
+        bool compilationError) {
+      // the mutually recursive functions of these never return
+      auto const filename = filepath.filename().string();
+      if (parseError || compilationError || filename == "test6.tig"
+          || filename == "test7.tig") {
+        return;
+      }
+
+      SECTION(filename) {
+        std::istringstream in;
+        std::ostringstream out;
+        auto const expected =
+          tiger::interpretFile(arch, filepath.string(), in, out);
+        REQUIRE(expected);
+        for (const auto &configuration : configurations) {
+          INFO(configuration.first);
+          std::istringstream optimizedIn;
+          std::ostringstream optimizedOut;
+          auto const actual =
+            tiger::interpretFile(arch, filepath.string(), optimizedIn,
+                                 optimizedOut, configuration.second);
+          REQUIRE(actual);
+          CHECK(actual->m_value == expected->m_value);
+          CHECK(optimizedOut.str() == out.str());
+        }
+      }
+    });
+}
@@ -0,0 +1,190 @@
+#include "Program.h"
+#include <boost/optional.hpp>
+#include <boost/optional/optional_io.hpp>
+#include <catch/catch.hpp>
+#include <sstream>
+
+extern std::string arch;
+
+namespace {
+using Word = tiger::RunResult::value_type;
+
+#if defined(__linux__) && defined(__x86_64__)
+constexpr bool canRun = true;
+#else
+constexpr bool canRun = false;
+#endif
+
+// the value of the program, or nothing if it didn't run, and what it printed
+std::pair<tiger::RunResult, std::string>
+  run(const std::string &program, const std::string &input = {},
+      const tiger::CompileOptions &options = {}) {
+  std::istringstream in{input};
+  std::ostringstream out;
+  auto const result = tiger::run(arch, program, in, out, options);
+  return {result, out.str()};
+}
+} // namespace
+
+TEST_CASE("jit") {
+  if (arch != "x64" || !canRun) {
+    CHECK_FALSE(run("1 + 2").first);
+    return;
+  }
+
+  SECTION("value") { CHECK(run("1 + 2 * 3").first == Word{7}); }
+
+  SECTION("arithmetic") {
+    CHECK(run("let var a := 17 var b := 5 in (a - b) * (a / b) end").first
+          == Word{36});
+  }
+
+  SECTION("recursion") {
+    auto const program = R"(
+let
+  function fact(n : int) : int = if n = 0 then 1 else n * fact(n - 1)
+in
+  fact(10)
+end
+)";
+    CHECK(run(program).first == Word{3628800});
+  }
+
+  SECTION("nested functions") {
+    auto const program = R"(
+let
+  var total := 0
+  function add(n : int) =
+    let
+      function addTo(m : int) = total := total + m
+    in
+      addTo(n)
+    end
+in
+  for i := 1 to 10 do add(i);
+  total
+end
+)";
+    CHECK(run(program).first == Word{55});
+  }
+
+  SECTION("stack arguments") {
+    auto const program = R"(
+let
+  function f(a : int, b : int, c : int, d : int, e : int, g : int) : int =
+    a - b + c - d + e * g
+in
+  f(1, 2, 3, 4, 5, 6)
+end
+)";
+    CHECK(run(program).first == Word{28});
+  }
+
+  SECTION("array") {
+    auto const program = R"(
+let
+  type arrtype = array of int
+  var arr := arrtype [10] of 3
+in
+  arr[2] := 5;
+  arr[2] + arr[9]
+end
+)";
+    CHECK(run(program).first == Word{8});
+  }
+
+  SECTION("record") {
+    auto const program = R"(
+let
+  type list = {head : int, tail : list}
+  var l := list{head = 1, tail = list{head = 2, tail = nil}}
+in
+  l.head + l.tail.head * 10
+end
+)";
+    CHECK(run(program).first == Word{21});
+  }
+
+  SECTION("print") {
+    auto const result = run(R"(print("hello\n"); flush())");
+    CHECK(result.first);
+    CHECK(result.second == "hello\n");
+  }
+
+  SECTION("strings") {
+    auto const program = R"(
+let
+  var s := concat("abc", "def")
+in
+  print(substring(s, 2, 3));
+  print(chr(ord("A") + size(s)));
+  if s = "abcdef" & s < "abd" then 1 else 0
+end
+)";
+    auto const result = run(program);
+    CHECK(result.first == Word{1});
+    CHECK(result.second == "cdeG");
+  }
+
+  SECTION("input") {
+    auto const program = R"(
+let
+  var c := getchar()
+in
+  while c <> "" do (print(c); print(c); c := getchar());
+  not(0)
+end
+)";
+    auto const result = run(program, "xyz");
+    CHECK(result.first == Word{1});
+    CHECK(result.second == "xxyyzz");
+  }
+
+  SECTION("exit") {
+    auto const result = run(R"(print("before"); exit(3); print("after"); 0)");
+    CHECK(result.first == Word{3});
+    CHECK(result.second == "before");
+  }
+
+  SECTION("runtime error") {
+    auto const result = run(R"(substring("abc", 2, 5))");
+    CHECK(result.first == Word{1});
+    CHECK(result.second == "substring([3],2,5) out of range\n");
+  }
+
+  SECTION("options") {
+    tiger::CompileOptions options;
+    options.m_inline        = true;
+    options.m_tailCalls     = true;
+    options.m_lambdaLifting = true;
+    auto const program      = R"(
+let
+  function sum(n : int, acc : int) : int =
+    if n = 0 then acc else sum(n - 1, acc + n)
+in
+  print("sum");
+  sum(100, 0)
+end
+)";
+    auto const result = run(program, {}, options);
+    CHECK(result.first == Word{5050});
+    CHECK(result.second == "sum");
+  }
+
+  SECTION("sibling calls") {
+    tiger::CompileOptions options;
+    options.m_tailCalls = true;
+    auto const program  = R"(
+let
+  function isEven(n : int) : int = if n = 0 then 1 else isOdd(n - 1)
+  function isOdd(n : int) : int = if n = 0 then 0 else isEven(n - 1)
+in
+  isEven(1000000)
+end
+)";
+    // deeper than the stack holds unless every jump leaves the frame
+    CHECK(run(program, {}, options).first == Word{1});
+  }
+
+  SECTION("failure") { CHECK_FALSE(run("1 + nil").first); }
+}
@@ -0,0 +1,87 @@
+#include "Test.h"
+
+TEST_CASE_METHOD(TestFixture, "lambda lifting") {
+  auto const options = optionsWith(&tiger::CompileOptions::m_lambdaLifting);
+  // a function passing its own frame as the static link
+  std::string const passesFrame =
+    arch == "m68k" ? "MOVE A6, +(A7)" : "mov RCX, RBP";
+
+  SECTION("no outer variables") {
+    auto const program = R"(
+let
+  function add(a : int, b : int) : int = a + b
+in
+  add(1, 2)
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK_FALSE(contains(results, passesFrame));
+    CHECK(memoryAccesses(results) == (arch == "m68k" ? 10 : 1));
+  }
+
+  SECTION("outer variable") {
+    // get still reaches n through its static link
+    auto const program = R"(
+let
+  var n := 1
+  function get() : int = n
+in
+  get()
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK(occurrences(results, passesFrame) == 1);
+    CHECK(memoryAccesses(results) == (arch == "m68k" ? 8 : 5));
+  }
+
+  SECTION("through a callee") {
+    // twice needs the static link to pass on to get
+    auto const program = R"(
+let
+  var n := 1
+  function get() : int = n
+  function twice() : int = get() + get()
+in
+  twice()
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK(occurrences(results, passesFrame) == 1);
+    CHECK(occurrences(results, call()) == 3);
+    CHECK(memoryAccesses(results) == (arch == "m68k" ? 14 : 8));
+  }
+
+  SECTION("nested function") {
+    // g uses the frame of f but f doesn't use the frame of main
+    auto const program = R"(
+let
+  function f(x : int) : int =
+    let
+      function g() : int = x
+    in
+      g()
+    end
+in
+  f(1)
+end
+)";
+    auto const results = checkedCompile(program, options);
+    // only f passes its frame, to g
+    CHECK(occurrences(results, passesFrame) == 1);
+    CHECK(memoryAccesses(results) == (arch == "m68k" ? 10 : 5));
+  }
+
+  SECTION("library call") {
+    auto const program = R"(
+let
+  function hello() = print("hello")
+in
+  hello()
+end
+)";
+    auto const results = checkedCompile(program, options);
+    // print ignores its static link, so hello doesn't need one
+    CHECK_FALSE(contains(results, passesFrame));
+    CHECK(memoryAccesses(results) == (arch == "m68k" ? 4 : 1));
+  }
+}
@@ -0,0 +1,93 @@
+#include "Test.h"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+// number of memory accesses inside loops
+std::ptrdiff_t loopMemoryAccesses(const tiger::CompileResults &results) {
+  auto const access = arch == "m68k" ? '(' : '[';
+  std::istringstream assembly{results.m_assembly};
+  std::string line;
+  std::ptrdiff_t count = 0;
+  for (const auto &depths : results.m_loopDepths) {
+    for (auto depth : depths) {
+      std::getline(assembly, line);
+      if (depth > 0) {
+        count += std::count(line.begin(), line.end(), access);
+      }
+    }
+  }
+  return count;
+}
+} // namespace
+
+TEST_CASE_METHOD(TestFixture, "loop invariant motion") {
+  auto const options =
+    optionsWith(&tiger::CompileOptions::m_loopInvariantMotion);
+
+  SECTION("outer variable") {
+    // n is read through the static link once, before the loop
+    auto const program = R"(
+let
+  var n := 10
+  function f() : int =
+    let
+      var s := 0
+      var i := 0
+    in
+      while i < n do (s := s + n; i := i + 1);
+      s
+    end
+in
+  f()
+end
+)";
+    CHECK(loopMemoryAccesses(checkedCompile(program)) == 4);
+    CHECK(loopMemoryAccesses(checkedCompile(program, options)) == 0);
+  }
+
+  SECTION("nested loops") {
+    auto const program = R"(
+let
+  var n := 10
+  function f() : int =
+    let
+      var s := 0
+    in
+      for i := 0 to n do
+        for j := 0 to n do
+          s := s + n;
+      s
+    end
+in
+  f()
+end
+)";
+    // only s is left, it is read and written in the inner loop
+    CHECK(loopMemoryAccesses(checkedCompile(program)) == 6);
+    CHECK(loopMemoryAccesses(checkedCompile(program, options)) == 2);
+  }
+
+  SECTION("call in loop") {
+    // the call may change n
+    auto const program = R"(
+let
+  var n := 10
+  function g() = n := n - 1
+  function f() : int =
+    let
+      var i := 0
+    in
+      while i < n do (g(); i := i + 1);
+      i
+    end
+in
+  f()
+end
+)";
+    // n and the static link are read on every iteration, m68k also pushes
+    // the static link on the stack
+    CHECK(loopMemoryAccesses(checkedCompile(program, options))
+          == (arch == "m68k" ? 4 : 3));
+  }
+}
@@ -0,0 +1,117 @@
+#include "LoopAnalyser.h"
+#include "Test.h"
+#include <algorithm>
+
+using tiger::LoopAnalyser;
+
+TEST_CASE("dominators") {
+  SECTION("diamond") {
+    //   0
+    //  / \
+    // 1   2
+    //  \ /
+    //   3
+    LoopAnalyser const analyser{{{1, 2}, {3}, {3}, {}}};
+    CHECK(analyser.immediateDominator(0) == size_t{0});
+    CHECK(analyser.immediateDominator(1) == size_t{0});
+    CHECK(analyser.immediateDominator(2) == size_t{0});
+    CHECK(analyser.immediateDominator(3) == size_t{0});
+    CHECK(analyser.dominates(0, 3));
+    CHECK_FALSE(analyser.dominates(1, 3));
+    CHECK(analyser.dominates(3, 3));
+    CHECK(analyser.loops().empty());
+  }
+
+  SECTION("unreachable") {
+    LoopAnalyser const analyser{{{1}, {}, {1}}};
+    CHECK(analyser.isReachable(1));
+    CHECK_FALSE(analyser.isReachable(2));
+    CHECK_FALSE(analyser.immediateDominator(2));
+    CHECK_FALSE(analyser.dominates(2, 1));
+  }
+}
+
+TEST_CASE("natural loops") {
+  SECTION("nested") {
+    // 0 -> 1 -> 2 -> 3 -> 2, 3 -> 4 -> 1, 4 -> 5
+    LoopAnalyser const analyser{{{1}, {2}, {3}, {2, 4}, {1, 5}, {}}};
+    REQUIRE(analyser.loops().size() == 2);
+    auto const &outer = analyser.loops()[0];
+    auto const &inner = analyser.loops()[1];
+    CHECK(outer.m_header == 1);
+    CHECK(outer.m_nodes == LoopAnalyser::Nodes{1, 2, 3, 4});
+    CHECK_FALSE(outer.m_parent);
+    CHECK(inner.m_header == 2);
+    CHECK(inner.m_nodes == LoopAnalyser::Nodes{2, 3});
+    CHECK(inner.m_parent == size_t{0});
+    CHECK(analyser.loopDepth(0) == 0);
+    CHECK(analyser.loopDepth(1) == 1);
+    CHECK(analyser.loopDepth(3) == 2);
+    CHECK(analyser.loopDepth(5) == 0);
+    CHECK(analyser.innermostLoop(3) == size_t{1});
+  }
+
+  SECTION("deeply nested") {
+    // header i jumps to header i + 1 or exits to the latch of loop i - 1
+    constexpr size_t depth = 1000;
+    LoopAnalyser::Successors successors(2 * depth + 1);
+    for (size_t i = 0; i < depth; ++i) {
+      successors[i]                 = {i + 1};
+      successors[2 * depth - i - 1] = {i, 2 * depth - i};
+    }
+    LoopAnalyser const analyser{successors};
+    CHECK(analyser.loops().size() == depth);
+    CHECK(analyser.loopDepth(depth) == depth);
+    CHECK(analyser.loopDepth(2 * depth) == 0);
+    CHECK(analyser.dominates(depth - 1, depth));
+  }
+
+  SECTION("long chain") {
+    constexpr size_t length = 200000;
+    LoopAnalyser::Successors successors(length);
+    for (size_t i = 0; i + 1 < length; ++i) {
+      successors[i] = {i + 1};
+    }
+    successors.back() = {0};
+    LoopAnalyser const analyser{successors};
+    REQUIRE(analyser.loops().size() == 1);
+    CHECK(analyser.loops().front().m_nodes.size() == length);
+    CHECK(analyser.immediateDominator(length - 1) == length - 2);
+  }
+}
+
+TEST_CASE_METHOD(TestFixture, "loop depth") {
+  auto const maxDepth = [](const tiger::CompileResults &results) {
+    size_t res = 0;
+    for (const auto &depths : results.m_loopDepths) {
+      if (!depths.empty()) {
+        res = std::max(res, *std::max_element(depths.begin(), depths.end()));
+      }
+    }
+    return res;
+  };
+
+  constexpr size_t depth = 30;
+
+  SECTION("while") {
+    std::string program = "let var a := 0 in ";
+    for (size_t i = 0; i < depth; ++i) {
+      program += "while a < 10 do (a := a + 1; ";
+    }
+    program += "a := a + 1" + std::string(depth, ')') + " end";
+    CHECK(maxDepth(checkedCompile(program)) == depth);
+  }
+
+  SECTION("for") {
+    std::string program;
+    for (size_t i = 0; i < depth; ++i) {
+      program += "for i" + std::to_string(i) + " := 0 to 10 do ";
+    }
+    program += "()";
+    CHECK(maxDepth(checkedCompile(program)) == depth);
+  }
+
+  SECTION("no loops") {
+    CHECK(maxDepth(checkedCompile("let var a := 1 in a + 2 end")) == 0);
+  }
+}
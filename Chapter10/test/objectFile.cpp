@@ -0,0 +1,98 @@
+#include "Program.h"
+#include "testsHelper.h"
+#include <catch/catch.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+extern std::string arch;
+
+namespace {
+namespace fs = boost::filesystem;
+
+bool succeeds(const std::string &command) {
+  return std::system(command.c_str()) == 0;
+}
+
+// the output of a tool run on an object, without the lines naming the file.
+// labels are numbered differently on every compilation, so only the bytes of
+// the code and the relocations of the labels it doesn't define are compared
+std::string inspect(const std::string &command, const fs::path &object) {
+  auto const output = fs::path{object}.replace_extension(".txt");
+  REQUIRE(succeeds(command + ' ' + object.string() + " > " + output.string()));
+  std::ifstream in{output.string(), std::ios::binary};
+  std::string line;
+  while (std::getline(in, line) && line.find(object.string()) == line.npos) {
+  }
+  std::stringstream sst;
+  sst << in.rdbuf();
+  return sst.str();
+}
+
+// removes the directory of the test however the test ends
+struct TemporaryDirectory {
+  TemporaryDirectory() { fs::create_directories(m_path); }
+  ~TemporaryDirectory() { fs::remove_all(m_path); }
+
+  const fs::path m_path = fs::temp_directory_path() / fs::unique_path();
+};
+
+std::string code(const fs::path &object) {
+  auto const text = fs::path{object}.replace_extension(".bin");
+  REQUIRE(succeeds("objcopy -O binary -j .text " + object.string() + ' '
+                   + text.string()));
+  std::ifstream in{text.string(), std::ios::binary};
+  std::stringstream sst;
+  sst << in.rdbuf();
+  return sst.str();
+}
+} // namespace
+
+TEST_CASE("object file") {
+  if (arch != "x64") {
+    std::ostringstream out;
+    CHECK_FALSE(tiger::compileObject(arch, "1 + 2", out));
+    return;
+  }
+
+  TemporaryDirectory const temporary;
+  auto const &directory = temporary.m_path;
+  auto const version = (directory / "version.txt").string();
+  if (!succeeds("as --version > " + version)
+      || !succeeds("objcopy --version > " + version)
+      || !succeeds("objdump --version > " + version)) {
+    WARN("objects are compared with the output of binutils");
+    return;
+  }
+
+  tiger::CompileOptions options;
+  options.m_runnable = true;
+  tiger::forEachTigerTest(
+    [&](const fs::path &filepath, bool parseError, bool compilationError) {
+      // the two functions named g of test39 get the same label, which the
+      // assembler rejects
+      if (parseError || compilationError
+          || filepath.filename() == "test39.tig") {
+        return;
+      }
+
+      SECTION(filepath.filename().string()) {
+        auto const name     = directory / filepath.stem();
+        auto const assembly = fs::path{name}.replace_extension(".s");
+        auto const expected = fs::path{name}.replace_extension(".as.o");
+        auto const actual   = fs::path{name}.replace_extension(".o");
+        {
+          std::ofstream out{assembly.string()};
+          out << ".intel_syntax noprefix\n.globl main\n";
+          REQUIRE(tiger::compileFile(arch, filepath.string(), out, options));
+        }
+        REQUIRE(
+          succeeds("as " + assembly.string() + " -o " + expected.string()));
+
+        REQUIRE(tiger::compileObjectFile(arch, filepath.string(),
+                                         actual.string()));
+        CHECK(code(actual) == code(expected));
+        CHECK(inspect("objdump -r", actual) == inspect("objdump -r", expected));
+      }
+    });
+}
@@ -0,0 +1,56 @@
+#include "Test.h"
+#include <numeric>
+#include <regex>
+
+namespace {
+size_t interferenceCount(const tiger::CompileResults &results) {
+  return std::accumulate(
+    results.m_interferenceGraphs.begin(), results.m_interferenceGraphs.end(),
+    size_t{0}, [](size_t count, const auto &graph) {
+      return std::accumulate(graph.begin(), graph.end(), count,
+                             [](size_t count, const auto &node) {
+                               return count + node.second.size();
+                             });
+    });
+}
+
+// the assembly with every label renamed to L, as labels are numbered anew by
+// every compilation
+std::string withoutLabels(const tiger::CompileResults &results) {
+  static const std::regex label{"L[0-9]+"};
+  return std::regex_replace(results.m_assembly, label, "L");
+}
+} // namespace
+
+TEST_CASE_METHOD(TestFixture, "order by need") {
+  auto const options = optionsWith(&tiger::CompileOptions::m_orderByNeed);
+
+  SECTION("deeper right operand") {
+    // r.b * r.c is evaluated before r.a, so r.a isn't live while it is
+    // computed, which leaves ten interferences fewer than the source order
+    auto const program = R"(
+let
+  type rec = {a : int, b : int, c : int}
+  var r := rec{a = 1, b = 2, c = 3}
+in
+  r.a * (r.b * r.c)
+end
+)";
+    CHECK(interferenceCount(checkedCompile(program, options))
+          == (arch == "m68k" ? 1188 : 892));
+  }
+
+  SECTION("balanced operands") {
+    // operands needing the same number of registers keep their order
+    auto const program = R"(
+let
+  var a := 1
+  var b := 2
+in
+  (a + b) * (b + a)
+end
+)";
+    CHECK(withoutLabels(checkedCompile(program, options))
+          == withoutLabels(checkedCompile(program)));
+  }
+}
@@ -0,0 +1,102 @@
+#include "Test.h"
+
+TEST_CASE_METHOD(TestFixture, "precise escapes") {
+  auto const options = optionsWith(&tiger::CompileOptions::m_preciseEscapes);
+
+  SECTION("nested let") {
+    // a is used from an inner scope of the same function
+    auto const program = R"(
+let
+  var a := 1
+in
+  let
+    var b := a
+  in
+    a + b
+  end
+end
+)";
+    // only the prolog accesses memory
+    CHECK(memoryAccesses(checkedCompile(program, options))
+          == (arch == "m68k" ? 2 : 1));
+  }
+
+  SECTION("read only capture") {
+    // main reads n from a register, get from the frame
+    auto const program = R"(
+let
+  var n := 10
+  function get() : int = n
+in
+  n + n + get()
+end
+)";
+    CHECK(memoryAccesses(checkedCompile(program, options))
+          == (arch == "m68k" ? 8 : 5));
+  }
+
+  SECTION("written capture") {
+    auto const program = R"(
+let
+  var n := 0
+  function inc() = n := n + 1
+in
+  inc();
+  n
+end
+)";
+    // n stays in the frame as it would without precise escapes
+    CHECK(memoryAccesses(checkedCompile(program, options))
+          == (arch == "m68k" ? 11 : 8));
+  }
+
+  SECTION("write only capture") {
+    // set has to store n in the frame of main, which reads it from there
+    auto const program = R"(
+let
+  var n := 0
+  function set() = n := 1
+in
+  set();
+  n
+end
+)";
+    CHECK(memoryAccesses(checkedCompile(program, options))
+          == (arch == "m68k" ? 9 : 6));
+  }
+
+  SECTION("loop counter") {
+    auto const program = R"(
+let
+  var sum := 0
+in
+  for i := 1 to 10 do
+    let
+      function get() : int = i
+    in
+      sum := sum + get()
+    end;
+  sum
+end
+)";
+    CHECK(memoryAccesses(checkedCompile(program, options))
+          == (arch == "m68k" ? 8 : 5));
+  }
+
+  SECTION("parameter") {
+    auto const program = R"(
+let
+  function f(x : int) : int =
+    let
+      function g() : int = x
+    in
+      x * x + g()
+    end
+in
+  f(2)
+end
+)";
+    CHECK(memoryAccesses(checkedCompile(program, options))
+          == (arch == "m68k" ? 14 : 7));
+  }
+}
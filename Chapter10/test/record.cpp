@@ -29,17 +29,20 @@ in
 end
 )");
 
-    OptReg regs[4], temps[2][4];
+    OptReg regs[6], temps[5], addressTemps[3];
     OptLabel stringLabel;
     OptIndex stringLabelIndex;
     checkProgram(
       results, checkStringInit(stringLabel, R"("hello")", stringLabelIndex), checkMain(),
       checkCall("malloc", {returnReg()}, 2 * wordSize()),
       checkMove(regs[1], returnReg()),// move result of malloc(record_size) to r
-      checkMemberAccess(regs[1], 0, regs[2], temps[0], {regs[1]}),
-      checkMove(regs[2], 2, {regs[1]}), // init first member with 2
-      checkMemberAccess(regs[1], 1, regs[3], temps[1], {regs[1]}),
-      checkMove(checkReg(regs[3]), checkString(stringLabel), {}, {regs[3]}, false,
+      checkMemberInit(regs[1], 0, 2, temps,
+                      {regs[1]}), // init first member with 2
+      checkMemberAddress(regs[1], 1, regs[4], addressTemps, {regs[1]}),
+      checkMove(checkReg(regs[5]), checkString(stringLabel), {}, {regs[5]}, false,
+                {regs[1], regs[4]}),
+      checkMove(checkMemoryAccess(checkReg(regs[4])), checkReg(regs[5]),
+                {regs[4], regs[5]}, {}, false,
                 {regs[1]}), // init second member with "hello"
       checkMove(returnReg(), regs[1]),
       branchToEnd(end, endIndex), checkFunctionExit());
@@ -0,0 +1,164 @@
+#include "Runtime.h"
+#include <boost/optional/optional_io.hpp>
+#include <catch/catch.hpp>
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+namespace {
+using Word = tiger::Runtime::Word;
+
+Word string(const char *characters) {
+  return reinterpret_cast<Word>(characters);
+}
+
+std::string characters(Word string) {
+  return reinterpret_cast<const char *>(string);
+}
+} // namespace
+
+TEST_CASE("runtime") {
+  std::istringstream in{"x"};
+  std::ostringstream out;
+  tiger::Runtime runtime{in, out};
+
+  SECTION("malloc") {
+    auto const record = reinterpret_cast<Word *>(runtime.malloc(24));
+    CHECK(reinterpret_cast<std::uintptr_t>(record) % sizeof(Word) == 0);
+    CHECK(record[0] == 0);
+    CHECK(record[2] == 0);
+    record[2]        = 5;
+    auto const other = reinterpret_cast<Word *>(runtime.malloc(1));
+    CHECK(other[0] == 0);
+    CHECK(record[2] == 5);
+
+    // larger than a chunk
+    auto const large =
+      reinterpret_cast<Word *>(runtime.malloc(tiger::Arena::MAX_CHUNK));
+    CHECK(large[tiger::Arena::MAX_CHUNK / sizeof(Word) - 1] == 0);
+  }
+
+  SECTION("initArray") {
+    auto const array   = reinterpret_cast<Word *>(runtime.malloc(5 * 8));
+    auto const element = reinterpret_cast<Word *>(runtime.malloc(16));
+    runtime.initArray(5, reinterpret_cast<Word>(element));
+    CHECK(array[0] == reinterpret_cast<Word>(element));
+    CHECK(array[4] == reinterpret_cast<Word>(element));
+    CHECK(element[0] == 0);
+  }
+
+  SECTION("strings") {
+    auto const hello = string("hello");
+    CHECK(runtime.size(hello) == 5);
+    CHECK(runtime.stringCompare(hello, hello) == 0);
+    CHECK(runtime.stringCompare(hello, string("help")) < 0);
+    CHECK(characters(runtime.concat(hello, string(" world")))
+          == "hello world");
+    CHECK(runtime.concat(hello, string("")) == hello);
+    CHECK(characters(runtime.substring(hello, 1, 3)) == "ell");
+    // suffixes and single characters aren't copied
+    CHECK(runtime.substring(hello, 2, 3) == hello + 2);
+    CHECK(runtime.substring(hello, 1, 1) == runtime.chr('e'));
+    CHECK(characters(runtime.substring(hello, 5, 0)).empty());
+    CHECK_FALSE(runtime.exitStatus());
+  }
+
+  SECTION("output") {
+    runtime.print(string("a"));
+    CHECK(out.str().empty());
+    runtime.flush();
+    CHECK(out.str() == "a");
+
+    // the output shows before reading input
+    runtime.print(string("b"));
+    CHECK(characters(runtime.getchar()) == "x");
+    CHECK(out.str() == "ab");
+
+    runtime.print(string("c"));
+    runtime.exit(2);
+    CHECK(out.str() == "abc");
+    CHECK(runtime.exitStatus() == Word{2});
+  }
+
+  SECTION("errors") {
+    runtime.substring(string("abc"), 2, 5);
+    CHECK(out.str() == "substring([3],2,5) out of range\n");
+    CHECK(runtime.exitStatus() == Word{1});
+  }
+}
+
+TEST_CASE("heap") {
+  tiger::Heap heap;
+  // the roots, as frames would hold them
+  std::vector<Word> frames(4);
+  heap.setRoots([&frames] {
+    return std::make_pair(frames.data(), frames.data() + frames.size());
+  });
+
+  // a list of n elements, which is kept in the last frame as it's built
+  auto const list = [&heap, &frames](int n) {
+    frames[3] = 0;
+    for (int i = n; i > 0; --i) {
+      auto const node = heap.allocateRecord("np");
+      node[0]         = i;
+      node[1]         = frames[3];
+      frames[3]       = reinterpret_cast<Word>(node);
+    }
+    return reinterpret_cast<Word *>(frames[3]);
+  };
+  auto const sum = [](const Word *node) {
+    Word total = 0;
+    for (; node; node = reinterpret_cast<const Word *>(node[1])) {
+      total += node[0];
+    }
+    return total;
+  };
+
+  SECTION("allocation") {
+    auto const record = heap.allocateRecord("nn");
+    CHECK(record[0] == 0);
+    CHECK(record[1] == 0);
+    auto const array = heap.allocateArray(3, 7, false);
+    CHECK(array[2] == 7);
+    CHECK(heap.collections() == 0);
+  }
+
+  SECTION("collection") {
+    // the head pins its block, the rest of the list is copied
+    auto const head = list(10000);
+    frames[0]       = reinterpret_cast<Word>(head);
+    list(10000);
+    frames[3]       = 0;
+    auto const used = heap.usedWords();
+    heap.collect();
+    CHECK(heap.collections() == 1);
+    CHECK(heap.usedWords() < used);
+    CHECK(sum(head) == 50005000);
+
+    frames[0] = 0;
+    heap.collect();
+    CHECK(heap.usedWords() == 0);
+  }
+
+  SECTION("arrays of pointers") {
+    auto const array = heap.allocateArray(100, 0, true);
+    frames[1]        = reinterpret_cast<Word>(array);
+    for (size_t i = 0; i < 100; ++i) {
+      array[i] = reinterpret_cast<Word>(list(100));
+    }
+    frames[3] = 0;
+    heap.collect();
+    for (size_t i = 0; i < 100; ++i) {
+      CHECK(sum(reinterpret_cast<const Word *>(array[i])) == 5050);
+    }
+  }
+
+  SECTION("bounded") {
+    // lists which are dropped once the next one is built
+    for (int i = 0; i < 100; ++i) {
+      CHECK(sum(list(10000)) == 50005000);
+    }
+    CHECK(heap.collections() > 0);
+    CHECK(heap.usedWords() <= 4 * tiger::Heap::MIN_THRESHOLD);
+  }
+}
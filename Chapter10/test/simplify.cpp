@@ -0,0 +1,83 @@
+#include "Test.h"
+
+TEST_CASE_METHOD(TestFixture, "simplify") {
+  auto const options = optionsWith(&tiger::CompileOptions::m_simplify);
+
+  SECTION("constant arithmetic") {
+    auto const results = checkedCompile(R"(
+let
+  var i : int := 2 * 3 + 4
+in
+  i
+end
+)",
+                                        options);
+    CHECK_FALSE(contains(results, binOp(ir::BinOp::MUL)));
+    CHECK(contains(results, arch == "m68k" ? "#10," : ", 10;"));
+  }
+
+  SECTION("record") {
+    auto const program = R"(
+let
+ type t = {a: int, b: int, c: int}
+in
+ t{a = 1, b = 2, c = 3}
+end
+)";
+    auto const results = checkedCompile(program, options);
+    // the fields are stored at constant offsets
+    CHECK_FALSE(contains(results, binOp(ir::BinOp::MUL)));
+    CHECK(contains(results, arch == "m68k" ? "MOVE #2, (#4, " : " + 8], 2"));
+    CHECK(contains(results, arch == "m68k" ? "MOVE #3, (#8, " : " + 16], 3"));
+  }
+
+  SECTION("array") {
+    auto const program = R"(
+let
+ type arrtype = array of int
+ var arr1 : arrtype := arrtype [10] of 0
+ var i := 3
+in
+ arr1[2] + arr1[i]
+end
+)";
+    auto const results = checkedCompile(program, options);
+    // constant indices are folded and the rest become shifts
+    CHECK_FALSE(contains(results, binOp(ir::BinOp::MUL)));
+    CHECK(contains(results, arch == "m68k" ? "MOVE #8, " : ", 16;"));
+    CHECK(occurrences(results, arch == "m68k" ? "LSL.L #2, " : "shl ") == 1);
+  }
+
+  SECTION("large power of 2") {
+    auto const results = checkedCompile(R"(
+let
+  var x := 5
+in
+  x * 1024
+end
+)",
+                                        options);
+    // shifting by 10 can't be encoded on every machine
+    CHECK(contains(results, binOp(ir::BinOp::MUL)));
+    CHECK_FALSE(contains(results, arch == "m68k" ? "LSL.L" : "shl"));
+  }
+
+  SECTION("constant condition") {
+    auto const program = R"(
+let
+  var a := 0
+in
+  if 1 > 2 then a := 3 else a := 4;
+  a
+end
+)";
+    auto const results = checkedCompile(program, options);
+    for (auto op : {ir::RelOp::EQ, ir::RelOp::NE, ir::RelOp::LT,
+                    ir::RelOp::GT, ir::RelOp::LE, ir::RelOp::GE}) {
+      CHECK_FALSE(contains(results, conditionalJump(op) + ' '));
+    }
+    // the dead branch is removed
+    CHECK_FALSE(contains(results, arch == "m68k" ? "#3," : ", 3;"));
+    CHECK(contains(results, arch == "m68k" ? "#4," : ", 4;"));
+  }
+}
@@ -0,0 +1,70 @@
+#include "Test.h"
+
+namespace {
+std::string shift() { return arch == "m68k" ? "LSL.L" : "shl"; }
+} // namespace
+
+TEST_CASE_METHOD(TestFixture, "strength reduction") {
+  auto const options =
+    optionsWith(&tiger::CompileOptions::m_strengthReduction);
+
+  SECTION("for loop") {
+    auto const program = R"(
+let
+  type intArray = array of int
+  var a := intArray[10] of 1
+  var s := 0
+in
+  for i := 0 to 9 do s := s + a[i];
+  s
+end
+)";
+    CHECK(loopContains(checkedCompile(program), binOp(ir::BinOp::MUL)));
+    auto const results = checkedCompile(program, options);
+    CHECK_FALSE(loopContains(results, binOp(ir::BinOp::MUL)));
+    CHECK_FALSE(loopContains(results, shift()));
+  }
+
+  SECTION("while loop") {
+    auto const program = R"(
+let
+  type intArray = array of int
+  var a := intArray[10] of 1
+  var i := 0
+in
+  while i < 10 do (a[i] := a[i] + i; i := i + 2)
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK_FALSE(loopContains(results, binOp(ir::BinOp::MUL)));
+    CHECK_FALSE(loopContains(results, shift()));
+  }
+
+  SECTION("counter changed twice") {
+    // i is not an induction variable
+    auto const program = R"(
+let
+  type intArray = array of int
+  var a := intArray[10] of 1
+  var i := 0
+in
+  while i < 10 do (a[i] := 0; i := i + 1; i := i * 2)
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK(loopContains(results, shift()));
+  }
+
+  SECTION("power of 2") {
+    auto const program = R"(
+let
+  var x := 5
+in
+  x * 8
+end
+)";
+    auto const results = checkedCompile(program, options);
+    CHECK_FALSE(contains(results, binOp(ir::BinOp::MUL)));
+    CHECK(contains(results, shift()));
+  }
+}
@@ -0,0 +1,61 @@
+#include "Test.h"
+
+TEST_CASE_METHOD(TestFixture, "tail calls") {
+  auto const options = optionsWith(&tiger::CompileOptions::m_tailCalls);
+
+  SECTION("self recursion") {
+    auto const program = R"(
+let
+  function sum(n : int, acc : int) : int =
+    if n = 0 then acc else sum(n - 1, acc + n)
+in
+  sum(100000, 0)
+end
+)";
+    CHECK(occurrences(checkedCompile(program), call()) == 2);
+    auto const results = checkedCompile(program, options);
+    // only main calls sum
+    CHECK(occurrences(results, call()) == 1);
+    CHECK(loopContains(results, binOp(ir::BinOp::PLUS)));
+  }
+
+  SECTION("procedure") {
+    auto const program = R"(
+let
+  function countdown(n : int) = if n > 0 then countdown(n - 1)
+in
+  countdown(10)
+end
+)";
+    CHECK(occurrences(checkedCompile(program, options), call()) == 1);
+  }
+
+  SECTION("not in tail position") {
+    auto const program = R"(
+let
+  function fact(n : int) : int = if n = 0 then 1 else n * fact(n - 1)
+in
+  fact(5)
+end
+)";
+    CHECK(occurrences(checkedCompile(program, options), call()) == 2);
+  }
+
+  SECTION("mutual recursion") {
+    auto const program = R"(
+let
+  function isEven(n : int) : int = if n = 0 then 1 else isOdd(n - 1)
+  function isOdd(n : int) : int = if n = 0 then 0 else isEven(n - 1)
+in
+  isEven(10)
+end
+)";
+    auto const results = checkedCompile(program, options);
+    if (arch == "m68k") {
+      // arguments are passed on the stack
+      CHECK(occurrences(results, call()) == 3);
+    } else {
+      CHECK(occurrences(results, call()) == 1);
+    }
+  }
+}
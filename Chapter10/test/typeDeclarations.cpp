@@ -26,14 +26,13 @@ let
 in
 end
 )");
-    OptReg regs[3], temps[4];
+    OptReg regs[3], temps[5];
     checkProgram(
       results, checkMain(), checkCall("malloc", {returnReg()}, wordSize()),
       checkMove(regs[0],
                 returnReg()), // move result of malloc(record_size) to base reg
-      checkMemberAccess(regs[0], 0, regs[1], temps, {regs[0]}),
-      checkMove(regs[1], 2, {regs[0]}), // init first member with 2
-      checkMove(regs[2], regs[0]),      // move base reg to r
+      checkMemberInit(regs[0], 0, 2, temps, {regs[0]}), // init first member
+      checkMove(regs[2], regs[0]), // move base reg to r
       checkMove(returnReg(), 0), branchToEnd(end, endIndex),
       checkFunctionExit());
   }
@@ -73,15 +72,15 @@ in
  intlist{hd = 3, tl = intlist{hd = 4, tl = nil}}
 end
 )");
-      OptReg regs[7], accessTemps[3][4], addressTemps[3];
+      OptReg regs[7], accessTemps[3][5], addressTemps[3];
       checkProgram(
         results, checkMain(),
         checkCall("malloc", {returnReg()}, 2 * wordSize()),
         checkMove(
           regs[0],
           returnReg()), // move result of malloc(record_size) to base reg
-        checkMemberAccess(regs[0], 0, regs[1], accessTemps[0], {regs[0]}),
-        checkMove(regs[1], 3, {regs[0]}), // init first member
+        checkMemberInit(regs[0], 0, 3, accessTemps[0],
+                        {regs[0]}), // init first member
         checkMemberAddress(regs[0], 1, regs[2], addressTemps, {regs[0]}),
         checkMove(regs[3], regs[2],
                   {regs[0], regs[3]}), // move address of second member to a register
@@ -89,13 +88,10 @@ end
         checkMove(regs[4], returnReg(),
                   {regs[0], regs[3]}), // move result of malloc(record_size)
                               // to a base register
-        checkMemberAccess(regs[4], 0, regs[5], accessTemps[1],
-                          {regs[0], regs[3], regs[4]}),
-        checkMove(regs[5], 4, {regs[0], regs[3], regs[4]}), // init first member
-        checkMemberAccess(regs[4], 1, regs[6], accessTemps[2],
-                          {regs[0], regs[3], regs[4]}),
-        checkMove(regs[6], 0,
-                  {regs[0], regs[3], regs[4]}), // init second member
+        checkMemberInit(regs[4], 0, 4, accessTemps[1],
+                        {regs[0], regs[3], regs[4]}), // init first member
+        checkMemberInit(regs[4], 1, 0, accessTemps[2],
+                        {regs[0], regs[3], regs[4]}), // init second member
         checkMove(checkMemoryAccess(checkReg(regs[3])), checkReg(regs[4]),
                   {regs[3], regs[4]}, {}, false,
                   {regs[0]}), // init second member
@@ -113,15 +109,15 @@ end
      nil}}
     end
     )");
-      OptReg regs[11], accessTemps[4][4], addressTemps[2][3];
+      OptReg regs[11], accessTemps[4][5], addressTemps[2][3];
       checkProgram(
         results, checkMain(),
         checkCall("malloc", {returnReg()}, 2 * wordSize()),
         checkMove(
           regs[0],
           returnReg()), // move result of malloc(record_size) to a base register
-        checkMemberAccess(regs[0], 0, regs[1], accessTemps[0], {regs[0]}),
-        checkMove(regs[1], 1, {regs[0]}), // init first member
+        checkMemberInit(regs[0], 0, 1, accessTemps[0],
+                        {regs[0]}), // init first member
         checkMemberAddress(regs[0], 1, regs[2], addressTemps[0], {regs[0]}),
         checkMove(regs[3], regs[2],
                   {regs[0]}), // move address of second member to a register
@@ -142,21 +138,15 @@ end
                   {regs[0], regs[3], regs[4], regs[6]}), // move result of
                                                              // malloc(record_size)
                                                              // to a register
-        checkMemberAccess(regs[7], 0, regs[8], accessTemps[1],
-                          {regs[0], regs[3], regs[4], regs[6], regs[7]}),
-        checkMove(regs[8], 2,
-          {regs[0], regs[3], regs[4], regs[6], regs[7]}), // init first member
-        checkMemberAccess(regs[7], 1, regs[9], accessTemps[2],
-                          {regs[0], regs[3], regs[4], regs[6], regs[7]}),
-        checkMove(regs[9], 0,
-          {regs[0], regs[3], regs[4], regs[6], regs[7]}), // init second member
+        checkMemberInit(regs[7], 0, 2, accessTemps[1],
+                        {regs[0], regs[3], regs[4], regs[6], regs[7]}), // init first member
+        checkMemberInit(regs[7], 1, 0, accessTemps[2],
+                        {regs[0], regs[3], regs[4], regs[6], regs[7]}), // init second member
         checkMove(checkMemoryAccess(checkReg(regs[6])), checkReg(regs[7]),
                   {regs[6], regs[7]}, {}, false,
                   {regs[0], regs[3], regs[4]}), // init first member
-        checkMemberAccess(regs[4], 1, regs[10], accessTemps[3],
-                          {regs[0], regs[3], regs[4]}),
-        checkMove(regs[10], 0,
-                  {regs[0], regs[3], regs[4]}), // init second member
+        checkMemberInit(regs[4], 1, 0, accessTemps[3],
+                        {regs[0], regs[3], regs[4]}), // init second member
         checkMove(checkMemoryAccess(checkReg(regs[3])), checkReg(regs[4]),
                   {regs[3], regs[4]}, {}, false, {regs[0]}), // init second member
         checkMove(returnReg(), regs[0]), branchToEnd(end, endIndex),
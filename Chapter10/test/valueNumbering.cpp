@@ -0,0 +1,39 @@
+#include "Test.h"
+
+TEST_CASE_METHOD(TestFixture, "value numbering") {
+  auto const options = optionsWith(&tiger::CompileOptions::m_valueNumbering);
+
+  SECTION("outer variable") {
+    // the static link and the variable are loaded once
+    auto const program = R"(
+let
+  var a := 2
+  function f() : int = a * a + a
+in
+  f()
+end
+)";
+    auto const optimized = checkedCompile(program, options);
+    // main stores a and f loads it once, at its offset in main's frame
+    CHECK(occurrences(optimized, arch == "m68k" ? "#-8," : "-16") == 2);
+    CHECK(occurrences(optimized, binOp(ir::BinOp::MUL)) == 1);
+    CHECK(memoryAccesses(optimized) == (arch == "m68k" ? 8 : 5));
+  }
+
+  SECTION("array element") {
+    auto const program = R"(
+let
+ type arrtype = array of int
+ var arr1 : arrtype := arrtype [10] of 0
+ var i := 3
+in
+ arr1[i] * arr1[i]
+end
+)";
+    auto const optimized = checkedCompile(program, options);
+    // besides sizing the array and the product, i is scaled and the element
+    // loaded once
+    CHECK(occurrences(optimized, binOp(ir::BinOp::MUL)) == 3);
+    CHECK(memoryAccesses(optimized) == (arch == "m68k" ? 6 : 2));
+  }
+}
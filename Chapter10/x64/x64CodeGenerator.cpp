@@ -40,6 +40,8 @@ CodeGenerator::CodeGenerator(frame::CallingConvention &callingConvention) :
                 {{InstructionType::MOVE, "mov `d0, `s0", {reg(Registers::RAX), 0}}, 
                 {InstructionType::OPERATION, "idiv `s0", {1}, {reg(Registers::RAX)}, {reg(Registers::RAX)}}, 
                 {InstructionType::MOVE, "mov `d0, `s0", {2, reg(Registers::RAX)}}}},
+            Pattern{ir::BinaryOperation{ir::BinOp::LSHIFT, exp(), imm()}, 
+                {{InstructionType::MOVE, "mov `d0, `s0", {2, 0}}, {InstructionType::OPERATION, "shl `d0, `i0", {2, 1}, {2}}}},
             Pattern{ir::ConditionalJump{ir::RelOp::EQ, exp(), exp(), label(), label()},
                 {{InstructionType::OPERATION, "sub `d0, `s0", {1, 0}, {1}}, {InstructionType::JUMP, "je `l0", {2, 3}}}},
             Pattern{ir::ConditionalJump{ir::RelOp::NE, exp(), exp(), label(), label()},
@@ -54,9 +56,11 @@ CodeGenerator::CodeGenerator(frame::CallingConvention &callingConvention) :
                 {{InstructionType::OPERATION, "sub `d0, `s0", {1, 0}, {1}}, {InstructionType::JUMP, "jge `l0", {2, 3}}}},
             Pattern{ir::Move{reg(), reg()}, {{InstructionType::MOVE, "mov `d0, `s0", {1, 0}}}},
             Pattern{ir::Move{exp(), reg()}, {{InstructionType::MOVE, "mov `d0, `s0", {1, 0}}}},
+            Pattern{ir::Move{label(), ir::MemoryAccess{exp()}},
+                {{InstructionType::OPERATION, "mov `d0, `l0", {2, 0}}, {InstructionType::OPERATION, "mov [`s0], `s1", {1, 2}}}},
+            Pattern{ir::Move{exp(), ir::MemoryAccess{exp()}}, {{InstructionType::OPERATION, "mov [`s0], `s1", {1, 0}}}},
             Pattern{ir::Move{imm(), exp()}, {{InstructionType::OPERATION, "mov `d0, `i0", {1, 0}}}},
             Pattern{ir::Move{label(), exp()}, {{InstructionType::OPERATION, "mov `d0, `l0", {1, 0}}}},
-            Pattern{ir::Move{exp(), ir::MemoryAccess{exp()}}, {{InstructionType::OPERATION, "mov [`s0], `s1", {1, 0}}}},
             Pattern{ir::Move{exp(), exp()}, {{InstructionType::MOVE, "mov `d0, `s0", {1, 0}}}},
             Pattern{ir::MemoryAccess{exp()}, {{InstructionType::OPERATION, "mov `d0, [`s0]", {1, 0}}}},
             Pattern{ir::Expression{imm()}, {{InstructionType::OPERATION, "mov `d0, `i0", {1, 0}}}},
@@ -73,24 +77,32 @@ CodeGenerator::CodeGenerator(frame::CallingConvention &callingConvention) :
 Instructions CodeGenerator::translateString(const temp::Label &label,
                                             const std::string &string,
                                             temp::Map & /* tempMap */) {
-  return {Label{"`l0:", label}, Operation{{".string " + escape(string)}}};
+  static const Syntax labelSyntax{"`l0:"};
+  return {Label{labelSyntax, label}, Operation{{".string " + escape(string)}}};
 }
 
 Instructions
   CodeGenerator::translateArgs(const std::vector<ir::Expression> &args,
                                const temp::Map & /*tempMap*/) const {
+  static const Syntax moveImmediate{"mov `d0, `i0"};
+  static const Syntax moveRegister{"mov `d0, `s0"};
+  static const Syntax moveLabel{"mov `d0, `l0"};
+  static const Syntax storeImmediate{"mov [`s0 + `i0], `i1"};
+  static const Syntax storeRegister{"mov [`s0 + `i0], `s1"};
+  static const Syntax storeLabel{"mov [`s0 + `i0], `l0"};
+
   namespace rv                 = ranges::view;
   auto const registerArguments = rv::zip_with(
     [](temp::Register argumentRegister, const ir::Expression &arg) {
       return helpers::match(arg)(
         [&](int i) -> Instruction {
-          return Operation{"mov `d0, `i0", {argumentRegister}, {}, {}, {i}};
+          return Operation{moveImmediate, {argumentRegister}, {}, {}, {i}};
         },
         [&](const temp::Register &reg) -> Instruction {
-          return Move{"mov `d0, `s0", {argumentRegister}, {reg}};
+          return Move{moveRegister, {argumentRegister}, {reg}};
         },
         [&](const temp::Label &label) -> Instruction {
-          return Operation{"mov `d0, `l0", {argumentRegister}, {}, {label}};
+          return Operation{moveLabel, {argumentRegister}, {}, {label}};
         },
         [](const auto & /*default*/) {
           assert(false && "Unsupported arg type");
@@ -109,19 +121,19 @@ Instructions
         return helpers::match(arg)(
           [&](int i) -> Instruction {
             return Operation{
-              "mov [`s0 + `i0], `i1", {stackPointer}, {}, {}, {frameOffset, i}};
+              storeImmediate, {}, {stackPointer}, {}, {frameOffset, i}};
           },
           [&](const temp::Register &reg) -> Instruction {
-            return Operation{"mov [`s0 + `i0], `s1",
-                             {stackPointer, reg},
+            return Operation{storeRegister,
                              {},
+                             {stackPointer, reg},
                              {},
                              {frameOffset}};
           },
           [&](const temp::Label &label) -> Instruction {
-            return Operation{"mov [`s0 + `i0], `l0",
-                             {stackPointer},
+            return Operation{storeLabel,
                              {},
+                             {stackPointer},
                              {label},
                              {frameOffset}};
           },
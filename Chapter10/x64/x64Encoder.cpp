@@ -0,0 +1,421 @@
+#include "x64Encoder.h"
+#include "variantMatch.h"
+#include "x64Registers.h"
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace tiger {
+namespace assembly {
+namespace x64 {
+
+namespace {
+
+using Bytes = std::vector<std::uint8_t>;
+
+// the number of a register in instruction encodings
+std::uint8_t number(const temp::Register &reg) {
+  using frame::x64::Registers;
+  // indexed by Registers
+  static const std::uint8_t numbers[] = {0, 2, 1, 3, 6, 7, 5, 4,
+                                         8, 9, 10, 11, 12, 13, 14, 15};
+  auto const index = static_cast<size_t>(type_safe::get(reg));
+  if (index >= sizeof(numbers)) {
+    throw std::logic_error{"Can't encode register "
+                           + std::to_string(type_safe::get(reg))};
+  }
+  return numbers[index];
+}
+
+bool fitsByte(int value) {
+  return value >= std::numeric_limits<std::int8_t>::min()
+         && value <= std::numeric_limits<std::int8_t>::max();
+}
+
+void append32(Bytes &bytes, int value) {
+  auto const u = static_cast<std::uint32_t>(value);
+  for (auto shift = 0; shift < 32; shift += 8) {
+    bytes.push_back(static_cast<std::uint8_t>(u >> shift));
+  }
+}
+
+void write32(Bytes &bytes, size_t offset, int value) {
+  auto const u = static_cast<std::uint32_t>(value);
+  for (auto i = 0; i < 4; ++i) {
+    bytes[offset + i] = static_cast<std::uint8_t>(u >> (8 * i));
+  }
+}
+
+// the REX prefix of a 64 bit operation, extending the reg and r/m fields
+void rex(Bytes &bytes, std::uint8_t reg, std::uint8_t rm) {
+  bytes.push_back(static_cast<std::uint8_t>(0x48 | ((reg >> 3) << 2)
+                                            | (rm >> 3)));
+}
+
+// the REX prefix of an operation whose size doesn't depend on it, if needed
+void optionalRex(Bytes &bytes, std::uint8_t rm) {
+  if (rm >= 8) {
+    bytes.push_back(0x41);
+  }
+}
+
+// a register r/m operand
+void registerOperand(Bytes &bytes, std::uint8_t reg, std::uint8_t rm) {
+  bytes.push_back(static_cast<std::uint8_t>(0xC0 | ((reg & 7) << 3)
+                                            | (rm & 7)));
+}
+
+// a [base + offset] r/m operand, with the shortest displacement
+void memoryOperand(Bytes &bytes, std::uint8_t reg, std::uint8_t base,
+                   int offset) {
+  // RBP and R13 can't be used without a displacement
+  auto const mod = offset == 0 && (base & 7) != 5 ? 0 : fitsByte(offset) ? 1
+                                                                          : 2;
+  bytes.push_back(static_cast<std::uint8_t>((mod << 6) | ((reg & 7) << 3)
+                                            | (base & 7)));
+  // RSP and R12 need a SIB byte
+  if ((base & 7) == 4) {
+    bytes.push_back(0x24);
+  }
+  if (mod == 1) {
+    bytes.push_back(static_cast<std::uint8_t>(offset));
+  } else if (mod == 2) {
+    append32(bytes, offset);
+  }
+}
+
+// the characters of a string literal, escaped as by CodeGenerator::escape,
+// followed by a terminating null
+void appendString(Bytes &bytes, const std::string &literal) {
+  auto const hex = [](char c) {
+    return std::isdigit(static_cast<unsigned char>(c))
+             ? c - '0'
+             : std::tolower(static_cast<unsigned char>(c)) - 'a' + 10;
+  };
+
+  // skip the quotes
+  auto const end = literal.size() - 1;
+  for (size_t i = 1; i < end; ++i) {
+    auto const c = literal[i];
+    if (c != '\\') {
+      bytes.push_back(static_cast<std::uint8_t>(c));
+      continue;
+    }
+
+    switch (auto const escaped = literal[++i]) {
+      case 'a':
+        bytes.push_back('\a');
+        break;
+      case 'b':
+        bytes.push_back('\b');
+        break;
+      case 'f':
+        bytes.push_back('\f');
+        break;
+      case 'n':
+        bytes.push_back('\n');
+        break;
+      case 'r':
+        bytes.push_back('\r');
+        break;
+      case 't':
+        bytes.push_back('\t');
+        break;
+      case 'v':
+        bytes.push_back('\v');
+        break;
+      case 'x': {
+        // all the hex digits which follow, keeping the low byte
+        unsigned value = 0;
+        while (i + 1 < end
+               && std::isxdigit(static_cast<unsigned char>(literal[i + 1]))) {
+          value = value * 16 + static_cast<unsigned>(hex(literal[++i]));
+        }
+        bytes.push_back(static_cast<std::uint8_t>(value));
+        break;
+      }
+      default:
+        bytes.push_back(static_cast<std::uint8_t>(escaped));
+        break;
+    }
+  }
+  bytes.push_back(0);
+}
+
+// the condition codes of conditional jumps
+std::uint8_t condition(const std::string &mnemonic) {
+  static const std::unordered_map<std::string, std::uint8_t> conditions{
+    {"je", 0x4}, {"jne", 0x5}, {"jl", 0xC},
+    {"jge", 0xD}, {"jle", 0xE}, {"jg", 0xF}};
+  auto const found = conditions.find(mnemonic);
+  if (found == conditions.end()) {
+    throw std::logic_error{"Can't encode " + mnemonic};
+  }
+  return found->second;
+}
+
+} // namespace
+
+void Encoder::encode(const Instructions &instructions) {
+  for (const auto &instruction : instructions) {
+    encode(instruction);
+  }
+}
+
+void Encoder::encode(const Instruction &instruction) {
+  helpers::match(instruction)(
+    [this](const Label &label) {
+      m_chunks.push_back(Chunk{Reference::DEFINITION, {}, label.m_label, 0});
+    },
+    [this](const Jump &jump) {
+      auto const syntax   = jump.m_syntax.str();
+      auto const mnemonic = syntax.substr(0, syntax.find(' '));
+      if (mnemonic == "jmp") {
+        m_chunks.push_back(Chunk{Reference::JUMP, {}, jump.m_labels[0], 0});
+      } else {
+        m_chunks.push_back(Chunk{Reference::CONDITIONAL_JUMP,
+                                 {},
+                                 jump.m_labels[0],
+                                 condition(mnemonic)});
+      }
+    },
+    [this](const auto &inst) {
+      auto const syntax = inst.m_syntax.str();
+      auto const source = [&inst](size_t i) {
+        return number(inst.m_sources[i]);
+      };
+      auto const destination = [&inst](size_t i) {
+        return number(inst.m_destinations[i]);
+      };
+      auto const immediate = [&inst](size_t i) {
+        return inst.m_immediates[i];
+      };
+      // operations of a destination and a source register
+      static const std::unordered_map<std::string, Bytes> arithmetics{
+        {"add `d0, `s0", {0x01}}, {"sub `d0, `s0", {0x29}}};
+
+      if (syntax.empty()) {
+        return;
+      }
+
+      if (syntax.compare(0, 8, ".string ") == 0) {
+        appendString(bytes(), syntax.substr(8));
+      } else if (syntax == "mov `d0, `s0") {
+        auto &b = bytes();
+        rex(b, source(0), destination(0));
+        b.push_back(0x89);
+        registerOperand(b, source(0), destination(0));
+      } else if (syntax == "mov `d0, `i0") {
+        auto &b = bytes();
+        rex(b, 0, destination(0));
+        b.push_back(0xC7);
+        registerOperand(b, 0, destination(0));
+        append32(b, immediate(0));
+      } else if (syntax == "mov `d0, [`s0 + `i0]") {
+        auto &b = bytes();
+        rex(b, destination(0), source(0));
+        b.push_back(0x8B);
+        memoryOperand(b, destination(0), source(0), immediate(0));
+      } else if (syntax == "mov [`s0 + `i0], `s1") {
+        auto &b = bytes();
+        rex(b, source(1), source(0));
+        b.push_back(0x89);
+        memoryOperand(b, source(1), source(0), immediate(0));
+      } else if (syntax == "mov qword ptr [`s0 + `i0], `i1") {
+        auto &b = bytes();
+        rex(b, 0, source(0));
+        b.push_back(0xC7);
+        memoryOperand(b, 0, source(0), immediate(0));
+        append32(b, immediate(1));
+      } else if (syntax == "lea `d0, [rip + `l0]") {
+        Bytes b;
+        rex(b, destination(0), 0);
+        b.push_back(0x8D);
+        b.push_back(static_cast<std::uint8_t>(0x05
+                                              | ((destination(0) & 7) << 3)));
+        m_chunks.push_back(
+          Chunk{Reference::ADDRESS, std::move(b), inst.m_labels[0], 0});
+      } else if (arithmetics.count(syntax) != 0) {
+        auto &b = bytes();
+        rex(b, source(0), destination(0));
+        b.insert(b.end(), arithmetics.at(syntax).begin(),
+                 arithmetics.at(syntax).end());
+        registerOperand(b, source(0), destination(0));
+      } else if (syntax == "imul `d0, `s0") {
+        auto &b = bytes();
+        rex(b, destination(0), source(0));
+        b.insert(b.end(), {0x0F, 0xAF});
+        registerOperand(b, destination(0), source(0));
+      } else if (syntax == "cmp `s0, `s1") {
+        auto &b = bytes();
+        rex(b, source(1), source(0));
+        b.push_back(0x39);
+        registerOperand(b, source(1), source(0));
+      } else if (syntax == "sub `d0, `i0") {
+        auto &b = bytes();
+        rex(b, 0, destination(0));
+        b.push_back(fitsByte(immediate(0)) ? 0x83 : 0x81);
+        registerOperand(b, 5, destination(0));
+        if (fitsByte(immediate(0))) {
+          b.push_back(static_cast<std::uint8_t>(immediate(0)));
+        } else {
+          append32(b, immediate(0));
+        }
+      } else if (syntax == "shl `d0, `i0") {
+        auto &b = bytes();
+        rex(b, 0, destination(0));
+        b.push_back(immediate(0) == 1 ? 0xD1 : 0xC1);
+        registerOperand(b, 4, destination(0));
+        if (immediate(0) != 1) {
+          b.push_back(static_cast<std::uint8_t>(immediate(0)));
+        }
+      } else if (syntax == "cqo") {
+        bytes().insert(bytes().end(), {0x48, 0x99});
+      } else if (syntax == "idiv `s0") {
+        auto &b = bytes();
+        rex(b, 0, source(0));
+        b.push_back(0xF7);
+        registerOperand(b, 7, source(0));
+      } else if (syntax == "call `l0") {
+        m_chunks.push_back(Chunk{Reference::CALL, {0xE8}, inst.m_labels[0], 0});
+      } else if (syntax == "call `s0") {
+        auto &b = bytes();
+        optionalRex(b, source(0));
+        b.push_back(0xFF);
+        registerOperand(b, 2, source(0));
+      } else if (syntax == "push `s0") {
+        auto &b = bytes();
+        optionalRex(b, source(0));
+        b.push_back(static_cast<std::uint8_t>(0x50 | (source(0) & 7)));
+      } else if (syntax == "pop `d0") {
+        auto &b = bytes();
+        optionalRex(b, destination(0));
+        b.push_back(static_cast<std::uint8_t>(0x58 | (destination(0) & 7)));
+      } else if (syntax == "ret") {
+        bytes().push_back(0xC3);
+      } else {
+        throw std::logic_error{"Can't encode " + syntax};
+      }
+    });
+}
+
+Encoder::Bytes &Encoder::bytes() {
+  if (m_chunks.empty() || m_chunks.back().m_reference != Reference::NONE) {
+    m_chunks.push_back(Chunk{Reference::NONE, {}, {}, 0});
+  }
+  return m_chunks.back().m_bytes;
+}
+
+MachineCode Encoder::finish() const {
+  // start with short jumps and lengthen those whose targets are too far,
+  // which only moves other targets further away, until all of them fit
+  std::vector<bool> isShort(m_chunks.size(), true);
+  std::vector<size_t> offsets(m_chunks.size());
+  std::unordered_map<temp::Label, size_t> labels;
+  auto const size = [&](size_t i) -> size_t {
+    auto const &chunk = m_chunks[i];
+    switch (chunk.m_reference) {
+      case Reference::JUMP:
+        return isShort[i] ? 2 : 5;
+      case Reference::CONDITIONAL_JUMP:
+        return isShort[i] ? 2 : 6;
+      case Reference::ADDRESS:
+      case Reference::CALL:
+        return chunk.m_bytes.size() + 4;
+      default:
+        return chunk.m_bytes.size();
+    }
+  };
+
+  for (auto changed = true; changed;) {
+    size_t offset = 0;
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+      offsets[i] = offset;
+      if (m_chunks[i].m_reference == Reference::DEFINITION) {
+        labels[m_chunks[i].m_label] = offset;
+      }
+      offset += size(i);
+    }
+
+    changed = false;
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+      auto const reference = m_chunks[i].m_reference;
+      if ((reference == Reference::JUMP
+           || reference == Reference::CONDITIONAL_JUMP)
+          && isShort[i]) {
+        auto const target = labels.find(m_chunks[i].m_label);
+        if (target == labels.end()
+            || !fitsByte(static_cast<int>(target->second)
+                         - static_cast<int>(offsets[i] + 2))) {
+          isShort[i] = false;
+          changed    = true;
+        }
+      }
+    }
+  }
+
+  MachineCode res;
+  // a 32 bit offset from the end of the instruction to the label
+  auto const relative32 = [&](const temp::Label &label, RelocationType type) {
+    auto const field = res.m_code.size();
+    append32(res.m_code, 0);
+    auto const target = labels.find(label);
+    if (target == labels.end()) {
+      res.m_relocations.push_back(MachineCode::Relocation{field, label, type,
+                                                          -4});
+    } else {
+      write32(res.m_code, field,
+              static_cast<int>(target->second) - static_cast<int>(field + 4));
+    }
+  };
+
+  for (size_t i = 0; i < m_chunks.size(); ++i) {
+    auto const &chunk = m_chunks[i];
+    auto &code        = res.m_code;
+    switch (chunk.m_reference) {
+      case Reference::NONE:
+        code.insert(code.end(), chunk.m_bytes.begin(), chunk.m_bytes.end());
+        break;
+      case Reference::DEFINITION:
+        res.m_symbols.push_back(MachineCode::Symbol{chunk.m_label, offsets[i]});
+        break;
+      case Reference::ADDRESS:
+        code.insert(code.end(), chunk.m_bytes.begin(), chunk.m_bytes.end());
+        relative32(chunk.m_label, RelocationType::PC32);
+        break;
+      case Reference::CALL:
+        code.insert(code.end(), chunk.m_bytes.begin(), chunk.m_bytes.end());
+        relative32(chunk.m_label, RelocationType::PLT32);
+        break;
+      case Reference::JUMP:
+      case Reference::CONDITIONAL_JUMP: {
+        auto const conditional =
+          chunk.m_reference == Reference::CONDITIONAL_JUMP;
+        if (isShort[i]) {
+          code.push_back(conditional ? static_cast<std::uint8_t>(
+                                         0x70 | chunk.m_condition)
+                                     : 0xEB);
+          code.push_back(static_cast<std::uint8_t>(
+            static_cast<int>(labels.at(chunk.m_label))
+            - static_cast<int>(offsets[i] + 2)));
+        } else {
+          if (conditional) {
+            code.insert(code.end(),
+                        {0x0F, static_cast<std::uint8_t>(0x80
+                                                         | chunk.m_condition)});
+          } else {
+            code.push_back(0xE9);
+          }
+          relative32(chunk.m_label, RelocationType::PLT32);
+        }
+        break;
+      }
+    }
+  }
+  return res;
+}
+
+} // namespace x64
+} // namespace assembly
+} // namespace tiger
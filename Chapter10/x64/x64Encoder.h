@@ -0,0 +1,78 @@
+#pragma once
+#include "Assembly.h"
+#include <cstdint>
+#include <vector>
+
+namespace tiger {
+namespace assembly {
+namespace x64 {
+
+enum class RelocationType {
+  // a 32 bit offset relative to the relocated field
+  PC32,
+  // the same, through the procedure linkage table when the target is shared
+  PLT32
+};
+
+// the encoded instructions of all fragments, with the labels they define and
+// the places referring to labels which aren't defined
+struct MachineCode {
+  struct Symbol {
+    temp::Label m_label;
+    size_t m_offset;
+  };
+
+  struct Relocation {
+    size_t m_offset;
+    temp::Label m_label;
+    RelocationType m_type;
+    int m_addend;
+  };
+
+  std::vector<std::uint8_t> m_code;
+  std::vector<Symbol> m_symbols;
+  std::vector<Relocation> m_relocations;
+};
+
+// encodes the instructions made runnable by Lowering into machine code, the
+// same as an assembler would encode their text
+class Encoder {
+public:
+  void encode(const Instructions &instructions);
+
+  // lays out the code, making jumps as short as their targets allow, and
+  // resolves the labels
+  MachineCode finish() const;
+
+private:
+  using Bytes = std::vector<std::uint8_t>;
+
+  enum class Reference {
+    NONE,
+    // the label is defined here
+    DEFINITION,
+    // a 32 bit offset to the label ends the instruction
+    ADDRESS,
+    CALL,
+    // jumps are relaxed to their short form when possible
+    JUMP,
+    CONDITIONAL_JUMP
+  };
+
+  struct Chunk {
+    Reference m_reference;
+    Bytes m_bytes;
+    temp::Label m_label;
+    std::uint8_t m_condition;
+  };
+
+  void encode(const Instruction &instruction);
+
+  Bytes &bytes();
+
+  std::vector<Chunk> m_chunks;
+};
+
+} // namespace x64
+} // namespace assembly
+} // namespace tiger
@@ -58,6 +58,8 @@ VariableAccess Frame::allocateLocal(bool escapes) {
   return InReg{m_tempMap.newTemp()};
 }
 
+int Frame::nextLocalOffset() const { return m_frameOffset; }
+
 } // namespace x64
 } // namespace frame
 } // namespace tiger
@@ -22,6 +22,9 @@ public:
 
   virtual VariableAccess allocateLocal(bool escapes) override;
 
+  // the offset of the next local to be allocated in the frame
+  int nextLocalOffset() const;
+
 private:
   temp::Label m_name;
   AccessList m_formals;
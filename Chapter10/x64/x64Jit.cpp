@@ -0,0 +1,235 @@
+#include "x64Jit.h"
+#include <algorithm>
+#include <stdexcept>
+#if defined(__linux__) && defined(__x86_64__)
+#include <csetjmp>
+#include <cstring>
+#include <sys/mman.h>
+#include <unordered_map>
+#endif
+
+namespace tiger {
+namespace assembly {
+namespace x64 {
+
+void Jit::addFragment(const Instructions &instructions) {
+  m_encoder.encode(instructions);
+}
+
+#if defined(__linux__) && defined(__x86_64__)
+
+namespace {
+using Word = Runtime::Word;
+
+// the runtime of the program running on this thread and where exit returns to
+thread_local Runtime *t_runtime  = nullptr;
+thread_local std::jmp_buf *t_exit = nullptr;
+
+// leaves the program once the runtime ended it. only generated code, which
+// has nothing to destroy, is skipped on the way
+Word proceed(Word result) {
+  if (t_runtime->exitStatus()) {
+    std::longjmp(*t_exit, 1);
+  }
+  return result;
+}
+
+// the functions called by the program, with the generated code's calling
+// convention
+[[gnu::ms_abi]] Word runtimeMalloc(Word size) {
+  return proceed(t_runtime->malloc(size));
+}
+
+[[gnu::ms_abi]] Word runtimeInitArray(Word size, Word init) {
+  t_runtime->initArray(size, init);
+  return proceed(0);
+}
+
+[[gnu::ms_abi]] Word runtimeAllocRecord(Word descriptor) {
+  return proceed(t_runtime->allocRecord(descriptor));
+}
+
+[[gnu::ms_abi]] Word runtimeAllocArray(Word size, Word init, Word pointers) {
+  return proceed(t_runtime->allocArray(size, init, pointers));
+}
+
+[[gnu::ms_abi]] Word runtimeStringCompare(Word lhs, Word rhs) {
+  return proceed(t_runtime->stringCompare(lhs, rhs));
+}
+
+[[gnu::ms_abi]] Word runtimePrint(Word /* staticLink */, Word string) {
+  t_runtime->print(string);
+  return proceed(0);
+}
+
+[[gnu::ms_abi]] Word runtimeFlush(Word /* staticLink */) {
+  t_runtime->flush();
+  return proceed(0);
+}
+
+[[gnu::ms_abi]] Word runtimeGetchar(Word /* staticLink */) {
+  return proceed(t_runtime->getchar());
+}
+
+[[gnu::ms_abi]] Word runtimeOrd(Word /* staticLink */, Word string) {
+  return proceed(t_runtime->ord(string));
+}
+
+[[gnu::ms_abi]] Word runtimeChr(Word /* staticLink */, Word i) {
+  return proceed(t_runtime->chr(i));
+}
+
+[[gnu::ms_abi]] Word runtimeSize(Word /* staticLink */, Word string) {
+  return proceed(t_runtime->size(string));
+}
+
+[[gnu::ms_abi]] Word runtimeSubstring(Word /* staticLink */, Word string,
+                                      Word first, Word n) {
+  return proceed(t_runtime->substring(string, first, n));
+}
+
+[[gnu::ms_abi]] Word runtimeConcat(Word /* staticLink */, Word lhs,
+                                   Word rhs) {
+  return proceed(t_runtime->concat(lhs, rhs));
+}
+
+[[gnu::ms_abi]] Word runtimeNot(Word /* staticLink */, Word i) {
+  return proceed(t_runtime->not_(i));
+}
+
+[[gnu::ms_abi]] Word runtimeExit(Word /* staticLink */, Word status) {
+  t_runtime->exit(status);
+  return proceed(0);
+}
+
+const std::unordered_map<std::string, std::uintptr_t> &runtimeFunctions() {
+  auto const address = [](auto function) {
+    return reinterpret_cast<std::uintptr_t>(function);
+  };
+  static const std::unordered_map<std::string, std::uintptr_t> functions{
+    {"malloc", address(&runtimeMalloc)},
+    {"initArray", address(&runtimeInitArray)},
+    {"allocRecord", address(&runtimeAllocRecord)},
+    {"allocArray", address(&runtimeAllocArray)},
+    {"stringCompare", address(&runtimeStringCompare)},
+    {"print", address(&runtimePrint)},
+    {"flush", address(&runtimeFlush)},
+    {"getchar", address(&runtimeGetchar)},
+    {"ord", address(&runtimeOrd)},
+    {"chr", address(&runtimeChr)},
+    {"size", address(&runtimeSize)},
+    {"substring", address(&runtimeSubstring)},
+    {"concat", address(&runtimeConcat)},
+    {"not", address(&runtimeNot)},
+    {"exit", address(&runtimeExit)}};
+  return functions;
+}
+
+// jmp [rip], followed by the address of the function, padded
+constexpr std::uint8_t INDIRECT_JUMP[] = {0xFF, 0x25, 0, 0, 0, 0};
+constexpr size_t JUMP_SIZE             = 16;
+
+using Main = Word(__attribute__((ms_abi)) *)(Word);
+
+// pages holding the code, unmapped once it's done running
+class Memory {
+public:
+  explicit Memory(size_t size) :
+      m_size{std::max<size_t>(size, 1)},
+      m_address{mmap(nullptr, m_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)} {
+    if (m_address == MAP_FAILED) {
+      throw std::runtime_error{"Failed to map memory for the code"};
+    }
+  }
+
+  Memory(const Memory &) = delete;
+  Memory &operator=(const Memory &) = delete;
+
+  ~Memory() { munmap(m_address, m_size); }
+
+  std::uint8_t *data() const { return static_cast<std::uint8_t *>(m_address); }
+
+  // the code can't be changed once it can be run
+  void makeExecutable() {
+    if (mprotect(m_address, m_size, PROT_READ | PROT_EXEC) != 0) {
+      throw std::runtime_error{"Failed to make the code executable"};
+    }
+  }
+
+private:
+  size_t m_size;
+  void *m_address;
+};
+
+Word call(Main main) {
+  std::jmp_buf exit;
+  t_exit = &exit;
+  if (setjmp(exit) != 0) {
+    return *t_runtime->exitStatus();
+  }
+  // main is called with an empty static link, like the runtime's main does
+  return main(0);
+}
+} // namespace
+
+Runtime::Word Jit::run(Runtime &runtime) {
+  auto const code = m_encoder.finish();
+  auto const main = std::find_if(code.m_symbols.begin(), code.m_symbols.end(),
+                                 [](const MachineCode::Symbol &symbol) {
+                                   return symbol.m_label.get() == "main";
+                                 });
+  if (main == code.m_symbols.end()) {
+    throw std::logic_error{"The program has no main function"};
+  }
+
+  // every function of the runtime gets a jump after the code
+  auto const jumpsOffset =
+    (code.m_code.size() + JUMP_SIZE - 1) / JUMP_SIZE * JUMP_SIZE;
+  std::unordered_map<temp::Label, size_t> jumps;
+  for (const auto &relocation : code.m_relocations) {
+    if (jumps.count(relocation.m_label) == 0) {
+      jumps.emplace(relocation.m_label,
+                    jumpsOffset + JUMP_SIZE * jumps.size());
+    }
+  }
+
+  Memory memory{jumpsOffset + JUMP_SIZE * jumps.size()};
+  std::copy(code.m_code.begin(), code.m_code.end(), memory.data());
+  for (const auto &jump : jumps) {
+    auto const function = runtimeFunctions().find(jump.first.get());
+    if (function == runtimeFunctions().end()) {
+      throw std::logic_error{"Unknown runtime function " + jump.first.get()};
+    }
+    auto const destination = memory.data() + jump.second;
+    std::copy(std::begin(INDIRECT_JUMP), std::end(INDIRECT_JUMP), destination);
+    std::memcpy(destination + sizeof(INDIRECT_JUMP), &function->second,
+                sizeof(function->second));
+  }
+  // both relocation types are relative to the relocated field
+  for (const auto &relocation : code.m_relocations) {
+    auto const value = static_cast<std::int32_t>(
+      static_cast<std::int64_t>(jumps.at(relocation.m_label))
+      + relocation.m_addend - static_cast<std::int64_t>(relocation.m_offset));
+    std::memcpy(memory.data() + relocation.m_offset, &value, sizeof(value));
+  }
+  memory.makeExecutable();
+
+  t_runtime = &runtime;
+  auto const result =
+    call(reinterpret_cast<Main>(memory.data() + main->m_offset));
+  t_runtime = nullptr;
+  return result;
+}
+
+#else
+
+Runtime::Word Jit::run(Runtime & /* runtime */) {
+  throw std::logic_error{"Compiled code can only run on x64 Linux"};
+}
+
+#endif
+
+} // namespace x64
+} // namespace assembly
+} // namespace tiger
@@ -0,0 +1,25 @@
+#pragma once
+#include "Executor.h"
+#include "x64Encoder.h"
+
+namespace tiger {
+namespace assembly {
+namespace x64 {
+
+// runs the fragments from executable memory. the labels they don't define are
+// the functions of the runtime, reached through jumps appended to the code.
+// only available on x64 Linux, where the runtime is called with the Microsoft
+// calling convention the code generator uses
+class Jit final : public Executor {
+public:
+  virtual void addFragment(const Instructions &instructions) override;
+
+  virtual Runtime::Word run(Runtime &runtime) override;
+
+private:
+  Encoder m_encoder;
+};
+
+} // namespace x64
+} // namespace assembly
+} // namespace tiger
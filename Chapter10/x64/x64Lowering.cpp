@@ -0,0 +1,267 @@
+#include "x64Lowering.h"
+#include "variantMatch.h"
+#include "x64Frame.h"
+#include "x64Registers.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace tiger {
+namespace assembly {
+namespace x64 {
+
+using frame::x64::reg;
+using frame::x64::Registers;
+
+namespace {
+
+constexpr auto WORD_SIZE = 8;
+// the return address and the saved frame pointer lie between the frame
+// pointer and the arguments passed on the stack
+constexpr auto STACK_ARGUMENTS_OFFSET = 2 * WORD_SIZE;
+// callers reserve room for the arguments passed in registers
+constexpr auto SHADOW_SPACE    = 4 * WORD_SIZE;
+constexpr auto STACK_ALIGNMENT = 16;
+
+bool isTemp(const temp::Register &reg) {
+  return !temp::isMachineRegister(reg);
+}
+
+bool isConditionalJump(const Instruction &instruction) {
+  return helpers::match(instruction)(
+    [](const Jump &jump) { return jump.m_syntax.str().find("jmp") != 0; },
+    [](const auto & /*default*/) { return false; });
+}
+
+const Syntax &moveSyntax() {
+  static const Syntax syntax{"mov `d0, `s0"};
+  return syntax;
+}
+
+// the epilog up to the return, which also precedes jumps to other functions
+void restoreFrame(Instructions &instructions) {
+  static const Syntax pop{"pop `d0"};
+  auto const framePointer = reg(Registers::RBP);
+  instructions.push_back(
+    Move{moveSyntax(), {reg(Registers::RSP)}, {framePointer}});
+  instructions.push_back(Operation{pop, {framePointer}});
+}
+
+} // namespace
+
+Lowering::Lowering(const frame::x64::Frame &frame) :
+    m_frame{frame}, m_outgoingArguments{SHADOW_SPACE} {}
+
+Instructions Lowering::lower(const Instructions &body) {
+  for (const auto &instruction : body) {
+    if (auto const label = boost::get<Label>(&instruction)) {
+      m_labels.insert(label->m_label);
+    }
+  }
+  for (auto it = body.begin(); it != body.end(); ++it) {
+    auto const next = std::next(it);
+    lower(*it, next != body.end() && isConditionalJump(*next));
+  }
+
+  static const Syntax push{"push `s0"};
+  static const Syntax subtract{"sub `d0, `i0"};
+  static const Syntax ret{"ret"};
+
+  auto const slotsSize = static_cast<int>(m_slots.size()) * WORD_SIZE
+                         - m_frame.nextLocalOffset() - WORD_SIZE;
+  auto const frameSize =
+    (slotsSize + m_outgoingArguments + STACK_ALIGNMENT - 1) / STACK_ALIGNMENT
+    * STACK_ALIGNMENT;
+  auto const framePointer = reg(Registers::RBP);
+  auto const stackPointer = reg(Registers::RSP);
+
+  Instructions res;
+  res.reserve(m_instructions.size() + 6);
+  auto it = m_instructions.begin();
+  // the prolog follows the function's label
+  if (it != m_instructions.end() && helpers::hasType<Label>(*it)) {
+    res.push_back(*it++);
+  }
+  res.push_back(Operation{push, {}, {framePointer}});
+  res.push_back(Move{moveSyntax(), {framePointer}, {stackPointer}});
+  res.push_back(Operation{subtract, {stackPointer}, {}, {}, {frameSize}});
+  res.insert(res.end(), it, m_instructions.end());
+  restoreFrame(res);
+  res.push_back(Operation{ret});
+  return res;
+}
+
+void Lowering::lower(const Instruction &instruction,
+                     bool nextIsConditionalJump) {
+  static const Syntax loadAddress{"lea `d0, [rip + `l0]"};
+  static const Syntax storeImmediate{"mov qword ptr [`s0 + `i0], `i1"};
+  static const Syntax compare{"cmp `s0, `s1"};
+  static const Syntax signExtend{"cqo"};
+
+  helpers::match(instruction)(
+    [this](const Label &label) { m_instructions.push_back(label); },
+    [this](const Jump &jump) {
+      // a tail call jumps to another function, which sets up its own frame
+      if (jump.m_syntax.str().find("jmp") == 0 && !jump.m_labels.empty()
+          && m_labels.count(jump.m_labels.front()) == 0) {
+        restoreFrame(m_instructions);
+      }
+      m_instructions.push_back(jump);
+    },
+    [&](const auto &inst) {
+      auto const syntax = inst.m_syntax.str();
+      auto const scratch = reg(Registers::R11);
+      if (syntax.empty()) {
+        // the sink of live registers at exit has nothing to run
+        return;
+      }
+      if (syntax.front() == '.') {
+        m_instructions.push_back(inst);
+      } else if (syntax == "mov `d0, `s0") {
+        lowerMove(inst.m_destinations[0], inst.m_sources[0]);
+      } else if (syntax == "mov `d0, `i0" || syntax == "call `l0"
+                 || syntax == "call `s0") {
+        emit(inst);
+      } else if (syntax == "mov `d0, `l0") {
+        // the label's address, rather than the memory it points to
+        emit(Operation{loadAddress, inst.m_destinations, {}, inst.m_labels});
+      } else if (syntax == "mov `d0, [`s0]") {
+        load(inst.m_destinations[0], inst.m_sources[0], 0);
+      } else if (syntax == "mov `s0, [`s1 + `i0]") {
+        // the destination of a frame access is listed as a source
+        load(inst.m_sources[0], inst.m_sources[1], inst.m_immediates[0]);
+      } else if (syntax == "mov [`s0], `s1") {
+        store(inst.m_sources[0], 0, inst.m_sources[1]);
+      } else if (syntax == "mov [`s0 + `i0], `s1") {
+        store(inst.m_sources[0], inst.m_immediates[0], inst.m_sources[1]);
+      } else if (syntax == "mov [`s0 + `i0], `l0") {
+        emit(Operation{loadAddress, {scratch}, {}, inst.m_labels});
+        store(inst.m_sources[0], inst.m_immediates[0], scratch);
+      } else if (syntax == "mov [`s0 + `i0], `i1") {
+        reserveArgument(inst.m_sources[0], inst.m_immediates[0]);
+        emit(Operation{
+          storeImmediate, {}, inst.m_sources, {}, inst.m_immediates});
+      } else if (syntax == "sub `d0, `s0" && nextIsConditionalJump) {
+        // the jump compares the left operand, which is the source, to the
+        // right one without changing them
+        emit(
+          Operation{compare, {}, {inst.m_sources[0], inst.m_destinations[0]}});
+      } else if (syntax == "add `d0, `s0" || syntax == "sub `d0, `s0"
+                 || syntax == "imul `d0, `s0" || syntax == "shl `d0, `i0") {
+        emit(inst, true);
+      } else if (syntax == "idiv `s0") {
+        // the dividend is RDX:RAX
+        m_instructions.push_back(Operation{signExtend});
+        emit(inst);
+      } else {
+        throw std::logic_error{"Can't lower " + syntax};
+      }
+    });
+}
+
+void Lowering::lowerMove(const temp::Register &destination,
+                         const temp::Register &source) {
+  if (isTemp(source)) {
+    load(destination, reg(Registers::RBP), slot(source));
+  } else if (isTemp(destination)) {
+    store(reg(Registers::RBP), slot(destination), source);
+  } else if (destination != source) {
+    m_instructions.push_back(Move{moveSyntax(), {destination}, {source}});
+  }
+}
+
+void Lowering::load(const temp::Register &destination, temp::Register base,
+                    int offset) {
+  static const Syntax load{"mov `d0, [`s0 + `i0]"};
+  // only parameters are read relative to the stack pointer, which pointed at
+  // them when the function was called
+  if (base == reg(Registers::RSP)) {
+    base = reg(Registers::RBP);
+    offset += STACK_ARGUMENTS_OFFSET;
+  }
+  emit(Operation{load, {destination}, {base}, {}, {offset}});
+}
+
+void Lowering::store(const temp::Register &base, int offset,
+                     const temp::Register &source) {
+  static const Syntax store{"mov [`s0 + `i0], `s1"};
+  reserveArgument(base, offset);
+  emit(Operation{store, {}, {base, source}, {}, {offset}});
+}
+
+void Lowering::reserveArgument(const temp::Register &base, int offset) {
+  // stores relative to the stack pointer pass arguments
+  if (base == reg(Registers::RSP)) {
+    m_outgoingArguments = std::max(m_outgoingArguments, offset + WORD_SIZE);
+  }
+}
+
+template <typename Inst>
+void Lowering::emit(Inst instruction, bool readsDestinations) {
+  static const Syntax load{"mov `d0, [`s0 + `i0]"};
+  static const Syntax store{"mov [`s0 + `i0], `s1"};
+
+  auto const framePointer = reg(Registers::RBP);
+  auto const uses         = [&instruction](const temp::Register &reg) {
+    return std::count(instruction.m_sources.begin(),
+                      instruction.m_sources.end(), reg)
+           + std::count(instruction.m_destinations.begin(),
+                        instruction.m_destinations.end(), reg);
+  };
+  // scratch registers are caller saved and never hold arguments
+  RegisterList scratches;
+  for (auto scratch : {reg(Registers::R10), reg(Registers::R11)}) {
+    if (uses(scratch) == 0) {
+      scratches.push_back(scratch);
+    }
+  }
+
+  std::unordered_map<temp::Register, temp::Register> assigned;
+  auto const assign = [&](const temp::Register &temp, bool read) {
+    auto found = assigned.find(temp);
+    if (found == assigned.end()) {
+      if (scratches.size() == assigned.size()) {
+        throw std::logic_error{"Out of scratch registers"};
+      }
+      found = assigned.emplace(temp, scratches[assigned.size()]).first;
+      if (read) {
+        m_instructions.push_back(
+          Operation{load, {found->second}, {framePointer}, {}, {slot(temp)}});
+      }
+    }
+    return found->second;
+  };
+
+  for (auto &source : instruction.m_sources) {
+    if (isTemp(source)) {
+      source = assign(source, true);
+    }
+  }
+  Instructions stores;
+  for (auto &destination : instruction.m_destinations) {
+    if (isTemp(destination)) {
+      auto const temp = destination;
+      destination     = assign(temp, readsDestinations);
+      stores.push_back(
+        Operation{store, {}, {framePointer, destination}, {}, {slot(temp)}});
+    }
+  }
+
+  m_instructions.push_back(std::move(instruction));
+  m_instructions.insert(m_instructions.end(), stores.begin(), stores.end());
+}
+
+int Lowering::slot(const temp::Register &temp) {
+  auto const found = m_slots.find(temp);
+  if (found != m_slots.end()) {
+    return found->second;
+  }
+
+  auto const offset = m_frame.nextLocalOffset()
+                      - static_cast<int>(m_slots.size()) * WORD_SIZE;
+  m_slots.emplace(temp, offset);
+  return offset;
+}
+
+} // namespace x64
+} // namespace assembly
+} // namespace tiger
@@ -0,0 +1,65 @@
+#pragma once
+#include "Assembly.h"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace tiger {
+namespace frame {
+namespace x64 {
+class Frame;
+} // namespace x64
+} // namespace frame
+
+namespace assembly {
+namespace x64 {
+
+// turns the instructions generated for a function into instructions which can
+// be assembled and run. there is no register allocation, so every temp gets a
+// slot in the frame and is loaded into a scratch register where it's used.
+// instructions whose syntax doesn't do what the code generator means are
+// rewritten and the prolog and epilog are added
+class Lowering {
+public:
+  explicit Lowering(const frame::x64::Frame &frame);
+
+  Instructions lower(const Instructions &body);
+
+private:
+  // lowers a single instruction, nextIsConditionalJump tells a subtraction
+  // which only sets the flags for a conditional jump
+  void lower(const Instruction &instruction, bool nextIsConditionalJump);
+
+  void lowerMove(const temp::Register &destination,
+                 const temp::Register &source);
+
+  void load(const temp::Register &destination, temp::Register base,
+            int offset);
+
+  void store(const temp::Register &base, int offset,
+             const temp::Register &source);
+
+  // makes room for an argument stored at offset from base, when base is the
+  // stack pointer
+  void reserveArgument(const temp::Register &base, int offset);
+
+  // replaces the temps of instruction with scratch registers, loading the
+  // sources before it and storing the destinations after it. when
+  // readsDestinations is set, the destinations are loaded as well
+  template <typename Inst>
+  void emit(Inst instruction, bool readsDestinations = false);
+
+  // the frame pointer offset of the slot of temp
+  int slot(const temp::Register &temp);
+
+  const frame::x64::Frame &m_frame;
+  std::unordered_map<temp::Register, int> m_slots;
+  // the labels of the function, jumps elsewhere leave it
+  std::unordered_set<temp::Label> m_labels;
+  // space for arguments of called functions at the bottom of the frame
+  int m_outgoingArguments;
+  Instructions m_instructions;
+};
+
+} // namespace x64
+} // namespace assembly
+} // namespace tiger
@@ -1,5 +1,9 @@
 #include "x64Machine.h"
 #include "Tree.h"
+#include "x64Frame.h"
+#include "x64Jit.h"
+#include "x64Lowering.h"
+#include "x64ObjectWriter.h"
 #include "x64Registers.h"
 
 namespace tiger {
@@ -19,6 +23,26 @@ const assembly::CodeGenerator &Machine::codeGenerator() const {
   return m_codeGenerator;
 }
 
+assembly::Instructions
+  Machine::lowerFunction(const assembly::Instructions &body,
+                         const frame::Frame &frame) const {
+  // all the frames are created by the x64 calling convention
+  return assembly::x64::Lowering{static_cast<const frame::x64::Frame &>(frame)}
+    .lower(body);
+}
+
+std::unique_ptr<assembly::ObjectWriter> Machine::createObjectWriter() const {
+  return std::make_unique<assembly::x64::ObjectWriter>();
+}
+
+std::unique_ptr<assembly::Executor> Machine::createExecutor() const {
+#if defined(__linux__) && defined(__x86_64__)
+  return std::make_unique<assembly::x64::Jit>();
+#else
+  return nullptr;
+#endif
+}
+
 temp::PredefinedRegisters Machine::predefinedRegisters() const {
   using namespace tiger::frame::x64;
   return {{reg(Registers::RAX), "RAX"},     {reg(Registers::RDX), "RDX"},
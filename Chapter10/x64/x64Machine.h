@@ -14,6 +14,13 @@ public:
   virtual const frame::CallingConvention &callingConvention() const override;
   virtual assembly::CodeGenerator &codeGenerator() override;
   virtual const assembly::CodeGenerator &codeGenerator() const override;
+  virtual assembly::Instructions
+    lowerFunction(const assembly::Instructions &body,
+                  const frame::Frame &frame) const override;
+  virtual std::unique_ptr<assembly::ObjectWriter>
+    createObjectWriter() const override;
+  virtual std::unique_ptr<assembly::Executor>
+    createExecutor() const override;
 
 private:
   frame::x64::CallingConvention m_callingConvention;
@@ -0,0 +1,260 @@
+#include "x64ObjectWriter.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace tiger {
+namespace assembly {
+namespace x64 {
+
+namespace {
+
+// the parts of the ELF specification the object uses
+namespace elf {
+constexpr std::uint16_t ET_REL    = 1;
+constexpr std::uint16_t EM_X86_64 = 62;
+
+constexpr std::uint32_t SHT_PROGBITS = 1;
+constexpr std::uint32_t SHT_SYMTAB   = 2;
+constexpr std::uint32_t SHT_STRTAB   = 3;
+constexpr std::uint32_t SHT_RELA     = 4;
+
+constexpr std::uint64_t SHF_ALLOC      = 0x2;
+constexpr std::uint64_t SHF_EXECINSTR  = 0x4;
+constexpr std::uint64_t SHF_INFO_LINK  = 0x40;
+
+constexpr std::uint8_t STB_LOCAL  = 0;
+constexpr std::uint8_t STB_GLOBAL = 1;
+
+constexpr std::uint32_t R_X86_64_PC32  = 2;
+constexpr std::uint32_t R_X86_64_PLT32 = 4;
+
+constexpr std::uint16_t HEADER_SIZE         = 64;
+constexpr std::uint16_t SECTION_HEADER_SIZE = 64;
+constexpr std::uint64_t SYMBOL_SIZE         = 24;
+constexpr std::uint64_t RELOCATION_SIZE     = 24;
+} // namespace elf
+
+// the label of the program, called by the runtime
+const temp::Label &entry() {
+  static const temp::Label main{"main"};
+  return main;
+}
+
+// little endian bytes of the file
+class Buffer {
+public:
+  template <typename T> void put(T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      m_bytes.push_back(static_cast<char>(value >> (8 * i)));
+    }
+  }
+
+  void put(const std::string &bytes) {
+    m_bytes.insert(m_bytes.end(), bytes.begin(), bytes.end());
+  }
+
+  void align(size_t alignment) {
+    m_bytes.resize((m_bytes.size() + alignment - 1) / alignment * alignment);
+  }
+
+  size_t size() const { return m_bytes.size(); }
+
+  const std::string &bytes() const { return m_bytes; }
+
+private:
+  std::string m_bytes;
+};
+
+// the names of sections and symbols, each followed by a null
+class StringTable {
+public:
+  StringTable() : m_strings(1, '\0') {}
+
+  std::uint32_t add(const std::string &string) {
+    auto const offset = static_cast<std::uint32_t>(m_strings.size());
+    m_strings += string;
+    m_strings += '\0';
+    return offset;
+  }
+
+  const std::string &strings() const { return m_strings; }
+
+private:
+  std::string m_strings;
+};
+
+struct Section {
+  std::uint32_t m_name;
+  std::uint32_t m_type;
+  std::uint64_t m_flags;
+  std::uint64_t m_offset;
+  std::uint64_t m_size;
+  std::uint32_t m_link;
+  std::uint32_t m_info;
+  std::uint64_t m_alignment;
+  std::uint64_t m_entrySize;
+};
+
+} // namespace
+
+void ObjectWriter::addFragment(const Instructions &instructions) {
+  m_encoder.encode(instructions);
+}
+
+void ObjectWriter::write(std::ostream &out) const {
+  auto const code = m_encoder.finish();
+
+  enum SectionIndex : std::uint16_t {
+    NONE,
+    TEXT,
+    RELA_TEXT,
+    SYMTAB,
+    STRTAB,
+    SHSTRTAB,
+    NOTE_GNU_STACK,
+    SECTIONS
+  };
+
+  // local symbols come first, then the entry and the undefined labels
+  StringTable names;
+  Buffer symbols;
+  auto const addSymbol = [&](const temp::Label &label, std::uint8_t binding,
+                             std::uint16_t section, std::uint64_t value) {
+    symbols.put(names.add(label.get()));
+    symbols.put(static_cast<std::uint8_t>(binding << 4));
+    symbols.put(std::uint8_t{0});
+    symbols.put(section);
+    symbols.put(value);
+    symbols.put(std::uint64_t{0});
+  };
+  symbols.put(std::string(elf::SYMBOL_SIZE, '\0'));
+  std::uint32_t symbolCount = 1;
+  for (const auto &symbol : code.m_symbols) {
+    if (symbol.m_label != entry()) {
+      addSymbol(symbol.m_label, elf::STB_LOCAL, TEXT, symbol.m_offset);
+      ++symbolCount;
+    }
+  }
+  auto const firstGlobal = symbolCount;
+  std::unordered_map<temp::Label, std::uint32_t> globals;
+  for (const auto &symbol : code.m_symbols) {
+    if (symbol.m_label == entry()) {
+      addSymbol(symbol.m_label, elf::STB_GLOBAL, TEXT, symbol.m_offset);
+      globals.emplace(symbol.m_label, symbolCount++);
+    }
+  }
+  for (const auto &relocation : code.m_relocations) {
+    if (globals.count(relocation.m_label) == 0) {
+      addSymbol(relocation.m_label, elf::STB_GLOBAL, NONE, 0);
+      globals.emplace(relocation.m_label, symbolCount++);
+    }
+  }
+
+  Buffer relocations;
+  for (const auto &relocation : code.m_relocations) {
+    auto const type = relocation.m_type == RelocationType::PLT32
+                        ? elf::R_X86_64_PLT32
+                        : elf::R_X86_64_PC32;
+    relocations.put(static_cast<std::uint64_t>(relocation.m_offset));
+    relocations.put(
+      (static_cast<std::uint64_t>(globals.at(relocation.m_label)) << 32)
+      | type);
+    relocations.put(static_cast<std::int64_t>(relocation.m_addend));
+  }
+
+  StringTable sectionNames;
+  std::vector<Section> sections(SECTIONS, Section{});
+  for (auto const &name : {std::make_pair(TEXT, ".text"),
+                           std::make_pair(RELA_TEXT, ".rela.text"),
+                           std::make_pair(SYMTAB, ".symtab"),
+                           std::make_pair(STRTAB, ".strtab"),
+                           std::make_pair(SHSTRTAB, ".shstrtab"),
+                           std::make_pair(NOTE_GNU_STACK, ".note.GNU-stack")}) {
+    sections[name.first].m_name = sectionNames.add(name.second);
+  }
+
+  // like the assembler, only write the relocation section when it has entries
+  auto const hasRelocations = !code.m_relocations.empty();
+  auto const index = [&](SectionIndex section) {
+    return static_cast<std::uint16_t>(
+      hasRelocations || section < RELA_TEXT ? section : section - 1);
+  };
+
+  Buffer file;
+  file.put(std::string(elf::HEADER_SIZE, '\0'));
+  auto const addSection = [&](SectionIndex index, std::uint32_t type,
+                              std::uint64_t flags, const std::string &contents,
+                              std::uint64_t alignment) -> Section & {
+    file.align(alignment);
+    auto &section       = sections[index];
+    section.m_type      = type;
+    section.m_flags     = flags;
+    section.m_offset    = file.size();
+    section.m_size      = contents.size();
+    section.m_alignment = alignment;
+    file.put(contents);
+    return section;
+  };
+
+  addSection(TEXT, elf::SHT_PROGBITS, elf::SHF_ALLOC | elf::SHF_EXECINSTR,
+             std::string(code.m_code.begin(), code.m_code.end()), 16);
+  auto &relaText = addSection(RELA_TEXT, elf::SHT_RELA, elf::SHF_INFO_LINK,
+                              relocations.bytes(), 8);
+  relaText.m_link      = index(SYMTAB);
+  relaText.m_info      = TEXT;
+  relaText.m_entrySize = elf::RELOCATION_SIZE;
+  auto &symtab =
+    addSection(SYMTAB, elf::SHT_SYMTAB, 0, symbols.bytes(), 8);
+  symtab.m_link      = index(STRTAB);
+  symtab.m_info      = firstGlobal;
+  symtab.m_entrySize = elf::SYMBOL_SIZE;
+  addSection(STRTAB, elf::SHT_STRTAB, 0, names.strings(), 1);
+  addSection(SHSTRTAB, elf::SHT_STRTAB, 0, sectionNames.strings(), 1);
+  // the stack doesn't need to be executable
+  addSection(NOTE_GNU_STACK, elf::SHT_PROGBITS, 0, {}, 1);
+
+  file.align(8);
+  auto const sectionHeaders = static_cast<std::uint64_t>(file.size());
+  for (const auto &section : sections) {
+    if (!hasRelocations && &section == &relaText) {
+      continue;
+    }
+    file.put(section.m_name);
+    file.put(section.m_type);
+    file.put(section.m_flags);
+    file.put(std::uint64_t{0});
+    file.put(section.m_offset);
+    file.put(section.m_size);
+    file.put(section.m_link);
+    file.put(section.m_info);
+    file.put(section.m_alignment);
+    file.put(section.m_entrySize);
+  }
+
+  Buffer header;
+  header.put(std::string{"\x7f" "ELF"});
+  // 64 bit, little endian, current version, System V ABI
+  header.put(std::string{"\x02\x01\x01\x00", 4});
+  header.put(std::string(8, '\0'));
+  header.put(elf::ET_REL);
+  header.put(elf::EM_X86_64);
+  header.put(std::uint32_t{1});
+  header.put(std::uint64_t{0});
+  header.put(std::uint64_t{0});
+  header.put(sectionHeaders);
+  header.put(std::uint32_t{0});
+  header.put(elf::HEADER_SIZE);
+  header.put(std::uint16_t{0});
+  header.put(std::uint16_t{0});
+  header.put(elf::SECTION_HEADER_SIZE);
+  header.put(index(SECTIONS));
+  header.put(index(SHSTRTAB));
+
+  auto contents = file.bytes();
+  std::copy(header.bytes().begin(), header.bytes().end(), contents.begin());
+  out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+}
+
+} // namespace x64
+} // namespace assembly
+} // namespace tiger
@@ -0,0 +1,24 @@
+#pragma once
+#include "ObjectWriter.h"
+#include "x64Encoder.h"
+
+namespace tiger {
+namespace assembly {
+namespace x64 {
+
+// writes an ELF64 relocatable object whose .text section holds all the
+// fragments. main is global and the labels which aren't defined, like runtime
+// functions, are left for the linker
+class ObjectWriter final : public assembly::ObjectWriter {
+public:
+  virtual void addFragment(const Instructions &instructions) override;
+
+  virtual void write(std::ostream &out) const override;
+
+private:
+  Encoder m_encoder;
+};
+
+} // namespace x64
+} // namespace assembly
+} // namespace tiger